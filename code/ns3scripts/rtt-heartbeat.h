@@ -0,0 +1,156 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Progress heartbeat for long scenario runs.
+ *
+ * A Heartbeat schedules one cheap event per simulated second (Step). When
+ * at least its interval of wall clock time has passed since the last line,
+ * that event appends one line to <prefix>.heartbeat:
+ *
+ *   wall_s,sim_s,events,events_per_s,active_flows,rx_bytes,rss_mb
+ *
+ * events_per_s is measured since the previous line, active_flows counts the
+ * flows that are running and have not yet delivered all their bytes, and
+ * rx_bytes is the total received by the sinks so far. The file is flushed
+ * after every line, so that it can be followed (tail -f) or checked by a
+ * script during the run: the remaining simulated time over the recent
+ * sim_s rate gives the time to completion, and a file that stops growing
+ * points to a stalled run.
+ *
+ * This header is included by the scenarios and must sit next to them in
+ * the scratch folder.
+**/
+
+#ifndef RTT_HEARTBEAT_H
+#define RTT_HEARTBEAT_H
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+#include <unistd.h>
+#include "ns3/core-module.h"
+#include "ns3/applications-module.h"
+
+class Heartbeat
+{
+public:
+  // interval is the minimum wall time between two lines in seconds, 0 to
+  // disable the heartbeat
+  Heartbeat (std::string fileName, double interval)
+    : m_fileName (fileName),
+      m_interval (interval),
+      m_lastEvents (0)
+  {
+  }
+
+  // Adds a flow, whose sink must receive maxBytes between the start and
+  // stop times, in simulated seconds
+  void AddFlow (ns3::Ptr<ns3::Application> sink, uint64_t maxBytes, double startTime, double stopTime)
+  {
+    Flow flow;
+    flow.sink = ns3::DynamicCast<ns3::PacketSink> (sink);
+    flow.maxBytes = maxBytes;
+    flow.startTime = startTime;
+    flow.stopTime = stopTime;
+    m_flows.push_back (flow);
+  }
+
+  // Schedules the first step, to be called before Simulator::Run
+  void Start (void)
+  {
+    if (m_interval <= 0)
+    {
+      return;
+    }
+    m_file.open (m_fileName.c_str (), std::ios::out | std::ios::trunc);
+    m_file << "wall_s,sim_s,events,events_per_s,active_flows,rx_bytes,rss_mb" << std::endl;
+    m_start = std::chrono::steady_clock::now ();
+    m_last = m_start;
+    ns3::Simulator::Schedule (ns3::Seconds (1), &Heartbeat::Step, this);
+  }
+
+private:
+  struct Flow
+  {
+    ns3::Ptr<ns3::PacketSink> sink;
+    uint64_t maxBytes;
+    double startTime;
+    double stopTime;
+  };
+
+  // Runs every simulated second; only reads the clock unless a line is due
+  void Step (void)
+  {
+    ns3::Simulator::Schedule (ns3::Seconds (1), &Heartbeat::Step, this);
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now ();
+    double sinceLast = std::chrono::duration<double> (now - m_last).count ();
+    if (sinceLast < m_interval)
+    {
+      return;
+    }
+
+    double simSeconds = ns3::Simulator::Now ().GetSeconds ();
+    uint64_t events = ns3::Simulator::GetEventCount ();
+    uint32_t active = 0;
+    uint64_t rxBytes = 0;
+    for (size_t i = 0; i < m_flows.size (); i++)
+    {
+      uint64_t rx = m_flows[i].sink ? m_flows[i].sink->GetTotalRx () : 0;
+      rxBytes += rx;
+      if (m_flows[i].startTime <= simSeconds && simSeconds < m_flows[i].stopTime && rx < m_flows[i].maxBytes)
+      {
+        active++;
+      }
+    }
+
+    m_file << std::chrono::duration<double> (now - m_start).count () << ","
+           << simSeconds << ","
+           << events << ","
+           << (events - m_lastEvents) / sinceLast << ","
+           << active << ","
+           << rxBytes << ","
+           << GetRssMb () << std::endl;
+
+    m_last = now;
+    m_lastEvents = events;
+  }
+
+  // Current resident set size, or the peak where it cannot be read
+  static double GetRssMb (void)
+  {
+    long pages = 0;
+    FILE *f = fopen ("/proc/self/statm", "r");
+    if (f != NULL)
+    {
+      long size;
+      if (fscanf (f, "%ld %ld", &size, &pages) != 2)
+      {
+        pages = 0;
+      }
+      fclose (f);
+    }
+    if (pages > 0)
+    {
+      return pages * (double) sysconf (_SC_PAGESIZE) / (1024.0 * 1024.0);
+    }
+    struct rusage usage;
+    getrusage (RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return usage.ru_maxrss / (1024.0 * 1024.0); // Bytes on macOS
+#else
+    return usage.ru_maxrss / 1024.0; // Kilobytes on Linux
+#endif
+  }
+
+  std::string m_fileName;
+  double m_interval;
+  std::ofstream m_file;
+  std::vector<Flow> m_flows;
+  std::chrono::steady_clock::time_point m_start;
+  std::chrono::steady_clock::time_point m_last;
+  uint64_t m_lastEvents;
+};
+
+#endif /* RTT_HEARTBEAT_H */
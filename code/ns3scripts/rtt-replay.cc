@@ -0,0 +1,209 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Offline replay of recorded RTT samples through several Fixed Share
+ * configurations.
+ *
+ * The trace is a text file with one RTT sample per line:
+ *
+ *   <flow id> <rtt in seconds>
+ *
+ * Lines starting with '#' are ignored. Samples of different flows may be
+ * interleaved; each flow gets its own estimator state.
+ *
+ * Configurations are given as a comma separated list of
+ * NumExperts:Alpha:Beta:LR tuples. In "bank" mode all of them are advanced
+ * together by one RttFixedShareBank, in "independent" mode every
+ * configuration replays the trace through its own RttFixedShare object,
+ * which is what the bank is meant to replace.
+ *
+ * In independent mode, --saveState writes the state of every estimator at
+ * the end of the trace, and --loadState starts every flow from such a
+ * state instead of uniform weights. A long trace can thus be replayed in
+ * parts, each part resuming from the checkpoint of the previous one.
+ *
+ * Example:
+ *   ./waf --run "scratch/rtt-replay --trace=s1.rtt --configs=100:0.08:0.25:2,100:0.08:0.25:0.5"
+ *   ./waf --run "scratch/rtt-replay --trace=part1.rtt --mode=independent --saveState=part1.state"
+ *   ./waf --run "scratch/rtt-replay --trace=part2.rtt --mode=independent --loadState=part1.state"
+**/
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include "ns3/core-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/rtt-fixed-share-bank.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("RttReplay");
+
+// Parses "N:alpha:beta:lr,N:alpha:beta:lr,..."
+static std::vector<RttFixedShareBank::Config>
+ParseConfigs (std::string str)
+{
+  std::vector<RttFixedShareBank::Config> configs;
+  std::stringstream ss (str);
+  std::string item;
+  while (std::getline (ss, item, ','))
+  {
+    RttFixedShareBank::Config config;
+    char sep;
+    std::stringstream is (item);
+    is >> config.numExperts >> sep >> config.alpha >> sep >> config.beta >> sep >> config.lr;
+    NS_ABORT_MSG_IF (is.fail () || config.numExperts <= 0, "Malformed configuration: " << item);
+    configs.push_back (config);
+  }
+  return configs;
+}
+
+int
+main (int argc, char *argv[])
+{
+  std::string traceFile = "s1.rtt";
+  std::string configStr = "100:0.08:0.25:2.0";
+  std::string mode = "bank";
+  std::string saveState = "";
+  std::string loadState = "";
+
+  CommandLine cmd;
+  cmd.AddValue ("trace", "RTT sample trace to replay", traceFile);
+  cmd.AddValue ("configs", "Comma separated NumExperts:Alpha:Beta:LR tuples", configStr);
+  cmd.AddValue ("mode", "bank or independent", mode);
+  cmd.AddValue ("saveState", "File to write the estimator states to at the end (independent mode)", saveState);
+  cmd.AddValue ("loadState", "File of estimator states to resume from (independent mode)", loadState);
+  cmd.Parse (argc, argv);
+
+  std::vector<RttFixedShareBank::Config> configs = ParseConfigs (configStr);
+  NS_ABORT_MSG_IF (configs.empty (), "No configurations given");
+  NS_ABORT_MSG_IF ((!saveState.empty () || !loadState.empty ()) && mode != "independent",
+                   "Estimator states can only be saved and loaded in independent mode");
+
+  // Checkpointed estimators, by configuration and flow. Each record is the
+  // configuration index and the flow id, followed by the estimator state.
+  std::map<std::pair<uint32_t, uint32_t>, Ptr<RttFixedShare> > states;
+  if (!loadState.empty ())
+  {
+    std::ifstream stateIn (loadState.c_str (), std::ios::binary);
+    NS_ABORT_MSG_IF (!stateIn, "Cannot open " << loadState);
+    uint32_t key[2];
+    while (stateIn.read (reinterpret_cast<char *> (key), sizeof (key)))
+    {
+      Ptr<RttFixedShare> rtt = DynamicCast<RttFixedShare> (RttEstimator::CreateFromSerialized (stateIn));
+      NS_ABORT_MSG_IF (rtt == 0, "Invalid state in " << loadState);
+      states[std::make_pair (key[0], key[1])] = rtt;
+    }
+    std::cout << "Resuming " << states.size () << " estimators from " << loadState << std::endl;
+  }
+
+  // Load the whole trace first so only the estimation is timed
+  std::map<uint32_t, std::vector<Time> > flows;
+  std::ifstream in (traceFile.c_str ());
+  NS_ABORT_MSG_IF (!in, "Cannot open " << traceFile);
+  std::string line;
+  uint64_t nSamples = 0;
+  while (std::getline (in, line))
+  {
+    if (line.empty () || line[0] == '#')
+    {
+      continue;
+    }
+    uint32_t flow;
+    double rtt;
+    std::istringstream is (line);
+    if (is >> flow >> rtt)
+    {
+      flows[flow].push_back (Seconds (rtt));
+      nSamples++;
+    }
+  }
+
+  std::vector<double> errorSum (configs.size (), 0.0);
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now ();
+
+  if (mode == "bank")
+  {
+    for (std::map<uint32_t, std::vector<Time> >::iterator it = flows.begin (); it != flows.end (); it++)
+    {
+      RttFixedShareBank bank (configs, Seconds (1.0));
+      for (uint32_t j = 0; j < it->second.size (); j++)
+      {
+        bank.Measurement (it->second[j]);
+      }
+      for (uint32_t k = 0; k < configs.size (); k++)
+      {
+        errorSum[k] += bank.GetMeanError (k) * bank.GetNSamples ();
+      }
+    }
+  }
+  else if (mode == "independent")
+  {
+    for (uint32_t k = 0; k < configs.size (); k++)
+    {
+      for (std::map<uint32_t, std::vector<Time> >::iterator it = flows.begin (); it != flows.end (); it++)
+      {
+        std::pair<uint32_t, uint32_t> key = std::make_pair (k, it->first);
+        Ptr<RttFixedShare> rtt;
+        if (states.count (key) > 0)
+        {
+          rtt = states[key];
+        }
+        else
+        {
+          rtt = CreateObject<RttFixedShare> ();
+          rtt->SetAttribute ("NumExperts", IntegerValue (configs[k].numExperts));
+          rtt->SetAttribute ("Alpha", DoubleValue (configs[k].alpha));
+          rtt->SetAttribute ("Beta", DoubleValue (configs[k].beta));
+          rtt->SetAttribute ("LR", DoubleValue (configs[k].lr));
+        }
+        for (uint32_t j = 0; j < it->second.size (); j++)
+        {
+          errorSum[k] += std::abs ((rtt->GetEstimate () - it->second[j]).ToDouble (Time::MS));
+          rtt->Measurement (it->second[j]);
+        }
+        if (!saveState.empty ())
+        {
+          states[key] = rtt;
+        }
+      }
+    }
+  }
+  else
+  {
+    NS_ABORT_MSG ("Unknown mode " << mode);
+  }
+
+  double wallTime = std::chrono::duration<double> (std::chrono::steady_clock::now () - start).count ();
+
+  if (!saveState.empty ())
+  {
+    // Flows of the loaded state that are not in this trace are kept as well
+    std::ofstream stateOut (saveState.c_str (), std::ios::binary | std::ios::trunc);
+    for (std::map<std::pair<uint32_t, uint32_t>, Ptr<RttFixedShare> >::iterator it = states.begin ();
+         it != states.end (); it++)
+    {
+      uint32_t key[2] = { it->first.first, it->first.second };
+      stateOut.write (reinterpret_cast<const char *> (key), sizeof (key));
+      it->second->Serialize (stateOut);
+    }
+    NS_ABORT_MSG_IF (!stateOut, "Cannot write " << saveState);
+    std::cout << "Saved " << states.size () << " estimators to " << saveState << std::endl;
+  }
+
+  std::cout << "Replayed " << nSamples << " samples of " << flows.size () << " flows in "
+            << wallTime << " s (" << mode << ")" << std::endl;
+  for (uint32_t k = 0; k < configs.size (); k++)
+  {
+    std::cout << "NumExperts=" << configs[k].numExperts
+              << " Alpha=" << configs[k].alpha
+              << " Beta=" << configs[k].beta
+              << " LR=" << configs[k].lr
+              << ": Mean error of " << (nSamples ? errorSum[k] / nSamples : 0)
+              << " with a weight of " << nSamples << std::endl;
+  }
+
+  return 0;
+}
@@ -0,0 +1,129 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Fork-server replication for the scenario scripts.
+ *
+ * A scenario builds its topology (nodes, Wi-Fi, AODV, addresses, mobility)
+ * once, then calls ForkReplications, which fork()s one child per
+ * replication. Each child reseeds and runs its own traffic on its
+ * copy-on-write copy of the topology, so the setup cost is paid once and
+ * the memory of the untouched parts of the topology is shared between
+ * the children.
+ *
+ * These are traffic-only replications: the random variables of the
+ * topology are created, and their streams seeded, before the fork, so
+ * reseeding in a child (RngSeedManager::SetRun, srand) only changes what
+ * the child creates afterwards. All the children see the same node
+ * movement, and the same Wi-Fi and AODV random draws until their traffic
+ * makes them diverge. Independent topologies need separate runs with a
+ * different --RngRun.
+ *
+ * This header is included by the scenarios and must sit next to them in
+ * the scratch folder.
+**/
+
+#ifndef RTT_REPLICATION_H
+#define RTT_REPLICATION_H
+
+#include <cstdio>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Runs body (r, prefix) for r = 0 .. replications - 1, each in a forked child,
+// with at most jobs children at once (0 means one per CPU). prefix is
+// outputBase-r<r>, to be used for the output files of the replication; the
+// child's stdout and stderr go to <prefix>log.txt. Returns the number of
+// replications that did not exit cleanly, e.g. because of an assert.
+inline int ForkReplications (int replications, int jobs, std::string outputBase,
+                             std::function<void (int, std::string)> body)
+{
+  if (jobs <= 0)
+  {
+    jobs = sysconf (_SC_NPROCESSORS_ONLN);
+  }
+  if (jobs <= 0)
+  {
+    jobs = 1;
+  }
+
+  // Anything still buffered would otherwise be written once per child
+  std::cout.flush ();
+  std::cerr.flush ();
+  std::clog.flush ();
+  fflush (NULL);
+
+  std::map<pid_t, int> running;
+  int next = 0;
+  int failed = 0;
+
+  while (next < replications || !running.empty ())
+  {
+    if (next < replications && (int) running.size () < jobs)
+    {
+      std::stringstream prefix;
+      prefix << outputBase << "-r" << next;
+
+      pid_t pid = fork ();
+      if (pid < 0)
+      {
+        perror ("fork");
+        failed++;
+        next++;
+        continue;
+      }
+      if (pid == 0)
+      {
+        std::string logFile = prefix.str () + "log.txt";
+        int fd = open (logFile.c_str (), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd >= 0)
+        {
+          dup2 (fd, STDOUT_FILENO);
+          dup2 (fd, STDERR_FILENO);
+          close (fd);
+        }
+
+        body (next, prefix.str ());
+
+        std::cout.flush ();
+        std::cerr.flush ();
+        std::clog.flush ();
+        fflush (NULL);
+        // Skip the parent's exit handlers, they belong to the parent
+        _exit (0);
+      }
+      running[pid] = next++;
+      continue;
+    }
+
+    int status;
+    pid_t pid = waitpid (-1, &status, 0);
+    if (pid < 0)
+    {
+      perror ("waitpid");
+      break;
+    }
+    if (running.count (pid) == 0)
+    {
+      continue;
+    }
+    if (!WIFEXITED (status) || WEXITSTATUS (status) != 0)
+    {
+      std::cout << "Replication " << running[pid] << " failed, see " << outputBase << "-r" << running[pid] << "log.txt" << std::endl;
+      failed++;
+    }
+    else
+    {
+      std::cout << "Replication " << running[pid] << " done" << std::endl;
+    }
+    running.erase (pid);
+  }
+
+  return failed;
+}
+
+#endif /* RTT_REPLICATION_H */
@@ -0,0 +1,338 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Columnar results store for the scenario scripts.
+ *
+ * At the end of a run, a scenario fills a RunResult with its configuration
+ * (scenario, estimator TypeId and attribute values, seed, flows, nodes,
+ * speed) and its outcome (the numbers of MeanError.py, FlowmonParser.py
+ * and CwndParser.py) and appends it as one row to a store directory.
+ * tools/rtt-query.cc filters and groups the rows, e.g. the mean goodput of
+ * each estimator at 68 flows, and only maps the columns a query uses.
+ *
+ * Store layout, one directory:
+ *   index         text: "RTTRESULTS 1", "rows <n>", then one
+ *                 "column <name> <d|i|s>" line per column, in order
+ *   <name>.col    n values of the column, in host byte order: double (d),
+ *                 int64_t (i), or uint32_t dictionary code (s)
+ *   <name>.dict   values of a string column (s), one per line, the line
+ *                 number being the code
+ *   lock          flock()ed while appending
+ *
+ * The index is the commit point: a row counts once the index with its row
+ * count has been renamed into place, so a run killed during the append
+ * leaves no partial row (the extra bytes in the column files are cut off
+ * by the next append). Forked replications append to the same store
+ * safely. Like the prior files, the store is not portable between machines
+ * of different byte order.
+ *
+ * This header is included by the scenarios and must sit next to them in
+ * the scratch folder.
+**/
+
+#ifndef RTT_RESULTS_H
+#define RTT_RESULTS_H
+
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "ns3/core-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/flow-monitor-module.h"
+
+class RunResult
+{
+public:
+  RunResult ()
+    : seed (0), run (0), flows (0), nodes (0), speed (NAN), simTime (NAN),
+      meanError (NAN), errorWeight (0), goodput (NAN), deliveryRatio (NAN),
+      retransmitRatio (NAN), txPackets (0), meanCwnd (NAN), wallSeconds (NAN)
+  {
+  }
+
+  // Configuration
+  std::string scenario;   // s1 ... s5
+  std::string prefix;     // Prefix of the output files of the run
+  std::string estimator;  // TypeId name
+  std::string attributes; // Name=Value;... defaults of the estimator
+  int64_t seed;           // Seed of the flow placement: the value passed to srand, --seed in s5
+  int64_t run;            // ns-3 RNG run number
+  int64_t flows;
+  int64_t nodes;
+  double speed;           // Maximum node speed in m/s
+  double simTime;         // Simulated seconds
+
+  // Outcome, NAN where the run has no data
+  double meanError;       // ms, as MeanError.py: destroyed estimators only
+  double errorWeight;
+  double goodput;         // packets/s, as FlowmonParser.py
+  double deliveryRatio;
+  double retransmitRatio;
+  double txPackets;
+  double meanCwnd;        // bytes, as CwndParser.py
+  double wallSeconds;     // Wall time of Simulator::Run
+
+  // Sets estimator and attributes from the estimator type TCP uses on node
+  void SetEstimator (ns3::Ptr<ns3::Node> node)
+  {
+    using namespace ns3;
+    TypeIdValue rttType;
+    node->GetObject<TcpL4Protocol> ()->GetAttribute ("RttEstimatorType", rttType);
+    estimator = rttType.Get ().GetName ();
+
+    // Values set with Config::SetDefault are the initial values of the
+    // attributes of the type and of its parents
+    std::ostringstream oss;
+    for (TypeId tid = rttType.Get (); tid != Object::GetTypeId (); tid = tid.GetParent ())
+    {
+      for (uint32_t i = 0; i < tid.GetAttributeN (); i++)
+      {
+        TypeId::AttributeInformation info = tid.GetAttribute (i);
+        if ((info.flags & TypeId::ATTR_CONSTRUCT) && info.initialValue != 0)
+        {
+          oss << (oss.tellp () > 0 ? ";" : "") << info.name << "=" << info.initialValue->SerializeToString (info.checker);
+        }
+      }
+    }
+    attributes = oss.str ();
+  }
+
+  // Sets the mean error of the estimators as MeanError.py, which needs
+  // RttEstimator::EnableErrorTracking before the first estimator. The log
+  // lines MeanError.py reads are printed when an estimator is destroyed, so
+  // the estimators of connections still open at the end are left out here too
+  void SetErrors (void)
+  {
+    std::vector<ns3::RttEstimator::ErrorRecord> errors = ns3::RttEstimator::GetErrorSnapshot ();
+    double num = 0;
+    double den = 0;
+    for (size_t i = 0; i < errors.size (); i++)
+    {
+      if (!errors[i].live && errors[i].samples > 1)
+      {
+        num += errors[i].errorSum;
+        den += errors[i].samples;
+      }
+    }
+    meanError = den > 0 ? num / den : NAN;
+    errorWeight = den;
+  }
+
+  // Sets goodput, delivery and retransmit ratios as FlowmonParser.py
+  void SetFlows (ns3::Ptr<ns3::FlowMonitor> flowmon, ns3::Ptr<ns3::FlowClassifier> classifier)
+  {
+    using namespace ns3;
+    Ptr<Ipv4FlowClassifier> ipv4 = DynamicCast<Ipv4FlowClassifier> (classifier);
+    double goodputSum = 0;
+    double deliverySum = 0;
+    double retransmitSum = 0;
+    txPackets = 0;
+    flowmon->CheckForLostPackets ();
+    const FlowMonitor::FlowStatsContainer &stats = flowmon->GetFlowStats ();
+    for (FlowMonitor::FlowStatsContainer::const_iterator it = stats.begin (); it != stats.end (); it++)
+    {
+      const FlowMonitor::FlowStats &s = it->second;
+      if (ipv4->FindFlow (it->first).protocol != 6 || s.txPackets <= 1
+          || s.timeFirstRxPacket == s.timeLastRxPacket || s.timeFirstTxPacket == s.timeLastTxPacket)
+      {
+        continue;
+      }
+      double rxRate = s.rxPackets / (s.timeLastRxPacket - s.timeFirstRxPacket).GetSeconds ();
+      txPackets += s.txPackets;
+      retransmitSum += (double) s.txPackets - s.rxPackets;
+      deliverySum += s.rxPackets;
+      goodputSum += rxRate * s.txPackets;
+    }
+    goodput = txPackets > 0 ? goodputSum / txPackets : NAN;
+    deliveryRatio = txPackets > 0 ? deliverySum / txPackets : NAN;
+    retransmitRatio = txPackets > 0 ? retransmitSum / txPackets : NAN;
+  }
+
+  // Appends the result as one row of the store in directory dir. Returns
+  // false if it could not, e.g. when the store has another set of columns.
+  bool Append (const std::string &dir) const
+  {
+    std::vector<Column> columns = GetColumns ();
+    if (mkdir (dir.c_str (), 0755) < 0 && errno != EEXIST)
+    {
+      perror (dir.c_str ());
+      return false;
+    }
+    int lock = open ((dir + "/lock").c_str (), O_RDWR | O_CREAT, 0644);
+    if (lock < 0 || flock (lock, LOCK_EX) < 0)
+    {
+      perror ((dir + "/lock").c_str ());
+      if (lock >= 0)
+      {
+        close (lock);
+      }
+      return false;
+    }
+
+    bool ok = true;
+    uint64_t rows = 0;
+    std::ifstream index ((dir + "/index").c_str ());
+    if (index)
+    {
+      std::string magic, word, name, type;
+      int version = 0;
+      index >> magic >> version >> word >> rows;
+      size_t n = 0;
+      while (ok && index >> word >> name >> type)
+      {
+        ok = n < columns.size () && name == columns[n].name && type[0] == columns[n].type;
+        n++;
+      }
+      ok = ok && magic == "RTTRESULTS" && version == 1 && n == columns.size ();
+      if (!ok)
+      {
+        std::cerr << dir << ": not a results store with the columns of this version" << std::endl;
+      }
+    }
+
+    for (size_t i = 0; ok && i < columns.size (); i++)
+    {
+      const Column &c = columns[i];
+      char value[8];
+      size_t width = 8;
+      if (c.type == 'd')
+      {
+        memcpy (value, &c.d, 8);
+      }
+      else if (c.type == 'i')
+      {
+        memcpy (value, &c.i, 8);
+      }
+      else
+      {
+        uint32_t code;
+        ok = DictionaryCode (dir + "/" + c.name + ".dict", c.s, code);
+        memcpy (value, &code, 4);
+        width = 4;
+      }
+      ok = ok && WriteAt (dir + "/" + c.name + ".col", rows * width, value, width);
+    }
+
+    if (ok)
+    {
+      std::string tmp = dir + "/index.tmp";
+      std::ofstream out (tmp.c_str (), std::ios::out | std::ios::trunc);
+      out << "RTTRESULTS 1\nrows " << rows + 1 << "\n";
+      for (size_t i = 0; i < columns.size (); i++)
+      {
+        out << "column " << columns[i].name << " " << columns[i].type << "\n";
+      }
+      out.close ();
+      ok = out && rename (tmp.c_str (), (dir + "/index").c_str ()) == 0;
+    }
+
+    flock (lock, LOCK_UN);
+    close (lock);
+    return ok;
+  }
+
+private:
+  struct Column
+  {
+    Column (const char *n, double v) : name (n), type ('d'), d (v), i (0) {}
+    Column (const char *n, int64_t v) : name (n), type ('i'), d (0), i (v) {}
+    Column (const char *n, const std::string &v) : name (n), type ('s'), d (0), i (0), s (v) {}
+
+    const char *name;
+    char type;
+    double d;
+    int64_t i;
+    std::string s;
+  };
+
+  std::vector<Column> GetColumns (void) const
+  {
+    std::vector<Column> c;
+    c.push_back (Column ("time", (int64_t) std::time (NULL)));
+    c.push_back (Column ("scenario", scenario));
+    c.push_back (Column ("prefix", prefix));
+    c.push_back (Column ("estimator", estimator));
+    c.push_back (Column ("attributes", attributes));
+    c.push_back (Column ("seed", seed));
+    c.push_back (Column ("run", run));
+    c.push_back (Column ("flows", flows));
+    c.push_back (Column ("nodes", nodes));
+    c.push_back (Column ("speed", speed));
+    c.push_back (Column ("sim_time", simTime));
+    c.push_back (Column ("mean_error", meanError));
+    c.push_back (Column ("error_weight", errorWeight));
+    c.push_back (Column ("goodput", goodput));
+    c.push_back (Column ("delivery_ratio", deliveryRatio));
+    c.push_back (Column ("retransmit_ratio", retransmitRatio));
+    c.push_back (Column ("tx_packets", txPackets));
+    c.push_back (Column ("mean_cwnd", meanCwnd));
+    c.push_back (Column ("wall_seconds", wallSeconds));
+    return c;
+  }
+
+  // Code of value in the dictionary file, which gets it if it is new
+  static bool DictionaryCode (const std::string &fileName, std::string value, uint32_t &code)
+  {
+    for (size_t i = 0; i < value.size (); i++)
+    {
+      if (value[i] == '\n')
+      {
+        value[i] = ' ';
+      }
+    }
+    std::string contents;
+    std::ifstream in (fileName.c_str (), std::ios::binary);
+    if (in)
+    {
+      std::ostringstream oss;
+      oss << in.rdbuf ();
+      contents = oss.str ();
+    }
+    // Drop a line cut by an aborted append
+    size_t complete = contents.rfind ('\n');
+    complete = complete == std::string::npos ? 0 : complete + 1;
+    code = 0;
+    for (size_t pos = 0; pos < complete; code++)
+    {
+      size_t eol = contents.find ('\n', pos);
+      if (contents.compare (pos, eol - pos, value) == 0)
+      {
+        return true;
+      }
+      pos = eol + 1;
+    }
+    value += "\n";
+    return WriteAt (fileName, complete, value.data (), value.size ());
+  }
+
+  // Writes size bytes at offset, cutting the file there first
+  static bool WriteAt (const std::string &fileName, uint64_t offset, const void *data, size_t size)
+  {
+    int fd = open (fileName.c_str (), O_WRONLY | O_CREAT, 0644);
+    bool ok = fd >= 0
+      && ftruncate (fd, offset) == 0
+      && pwrite (fd, data, size, offset) == (ssize_t) size;
+    if (!ok)
+    {
+      perror (fileName.c_str ());
+    }
+    if (fd >= 0)
+    {
+      close (fd);
+    }
+    return ok;
+  }
+};
+
+#endif /* RTT_RESULTS_H */
@@ -0,0 +1,163 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Event scheduler selection and statistics for the scenario scripts.
+ *
+ * SelectScheduler installs one of ns-3's scheduler implementations (Map,
+ * Heap, List, Calendar or PriorityQueue) wrapped in an
+ * InstrumentedScheduler, which forwards every call to it and keeps the
+ * number of events inserted and the peak size of the event queue.
+ * ReportScheduler prints one "Scheduler" line with these numbers and the
+ * events processed per second of wall clock time, which
+ * pythonscripts/SchedulerBenchmark.py collects.
+ *
+ * This header is included by the scenarios and must sit next to them in
+ * the scratch folder.
+**/
+
+#ifndef RTT_SCHEDULER_H
+#define RTT_SCHEDULER_H
+
+#include <iostream>
+#include <string>
+#include "ns3/core-module.h"
+
+namespace ns3 {
+
+// Scheduler forwarding to another one, counting events and the queue size
+class InstrumentedScheduler : public Scheduler
+{
+public:
+  static TypeId GetTypeId (void)
+  {
+    static TypeId tid = TypeId ("ns3::InstrumentedScheduler")
+      .SetParent<Scheduler> ()
+      .AddConstructor<InstrumentedScheduler> ()
+      .AddAttribute ("Scheduler", "Scheduler implementation the events are forwarded to",
+                     TypeIdValue (MapScheduler::GetTypeId ()),
+                     MakeTypeIdAccessor (&InstrumentedScheduler::m_schedulerType),
+                     MakeTypeIdChecker ())
+    ;
+    return tid;
+  }
+
+  InstrumentedScheduler ()
+    : m_size (0),
+      m_peakSize (0),
+      m_inserted (0),
+      m_removed (0)
+  {
+    s_current = this;
+  }
+
+  virtual ~InstrumentedScheduler ()
+  {
+    if (s_current == this)
+    {
+      s_current = 0;
+    }
+  }
+
+  virtual void Insert (const Event &ev)
+  {
+    GetScheduler ()->Insert (ev);
+    m_inserted++;
+    if (++m_size > m_peakSize)
+    {
+      m_peakSize = m_size;
+    }
+  }
+
+  virtual bool IsEmpty (void) const
+  {
+    return GetScheduler ()->IsEmpty ();
+  }
+
+  virtual Event PeekNext (void) const
+  {
+    return GetScheduler ()->PeekNext ();
+  }
+
+  virtual Event RemoveNext (void)
+  {
+    m_size--;
+    m_removed++;
+    return GetScheduler ()->RemoveNext ();
+  }
+
+  virtual void Remove (const Event &ev)
+  {
+    m_size--;
+    m_removed++;
+    GetScheduler ()->Remove (ev);
+  }
+
+  uint64_t GetPeakSize (void) const { return m_peakSize; }
+  uint64_t GetInserted (void) const { return m_inserted; }
+  std::string GetSchedulerName (void) const { return m_schedulerType.GetName (); }
+
+  // The scheduler of the running simulation, if it is instrumented
+  static InstrumentedScheduler *GetCurrent (void) { return s_current; }
+
+private:
+  // Created at first use, once the attribute is set
+  Ptr<Scheduler> GetScheduler (void) const
+  {
+    if (m_scheduler == 0)
+    {
+      ObjectFactory factory;
+      factory.SetTypeId (m_schedulerType);
+      m_scheduler = factory.Create<Scheduler> ();
+    }
+    return m_scheduler;
+  }
+
+  TypeId m_schedulerType;
+  mutable Ptr<Scheduler> m_scheduler;
+  uint64_t m_size;
+  uint64_t m_peakSize;
+  uint64_t m_inserted;
+  uint64_t m_removed;
+
+  static InstrumentedScheduler *s_current;
+};
+
+InstrumentedScheduler *InstrumentedScheduler::s_current = 0;
+
+NS_OBJECT_ENSURE_REGISTERED (InstrumentedScheduler);
+
+// Runs the simulation on the scheduler named name ("Map", "Heap", "List",
+// "Calendar" or "PriorityQueue", or a full TypeId name). Must be called
+// before the first event is scheduled, so that the peak size is complete.
+inline void SelectScheduler (std::string name)
+{
+  TypeId tid;
+  if (!TypeId::LookupByNameFailSafe (name, &tid)
+      && !TypeId::LookupByNameFailSafe ("ns3::" + name + "Scheduler", &tid))
+  {
+    NS_FATAL_ERROR ("Unknown scheduler " << name << ", use Map, Heap, List, Calendar or PriorityQueue");
+  }
+  ObjectFactory factory;
+  factory.SetTypeId (InstrumentedScheduler::GetTypeId ());
+  factory.Set ("Scheduler", TypeIdValue (tid));
+  Simulator::SetScheduler (factory);
+}
+
+// Prints the event statistics of the simulation that just ran for
+// wallSeconds.
+inline void ReportScheduler (double wallSeconds)
+{
+  uint64_t events = Simulator::GetEventCount ();
+  InstrumentedScheduler *scheduler = InstrumentedScheduler::GetCurrent ();
+  std::cout << "Scheduler " << (scheduler ? scheduler->GetSchedulerName () : std::string ("default"))
+            << ": " << events << " events processed in " << wallSeconds << " s ("
+            << (wallSeconds > 0 ? events / wallSeconds : 0) << " events/s)";
+  if (scheduler)
+  {
+    std::cout << ", " << scheduler->GetInserted () << " scheduled, peak queue size " << scheduler->GetPeakSize ();
+  }
+  std::cout << std::endl;
+}
+
+} // namespace ns3
+
+#endif /* RTT_SCHEDULER_H */
@@ -0,0 +1,114 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Periodic result snapshots for the scenario scripts.
+ *
+ * The .flowmon file is only written once Simulator::Run returns and the
+ * "Mean error of" lines of the estimators are only logged when they are
+ * destroyed, so a run that dies on the tcp-tx-buffer.cc assert leaves no
+ * results. A Snapshot appends, every interval of simulated time, the
+ * current FlowMonitor statistics of every flow and the error accumulators
+ * of every RTT estimator (RttEstimator::GetErrorSnapshot) to
+ * <prefix>.snapshot:
+ *
+ *   snapshot <simulated time in s>
+ *   flow <id> <protocol> <src> <src port> <dst> <dst port> <tx packets> <rx packets>
+ *        <tx bytes> <rx bytes> <lost packets> <first tx> <last tx> <first rx> <last rx>   (times in ns)
+ *   estimator <type> <live|done> <mean error in ms> <weight>
+ *   end
+ *
+ * (one flow line per flow, on a single line). Estimators that have not
+ * measured anything are left out. Each snapshot holds the totals so far, so
+ * the last one that reached its "end" line is the result of the run up to
+ * the crash. pythonscripts/SnapshotParser.py computes from it the numbers
+ * of MeanError.py and FlowmonParser.py.
+ *
+ * The mean error of a run only counts the "done" estimators, those
+ * destroyed during the run, with a weight above 1: MeanError.py reads the
+ * lines they log when destroyed, and SnapshotParser.py, rtt-aggregate and
+ * the results store (rtt-results.h) follow the same rule. The "live" lines
+ * show the progress of the estimators still running.
+ *
+ * This header is included by the scenarios and must sit next to them in
+ * the scratch folder.
+**/
+
+#ifndef RTT_SNAPSHOT_H
+#define RTT_SNAPSHOT_H
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include "ns3/core-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/flow-monitor-module.h"
+
+class Snapshot
+{
+public:
+  // interval is in simulated seconds, 0 to disable the snapshots
+  Snapshot (std::string fileName, double interval)
+    : m_fileName (fileName),
+      m_interval (interval)
+  {
+  }
+
+  // Schedules the first snapshot, to be called before Simulator::Run once
+  // the flow monitor is installed
+  void Start (ns3::Ptr<ns3::FlowMonitor> flowmon, ns3::Ptr<ns3::FlowClassifier> classifier)
+  {
+    if (m_interval <= 0)
+    {
+      return;
+    }
+    m_flowmon = flowmon;
+    m_classifier = ns3::DynamicCast<ns3::Ipv4FlowClassifier> (classifier);
+    m_file.open (m_fileName.c_str (), std::ios::out | std::ios::trunc);
+    ns3::Simulator::Schedule (ns3::Seconds (m_interval), &Snapshot::Write, this);
+  }
+
+private:
+  void Write (void)
+  {
+    using namespace ns3;
+    Simulator::Schedule (Seconds (m_interval), &Snapshot::Write, this);
+
+    m_file << "snapshot " << Simulator::Now ().GetSeconds () << "\n";
+
+    m_flowmon->CheckForLostPackets ();
+    const FlowMonitor::FlowStatsContainer &stats = m_flowmon->GetFlowStats ();
+    for (FlowMonitor::FlowStatsContainer::const_iterator it = stats.begin (); it != stats.end (); it++)
+    {
+      Ipv4FlowClassifier::FiveTuple t = m_classifier->FindFlow (it->first);
+      const FlowMonitor::FlowStats &s = it->second;
+      m_file << "flow " << it->first << " " << (uint32_t) t.protocol << " "
+             << t.sourceAddress << " " << t.sourcePort << " "
+             << t.destinationAddress << " " << t.destinationPort << " "
+             << s.txPackets << " " << s.rxPackets << " " << s.txBytes << " " << s.rxBytes << " "
+             << s.lostPackets << " "
+             << s.timeFirstTxPacket.GetNanoSeconds () << " " << s.timeLastTxPacket.GetNanoSeconds () << " "
+             << s.timeFirstRxPacket.GetNanoSeconds () << " " << s.timeLastRxPacket.GetNanoSeconds () << "\n";
+    }
+
+    std::vector<RttEstimator::ErrorRecord> errors = RttEstimator::GetErrorSnapshot ();
+    for (size_t i = 0; i < errors.size (); i++)
+    {
+      if (errors[i].samples == 0)
+      {
+        continue;
+      }
+      m_file << "estimator " << errors[i].typeName << " " << (errors[i].live ? "live" : "done") << " "
+             << errors[i].errorSum / errors[i].samples << " " << errors[i].samples << "\n";
+    }
+
+    // Only complete snapshots end with this line
+    m_file << "end" << std::endl;
+  }
+
+  std::string m_fileName;
+  double m_interval;
+  std::ofstream m_file;
+  ns3::Ptr<ns3::FlowMonitor> m_flowmon;
+  ns3::Ptr<ns3::Ipv4FlowClassifier> m_classifier;
+};
+
+#endif /* RTT_SNAPSHOT_H */
@@ -0,0 +1,168 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Offline training of a prior weight distribution for RttFixedShare.
+ *
+ * The traces have the same format as for rtt-replay (one
+ * "<flow id> <rtt in seconds>" sample per line), e.g. extracted with
+ * tools/pcap-rtt.cc from runs of one network class. Every flow is replayed
+ * through its own RttFixedShare, and the prior is the average over the
+ * flows of the weights each one ends with, so that it describes where the
+ * RTT of a flow of that network usually lies. It is then mixed with the
+ * uniform distribution (--floor) so that no expert starts with a zero
+ * weight, and written to a file that the PriorFile attribute can load.
+ *
+ * With --check, the corpus is replayed again from the prior and from
+ * uniform weights, and the mean error of the first --shortFlow samples of
+ * each flow is printed for both.
+ *
+ * Example:
+ *   ./waf --run "scratch/rtt-train-prior --traces=s1-r0.rtt,s1-r1.rtt --output=s1.prior --check"
+**/
+
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include "ns3/core-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/rtt-fixed-share-prior.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("RttTrainPrior");
+
+// Appends the flows of a trace to the corpus. Flow ids are made unique
+// across traces by the offset.
+static uint64_t
+LoadTrace (std::string traceFile, uint32_t offset, std::map<uint32_t, std::vector<Time> > &flows)
+{
+  std::ifstream in (traceFile.c_str ());
+  NS_ABORT_MSG_IF (!in, "Cannot open " << traceFile);
+  std::string line;
+  uint64_t nSamples = 0;
+  while (std::getline (in, line))
+  {
+    if (line.empty () || line[0] == '#')
+    {
+      continue;
+    }
+    uint32_t flow;
+    double rtt;
+    std::istringstream is (line);
+    if (is >> flow >> rtt)
+    {
+      flows[offset + flow].push_back (Seconds (rtt));
+      nSamples++;
+    }
+  }
+  return nSamples;
+}
+
+// Mean absolute error, in milliseconds, of the first samples of every flow
+static double
+ShortFlowError (const std::map<uint32_t, std::vector<Time> > &flows, uint32_t numExperts,
+                std::string priorFile, uint32_t shortFlow)
+{
+  double errorSum = 0;
+  uint64_t nSamples = 0;
+  for (std::map<uint32_t, std::vector<Time> >::const_iterator it = flows.begin (); it != flows.end (); it++)
+  {
+    Ptr<RttFixedShare> rtt = CreateObject<RttFixedShare> ();
+    rtt->SetAttribute ("NumExperts", IntegerValue (numExperts));
+    rtt->SetAttribute ("PriorFile", StringValue (priorFile));
+    for (uint32_t j = 0; j < it->second.size () && j < shortFlow; j++)
+    {
+      errorSum += std::abs ((rtt->GetEstimate () - it->second[j]).ToDouble (Time::MS));
+      nSamples++;
+      rtt->Measurement (it->second[j]);
+    }
+  }
+  return nSamples ? errorSum / nSamples : 0;
+}
+
+int
+main (int argc, char *argv[])
+{
+  std::string traces = "s1.rtt";
+  std::string output = "s1.prior";
+  uint32_t numExperts = 100;
+  uint32_t minSamples = 10;
+  double floor = 0.01;
+  bool check = false;
+  uint32_t shortFlow = 20;
+
+  CommandLine cmd;
+  cmd.AddValue ("traces", "Comma separated RTT sample traces of one network class", traces);
+  cmd.AddValue ("output", "Prior file to write", output);
+  cmd.AddValue ("numExperts", "Number of experts, must match NumExperts where the prior is used", numExperts);
+  cmd.AddValue ("minSamples", "Flows with fewer samples are not used for training", minSamples);
+  cmd.AddValue ("floor", "Share of the uniform distribution mixed into the prior", floor);
+  cmd.AddValue ("check", "Compare the short flow error from the prior and from uniform weights", check);
+  cmd.AddValue ("shortFlow", "Number of samples the check looks at in each flow", shortFlow);
+  cmd.Parse (argc, argv);
+
+  NS_ABORT_MSG_IF (numExperts == 0, "NumExperts must be positive");
+  NS_ABORT_MSG_IF (floor <= 0 || floor > 1, "The floor must be in (0, 1]");
+
+  std::map<uint32_t, std::vector<Time> > flows;
+  std::stringstream ss (traces);
+  std::string traceFile;
+  uint64_t nSamples = 0;
+  uint32_t offset = 0;
+  while (std::getline (ss, traceFile, ','))
+  {
+    nSamples += LoadTrace (traceFile, offset, flows);
+    // Leave room for the flow ids of this trace
+    offset = flows.empty () ? 0 : flows.rbegin ()->first + 1;
+  }
+
+  // Average of the final weight distributions of the flows
+  std::vector<double> prior (numExperts, 0.0);
+  uint32_t nTrained = 0;
+  for (std::map<uint32_t, std::vector<Time> >::iterator it = flows.begin (); it != flows.end (); it++)
+  {
+    if (it->second.size () < minSamples)
+    {
+      continue;
+    }
+    Ptr<RttFixedShare> rtt = CreateObject<RttFixedShare> ();
+    rtt->SetAttribute ("NumExperts", IntegerValue (numExperts));
+    for (uint32_t j = 0; j < it->second.size (); j++)
+    {
+      rtt->Measurement (it->second[j]);
+    }
+    std::vector<double> weights = rtt->GetWeights ();
+    for (uint32_t i = 0; i < numExperts; i++)
+    {
+      prior[i] += weights[i];
+    }
+    nTrained++;
+  }
+  NS_ABORT_MSG_IF (nTrained == 0, "No flow has " << minSamples << " samples or more");
+
+  for (uint32_t i = 0; i < numExperts; i++)
+  {
+    prior[i] = (1 - floor) * prior[i] / nTrained + floor / numExperts;
+  }
+  NS_ABORT_MSG_IF (!RttFixedSharePrior::Write (output, prior), "Cannot write " << output);
+
+  std::vector<double> grid = RttFixedShare::GetExpertGrid (numExperts);
+  double mean = 0;
+  for (uint32_t i = 0; i < numExperts; i++)
+  {
+    mean += prior[i] * grid[i];
+  }
+  std::cout << "Trained " << output << " on " << nTrained << " of " << flows.size () << " flows ("
+            << nSamples << " samples), initial estimate " << mean * 1000 << " ms" << std::endl;
+
+  if (check)
+  {
+    double uniformError = ShortFlowError (flows, numExperts, "", shortFlow);
+    double priorError = ShortFlowError (flows, numExperts, output, shortFlow);
+    std::cout << "First " << shortFlow << " samples of each flow: mean error of "
+              << uniformError << " ms from uniform weights, "
+              << priorError << " ms from the prior" << std::endl;
+  }
+
+  return 0;
+}
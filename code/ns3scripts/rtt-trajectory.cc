@@ -0,0 +1,160 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Generates the node trajectories of a scenario once, for playback with
+ * the --trajectories option of the scenarios (see rtt-trajectory.h).
+ *
+ * The mobility is set up exactly as in scenario[1-4].cc (RandomRectangle
+ * positions, RandomWaypoint with a Uniform[1, speed] speed, the same stream
+ * indices), so with the default ns-3 seed the file replays the motion a
+ * scenario would have generated by itself. Only the mobility models are
+ * simulated: every course change of a node is recorded as a waypoint.
+ *
+ * The output file name defaults to one derived from the parameters, so that
+ * each combination is generated once and then reused. Example:
+ *   ./waf --run "scratch/rtt-trajectory --seed=1 --speed=50 --nodes=20"
+ *   ./waf --run "scratch/scenario1 --trajectories=traj-s1-v50-p0-1500x1000-n20-t1500.bin"
+**/
+
+#include <iostream>
+#include <sstream>
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/mobility-module.h"
+#include "rtt-trajectory.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("RttTrajectory");
+
+static std::vector<std::vector<TrajectoryPoint> > g_points;
+
+static void
+RecordPoint (uint32_t node, Ptr<const MobilityModel> mobility)
+{
+  TrajectoryPoint p;
+  p.time = Simulator::Now ().GetSeconds ();
+  Vector position = mobility->GetPosition ();
+  p.x = position.x;
+  p.y = position.y;
+  p.z = position.z;
+
+  // Several course changes at the same time: only the last position counts
+  std::vector<TrajectoryPoint> &points = g_points[node];
+  if (!points.empty () && points.back ().time == p.time)
+  {
+    points.back () = p;
+  }
+  else
+  {
+    points.push_back (p);
+  }
+}
+
+static void
+RecordAll (NodeContainer nodes)
+{
+  for (uint32_t i = 0; i < nodes.GetN (); i++)
+  {
+    RecordPoint (i, nodes.Get (i)->GetObject<MobilityModel> ());
+  }
+}
+
+int
+main (int argc, char *argv[])
+{
+  uint32_t seed = 1;
+  double speed = 50;
+  double pause = 0;
+  double width = 1500;
+  double height = 1000;
+  uint32_t nodes = 20;
+  double duration = 25 * 60;
+  std::string output;
+
+  CommandLine cmd;
+  cmd.AddValue ("seed", "ns-3 RNG seed of the trajectories", seed);
+  cmd.AddValue ("speed", "Max node speed in meters/second, as nodeSpeed in the scenarios", speed);
+  cmd.AddValue ("pause", "Pause at each waypoint in seconds, as nodePause in the scenarios", pause);
+  cmd.AddValue ("width", "Width of the area in meters", width);
+  cmd.AddValue ("height", "Height of the area in meters", height);
+  cmd.AddValue ("nodes", "Number of nodes", nodes);
+  cmd.AddValue ("duration", "Length of the trajectories in seconds", duration);
+  cmd.AddValue ("output", "Trajectory file to write, derived from the parameters by default", output);
+  cmd.Parse (argc, argv);
+
+  if (output.empty ())
+  {
+    std::stringstream ss;
+    ss << "traj-s" << seed << "-v" << speed << "-p" << pause << "-" << width << "x" << height
+       << "-n" << nodes << "-t" << duration << ".bin";
+    output = ss.str ();
+  }
+
+  RngSeedManager::SetSeed (seed);
+
+  NodeContainer adhocNodes;
+  adhocNodes.Create (nodes);
+
+  // Same setup as BuildTopology in the scenarios
+  MobilityHelper mobilityAdhoc;
+  int64_t streamIndex = 0;
+
+  ObjectFactory pos;
+  pos.SetTypeId ("ns3::RandomRectanglePositionAllocator");
+  std::stringstream ssX;
+  ssX << "ns3::UniformRandomVariable[Min=0.0|Max=" << width << "]";
+  std::stringstream ssY;
+  ssY << "ns3::UniformRandomVariable[Min=0.0|Max=" << height << "]";
+  pos.Set ("X", StringValue (ssX.str ()));
+  pos.Set ("Y", StringValue (ssY.str ()));
+
+  Ptr<PositionAllocator> taPositionAlloc = pos.Create ()->GetObject<PositionAllocator> ();
+  streamIndex += taPositionAlloc->AssignStreams (streamIndex);
+
+  std::stringstream ssSpeed;
+  ssSpeed << "ns3::UniformRandomVariable[Min=1.0|Max=" << speed << "]";
+  std::stringstream ssPause;
+  ssPause << "ns3::ConstantRandomVariable[Constant=" << pause << "]";
+  mobilityAdhoc.SetMobilityModel ("ns3::RandomWaypointMobilityModel",
+                                  "Speed", StringValue (ssSpeed.str ()),
+                                  "Pause", StringValue (ssPause.str ()),
+                                  "PositionAllocator", PointerValue (taPositionAlloc));
+  mobilityAdhoc.SetPositionAllocator (taPositionAlloc);
+  mobilityAdhoc.Install (adhocNodes);
+  streamIndex += mobilityAdhoc.AssignStreams (adhocNodes, streamIndex);
+  NS_UNUSED (streamIndex);
+
+  g_points.resize (nodes);
+  for (uint32_t i = 0; i < nodes; i++)
+  {
+    Ptr<MobilityModel> mobility = adhocNodes.Get (i)->GetObject<MobilityModel> ();
+    mobility->TraceConnectWithoutContext ("CourseChange", MakeBoundCallback (&RecordPoint, i));
+  }
+  // Initial positions, in case a model does not notify its first course change
+  Simulator::Schedule (Seconds (0), &RecordAll, adhocNodes);
+
+  Simulator::Stop (Seconds (duration));
+  Simulator::Run ();
+
+  // Close each trajectory at the end of the run, in the middle of a walk
+  RecordAll (adhocNodes);
+  uint64_t nPoints = 0;
+  for (uint32_t i = 0; i < nodes; i++)
+  {
+    nPoints += g_points[i].size ();
+  }
+  Simulator::Destroy ();
+
+  TrajectoryHeader header;
+  header.seed = seed;
+  header.reserved = 0;
+  header.speed = speed;
+  header.pause = pause;
+  header.width = width;
+  header.height = height;
+  header.duration = duration;
+  NS_ABORT_MSG_IF (!WriteTrajectories (output, header, g_points), "Cannot write " << output);
+
+  std::cout << "Wrote " << nPoints << " waypoints of " << nodes << " nodes to " << output << std::endl;
+  return 0;
+}
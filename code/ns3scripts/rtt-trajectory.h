@@ -0,0 +1,160 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Precomputed node trajectories for the scenario scripts.
+ *
+ * rtt-trajectory.cc runs the scenarios' RandomWaypoint mobility once for a
+ * (seed, speed, pause, area, nodes) combination and stores the waypoints
+ * of every node in a binary file. The scenarios can then be given that
+ * file (--trajectories), which is memory-mapped and played back through a
+ * WaypointMobilityModel on each node, so that repeated runs skip the
+ * trajectory generation and all see exactly the same motion.
+ *
+ * File layout, in host byte order:
+ *   TrajectoryHeader
+ *   uint64_t offsets[numNodes + 1]   index of the first point of each node
+ *   TrajectoryPoint points[offsets[numNodes]]
+ *
+ * Motion between two consecutive points of a node is linear, as with
+ * RandomWaypoint. A node stays at its last point after the end of the file.
+ *
+ * This header is included by the scenarios and rtt-trajectory.cc and must
+ * sit next to them in the scratch folder.
+**/
+
+#ifndef RTT_TRAJECTORY_H
+#define RTT_TRAJECTORY_H
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/mobility-module.h"
+
+struct TrajectoryHeader
+{
+  char magic[8];     // "RTTTRAJ"
+  uint32_t version;  // 1
+  uint32_t numNodes;
+  uint32_t seed;     // Parameters the trajectories were generated with
+  uint32_t reserved;
+  double speed;
+  double pause;
+  double width;
+  double height;
+  double duration;
+};
+
+struct TrajectoryPoint
+{
+  double time; // Seconds
+  double x;
+  double y;
+  double z;
+};
+
+static const char TRAJECTORY_MAGIC[8] = "RTTTRAJ";
+static const uint32_t TRAJECTORY_VERSION = 1;
+
+// Writes the points of each node to path. Returns false if the file cannot
+// be written.
+inline bool WriteTrajectories (std::string path, TrajectoryHeader header,
+                               const std::vector<std::vector<TrajectoryPoint> > &nodes)
+{
+  memcpy (header.magic, TRAJECTORY_MAGIC, sizeof (header.magic));
+  header.version = TRAJECTORY_VERSION;
+  header.numNodes = nodes.size ();
+
+  std::vector<uint64_t> offsets (1, 0);
+  for (size_t i = 0; i < nodes.size (); i++)
+  {
+    offsets.push_back (offsets.back () + nodes[i].size ());
+  }
+
+  FILE *f = fopen (path.c_str (), "wb");
+  if (f == NULL)
+  {
+    return false;
+  }
+  bool ok = fwrite (&header, sizeof (header), 1, f) == 1
+    && fwrite (offsets.data (), sizeof (uint64_t), offsets.size (), f) == offsets.size ();
+  for (size_t i = 0; ok && i < nodes.size (); i++)
+  {
+    ok = fwrite (nodes[i].data (), sizeof (TrajectoryPoint), nodes[i].size (), f) == nodes[i].size ();
+  }
+  return fclose (f) == 0 && ok;
+}
+
+// Read-only mapping of a trajectory file. Aborts on a missing or malformed
+// file, as a scenario cannot run without its mobility.
+class TrajectoryFile
+{
+public:
+  TrajectoryFile (std::string path)
+    : m_path (path)
+  {
+    int fd = open (path.c_str (), O_RDONLY);
+    NS_ABORT_MSG_IF (fd < 0, "Cannot open trajectory file " << path);
+    struct stat st;
+    NS_ABORT_MSG_IF (fstat (fd, &st) != 0, "Cannot stat " << path);
+    m_size = st.st_size;
+    NS_ABORT_MSG_IF (m_size < sizeof (TrajectoryHeader), path << " is not a trajectory file");
+    m_data = mmap (NULL, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close (fd);
+    NS_ABORT_MSG_IF (m_data == MAP_FAILED, "Cannot map " << path);
+
+    m_header = static_cast<const TrajectoryHeader *> (m_data);
+    NS_ABORT_MSG_IF (memcmp (m_header->magic, TRAJECTORY_MAGIC, sizeof (TRAJECTORY_MAGIC)) != 0
+                     || m_header->version != TRAJECTORY_VERSION,
+                     path << " is not a trajectory file of version " << TRAJECTORY_VERSION);
+    m_offsets = reinterpret_cast<const uint64_t *> (m_header + 1);
+    m_points = reinterpret_cast<const TrajectoryPoint *> (m_offsets + m_header->numNodes + 1);
+    NS_ABORT_MSG_IF (sizeof (TrajectoryHeader) + (m_header->numNodes + 1) * sizeof (uint64_t) > m_size
+                     || (const char *) (m_points + m_offsets[m_header->numNodes]) > (const char *) m_data + m_size,
+                     path << " is truncated");
+  }
+
+  ~TrajectoryFile ()
+  {
+    munmap (m_data, m_size);
+  }
+
+  const TrajectoryHeader &GetHeader () const
+  {
+    return *m_header;
+  }
+
+  // Installs a WaypointMobilityModel holding the trajectory of node i on
+  // the i-th node of the container.
+  void Install (ns3::NodeContainer nodes) const
+  {
+    using namespace ns3;
+    NS_ABORT_MSG_IF (nodes.GetN () != m_header->numNodes,
+                     m_path << " has " << m_header->numNodes << " nodes, the scenario " << nodes.GetN ());
+    for (uint32_t i = 0; i < nodes.GetN (); i++)
+    {
+      Ptr<WaypointMobilityModel> mobility = CreateObject<WaypointMobilityModel> ();
+      for (uint64_t j = m_offsets[i]; j < m_offsets[i + 1]; j++)
+      {
+        const TrajectoryPoint &p = m_points[j];
+        mobility->AddWaypoint (Waypoint (Seconds (p.time), Vector (p.x, p.y, p.z)));
+      }
+      nodes.Get (i)->AggregateObject (mobility);
+    }
+  }
+
+private:
+  std::string m_path;
+  void *m_data;
+  size_t m_size;
+  const TrajectoryHeader *m_header;
+  const uint64_t *m_offsets;
+  const TrajectoryPoint *m_points;
+};
+
+#endif /* RTT_TRAJECTORY_H */
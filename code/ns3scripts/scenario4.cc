@@ -10,6 +10,7 @@
  * example. 
 **/
 
+#include <chrono>
 #include <fstream>
 #include <iostream>
 #include <random>
@@ -23,6 +24,12 @@
 #include "ns3/flow-monitor.h"
 #include "ns3/flow-monitor-module.h"
 #include "ns3/flow-monitor-helper.h"
+#include "rtt-replication.h"
+#include "rtt-heartbeat.h"
+#include "rtt-results.h"
+#include "rtt-snapshot.h"
+#include "rtt-scheduler.h"
+#include "rtt-trajectory.h"
 
 using namespace ns3;
 
@@ -30,9 +37,18 @@ using namespace ns3;
 // Begin trace setup code
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+// Prefix of the output files (.cwnd, .flowmon) of the current run
+static std::string g_outputPrefix = "s4";
+
+// Sum and number of the cwnd values of the current run, for the results store
+static double g_cwndSum = 0;
+static uint64_t g_cwndCount = 0;
+
 void CwndChange (Ptr<OutputStreamWrapper> stream, uint32_t oldCwnd, uint32_t newCwnd)
 {
   *stream->GetStream () << newCwnd << std::endl;
+  g_cwndSum += newCwnd;
+  g_cwndCount++;
 
 }
 
@@ -43,7 +59,7 @@ void SetCallback(Ptr<BulkSendApplication> app)
 
   // Setup stream
   AsciiTraceHelper asciiTraceHelper;
-  Ptr<OutputStreamWrapper> stream = asciiTraceHelper.CreateFileStream ("s1.cwnd", std::ios::app);
+  Ptr<OutputStreamWrapper> stream = asciiTraceHelper.CreateFileStream (g_outputPrefix + ".cwnd", std::ios::app);
 
   sock->TraceConnectWithoutContext ("CongestionWindow", MakeBoundCallback (&CwndChange, stream));
 }
@@ -52,20 +68,111 @@ void SetCallback(Ptr<BulkSendApplication> app)
 // End trace setup code
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Begin RTT warm start code
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+// Hands what a connection learned about its peer to the cache of its node
+// once it stops sending, and again when it is closed.
+void RememberRtt(Ptr<RttMetricsCache> cache, Ipv4Address peer, Ptr<RttFixedShare> rtt,
+                 TcpSocket::TcpStates_t oldState, TcpSocket::TcpStates_t newState)
+{
+  if (oldState == TcpSocket::ESTABLISHED || newState == TcpSocket::CLOSED)
+  {
+    cache->Update (peer, rtt);
+  }
+}
+
+// Socket factory of the senders when warm starting. It creates TCP sockets like
+// TcpSocketFactory, then gives them a FixedShare estimator seeded from what the
+// node learned about the peer on earlier connections, before the application
+// connects them. The peer is set by ExpectPeer right before the app starts.
+class WarmStartSocketFactory : public SocketFactory
+{
+public:
+  static TypeId GetTypeId (void);
+  void ExpectPeer (Ipv4Address peer);
+  virtual Ptr<Socket> CreateSocket (void);
+
+private:
+  Ipv4Address m_peer; // Peer of the next socket
+};
+
+NS_OBJECT_ENSURE_REGISTERED (WarmStartSocketFactory);
+
+TypeId WarmStartSocketFactory::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("WarmStartSocketFactory")
+    .SetParent<SocketFactory> ()
+    .AddConstructor<WarmStartSocketFactory> ()
+  ;
+  return tid;
+}
+
+void WarmStartSocketFactory::ExpectPeer (Ipv4Address peer)
+{
+  m_peer = peer;
+}
+
+Ptr<Socket> WarmStartSocketFactory::CreateSocket (void)
+{
+  Ptr<Node> node = GetObject<Node> ();
+  Ptr<TcpL4Protocol> tcp = node->GetObject<TcpL4Protocol> ();
+
+  TypeIdValue rttType;
+  tcp->GetAttribute ("RttEstimatorType", rttType);
+  if (rttType.Get () != RttFixedShare::GetTypeId ())
+  {
+    NS_FATAL_ERROR ("--warmStart only applies to FixedShare, but the RttEstimatorType is " << rttType.Get ().GetName ());
+  }
+
+  Ptr<TcpSocketBase> sock = DynamicCast<TcpSocketBase> (tcp->CreateSocket ());
+  Ptr<RttMetricsCache> cache = node->GetObject<RttMetricsCache> ();
+  Ptr<RttFixedShare> rtt = CreateObject<RttFixedShare> ();
+  cache->Seed (m_peer, rtt);
+  sock->SetRtt (rtt);
+  sock->TraceConnectWithoutContext ("State", MakeBoundCallback (&RememberRtt, cache, m_peer, rtt));
+  return sock;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// End RTT warm start code
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 class RttExperiment
 {
 public:
   RttExperiment();
   void Run ();
+  void RunTrafficReplications (int replications, int jobs, unsigned int seed);
+  void SetTrajectories (std::string trajectories);
+  void SetHeartbeat (double interval);
+  void SetSnapshot (double interval);
+  void SetResults (std::string results);
+  void SetWarmStart (bool warmStart);
   std::string GetCsvFilename();
   int GetNumFlows();
   int GetNumNodes();
   int GetPower();
 
 private:
+  void BuildTopology ();
+  void RunTraffic (std::string outputPrefix);
+  void AppendResult (std::string outputPrefix, Ptr<FlowMonitor> flowmon, Ptr<FlowClassifier> classifier, double runSeconds);
+
   uint32_t port;
   int m_numFlows;
   int m_numNodes;
+  double m_simTime;
+  std::string m_trajectories;
+  double m_heartbeat;
+  double m_snapshot;
+  double m_nodeSpeed;
+  std::string m_results;
+  unsigned int m_seed; // Value passed to srand
+  NodeContainer adhocNodes;
+  Ipv4InterfaceContainer adhocInterfaces;
+  bool m_rttWarmStart;
 
 };
 
@@ -74,41 +181,114 @@ NS_LOG_COMPONENT_DEFINE ("RttExperiment");
 RttExperiment::RttExperiment ()
   : port (1024),
     m_numFlows(20), // To change number of flows (3	7	17	34	68	100	130)
-    m_numNodes(20) // To change number of nodes
+    m_numNodes(20), // To change number of nodes
+    m_simTime(90.0*60.0), // Simulation time in seconds
+    m_heartbeat(0),
+    m_snapshot(0),
+    m_nodeSpeed(0),
+    m_seed(0),
+    m_rttWarmStart(false) // Seed FixedShare from earlier connections to the same peer
 {
 }
 
 int RttExperiment::GetNumFlows() { return m_numFlows; }
 int RttExperiment::GetNumNodes() { return m_numNodes; }
 
+void RttExperiment::SetTrajectories(std::string trajectories)
+{
+  // Precomputed trajectory file (see rtt-trajectory.h) replacing the RandomWaypoint mobility
+  m_trajectories = trajectories;
+}
+
+void RttExperiment::SetHeartbeat(double interval)
+{
+  // Wall seconds between two lines of the .heartbeat file, 0 for none
+  m_heartbeat = interval;
+}
+
+void RttExperiment::SetSnapshot(double interval)
+{
+  // Simulated seconds between two blocks of the .snapshot file, 0 for none
+  m_snapshot = interval;
+}
+
+void RttExperiment::SetResults(std::string results)
+{
+  // Results store directory (see rtt-results.h) each run appends a row to, empty for none
+  m_results = results;
+}
+
+void RttExperiment::SetWarmStart(bool warmStart)
+{
+  // Seed FixedShare from the RttMetricsCache of the node (see rtt-metrics-cache.h)
+  m_rttWarmStart = warmStart;
+}
+
 void RttExperiment::Run()
 {
   // Seed RNG for multiple future uses
-  srand(time(NULL));
+  m_seed = time(NULL);
+  srand(m_seed);
 
+  BuildTopology();
+  RunTraffic("s4");
+}
+
+void RttExperiment::RunTrafficReplications(int replications, int jobs, unsigned int seed)
+{
+  // The topology is built once. Each replication is forked from it and only
+  // reseeds and sets up its own traffic. The mobility, Wi-Fi and AODV random
+  // streams were created before the fork, so SetRun does not reach them: the
+  // replications share the node movement and differ by their flows only.
+  BuildTopology();
+
+  int failed = ForkReplications (replications, jobs, "s4", [this, seed] (int replication, std::string outputPrefix)
+  {
+    m_seed = seed + replication;
+    srand(m_seed);
+    RngSeedManager::SetRun (seed + replication);
+    RunTraffic(outputPrefix);
+  });
+
+  NS_LOG_INFO(replications - failed << " of " << replications << " traffic replications completed");
+}
+
+void RttExperiment::BuildTopology()
+{
   Packet::EnablePrinting ();
 
   // Setup simulation parameters
-  double simTime = 90.0*60.0; // In seconds
   int nodeSpeedMin = 40; // Min speed in meters/second
   int nodeSpeedMax = 50; // Max speed in meters/second
+  m_nodeSpeed = nodeSpeedMax;
   int nodePause = 0;
   std::string phyMode ("DsssRate1Mbps");
 
   // Set default attributes to match paper
 
+  if (m_rttWarmStart)
+  {
+    // Warm starting seeds FixedShare, a line below choosing another estimator makes it fail
+    Config::SetDefault ("ns3::TcpL4Protocol::RttEstimatorType", TypeIdValue(RttFixedShare::GetTypeId()));
+  }
+
   // Comment below line for simulation to use MeanDevation method
   // Config::SetDefault ("ns3::TcpL4Protocol::RttEstimatorType", TypeIdValue(RttFixedShare::GetTypeId()));
 
+  // Uncomment below line to have FixedShare drive TCP while MeanDeviation runs on the same
+  // samples alongside it. The paired comparison is logged as "Shadow comparison" lines.
+  // Config::SetDefault ("ns3::TcpL4Protocol::RttEstimatorType", TypeIdValue(RttShadowEstimator::GetTypeId()));
+
   Config::SetDefault ("ns3::BulkSendApplication::Protocol",   TypeIdValue (TcpSocketFactory::GetTypeId ()));
   Config::SetDefault ("ns3::WifiRemoteStationManager::NonUnicastMode", StringValue (phyMode));
   Config::SetDefault ("ns3::TcpSocket::SndBufSize", UintegerValue (16384));
   Config::SetDefault ("ns3::TcpSocket::RcvBufSize", UintegerValue (16384));
   Config::SetDefault ("ns3::RangePropagationLossModel::MaxRange", DoubleValue (100.0));
+  // Only deliver frames to the nodes within MaxRange, must not be smaller than it
+  Config::SetDefault ("ns3::YansWifiChannel::SpatialIndexRange", DoubleValue (100.0));
   Config::SetDefault ("ns3::TcpSocket::DelAckCount", UintegerValue(1));
   
 
-  NodeContainer adhocNodes;
   adhocNodes.Create (GetNumNodes());
 
   WifiHelper wifi;
@@ -142,18 +322,27 @@ void RttExperiment::Run()
   Ptr<PositionAllocator> taPositionAlloc = pos.Create ()->GetObject<PositionAllocator> ();
   streamIndex += taPositionAlloc->AssignStreams (streamIndex);
 
-  std::stringstream ssSpeed;
-  // Scenario 1: 1-50 node speed
-  ssSpeed << "ns3::UniformRandomVariable[Min=" << nodeSpeedMin << "|Max=" << nodeSpeedMax << "]";
-  std::stringstream ssPause;
-  ssPause << "ns3::ConstantRandomVariable[Constant=" << nodePause << "]";
-  mobilityAdhoc.SetMobilityModel ("ns3::RandomWaypointMobilityModel",
-                                  "Speed", StringValue (ssSpeed.str ()),
-                                  "Pause", StringValue (ssPause.str ()),
-                                  "PositionAllocator", PointerValue (taPositionAlloc));
-  mobilityAdhoc.SetPositionAllocator (taPositionAlloc);
-  mobilityAdhoc.Install (adhocNodes);
-  streamIndex += mobilityAdhoc.AssignStreams (adhocNodes, streamIndex);
+  // Mobility is either played back from a precomputed trajectory file or
+  // generated here by RandomWaypoint
+  if (!m_trajectories.empty ())
+  {
+    TrajectoryFile (m_trajectories).Install (adhocNodes);
+  }
+  else
+  {
+    std::stringstream ssSpeed;
+    // Scenario 1: 1-50 node speed
+    ssSpeed << "ns3::UniformRandomVariable[Min=" << nodeSpeedMin << "|Max=" << nodeSpeedMax << "]";
+    std::stringstream ssPause;
+    ssPause << "ns3::ConstantRandomVariable[Constant=" << nodePause << "]";
+    mobilityAdhoc.SetMobilityModel ("ns3::RandomWaypointMobilityModel",
+                                    "Speed", StringValue (ssSpeed.str ()),
+                                    "Pause", StringValue (ssPause.str ()),
+                                    "PositionAllocator", PointerValue (taPositionAlloc));
+    mobilityAdhoc.SetPositionAllocator (taPositionAlloc);
+    mobilityAdhoc.Install (adhocNodes);
+    streamIndex += mobilityAdhoc.AssignStreams (adhocNodes, streamIndex);
+  }
   NS_UNUSED (streamIndex); // From this point, streamIndex is unused
 
   AodvHelper aodv;
@@ -167,9 +356,26 @@ void RttExperiment::Run()
 
   Ipv4AddressHelper addressAdhoc;
   addressAdhoc.SetBase ("10.1.1.0", "255.255.255.0");
-  Ipv4InterfaceContainer adhocInterfaces;
   adhocInterfaces = addressAdhoc.Assign (adhocDevices);  
 
+  // Per-node cache of RTT knowledge for each peer, used to warm start estimators
+  if (m_rttWarmStart)
+  {
+    for (uint32_t n = 0; n < adhocNodes.GetN(); n++)
+    {
+      adhocNodes.Get(n)->AggregateObject (CreateObject<RttMetricsCache> ());
+      adhocNodes.Get(n)->AggregateObject (CreateObject<WarmStartSocketFactory> ());
+    }
+  }
+
+}
+
+void RttExperiment::RunTraffic(std::string outputPrefix)
+{
+  g_outputPrefix = outputPrefix;
+  g_cwndSum = 0;
+  g_cwndCount = 0;
+
   std::vector<Ptr<BulkSendApplication> > apps;
   std::vector<int> startTimes;
 
@@ -184,6 +390,8 @@ void RttExperiment::Run()
   // In short, this ensures a unique (x, y) flow in either direction.
   // std::map<int, int> flowMap;
 
+  Heartbeat heartbeat (outputPrefix + ".heartbeat", m_heartbeat);
+
   for (int i = 0; i < GetNumFlows(); i++)
   {
     int senderIndex = i; 
@@ -211,6 +419,10 @@ void RttExperiment::Run()
       Ptr<Node> nextNode = adhocNodes.Get (receiverIndex);
 
       BulkSendHelper sendHelper ("ns3::TcpSocketFactory", (InetSocketAddress (adhocInterfaces.GetAddress (receiverIndex), port))); // To address
+      if (m_rttWarmStart)
+      {
+        sendHelper.SetAttribute ("Protocol", TypeIdValue (WarmStartSocketFactory::GetTypeId ()));
+      }
       ApplicationContainer senderApp = sendHelper.Install(node); // Install onto source
 
       Ptr<BulkSendApplication> bsApp = DynamicCast<BulkSendApplication> (senderApp.Get(0));
@@ -228,6 +440,14 @@ void RttExperiment::Run()
       senderApp.Start (Seconds (startTime + startJitter));
       sinkApp.Stop (Seconds (startTime + 200));
       senderApp.Stop (Seconds (startTime + 200));
+      heartbeat.AddFlow (sinkApp.Get (0), 512 * numPackets, startTime + startJitter, startTime + 200);
+
+      if (m_rttWarmStart)
+      {
+        // Scheduled before the app schedules its start, so it runs first at the same time
+        Simulator::Schedule(Seconds (startTime + startJitter), &WarmStartSocketFactory::ExpectPeer,
+                            node->GetObject<WarmStartSocketFactory> (), adhocInterfaces.GetAddress (receiverIndex));
+      }
     }
   }
 
@@ -235,20 +455,100 @@ void RttExperiment::Run()
   Ptr<FlowMonitor> flowmon;
   FlowMonitorHelper flowmonHelper;
   flowmon = flowmonHelper.InstallAll ();
+  Snapshot snapshot (outputPrefix + ".snapshot", m_snapshot);
 
-  Simulator::Stop (Seconds (simTime));
+  Simulator::Stop (Seconds (m_simTime));
+  heartbeat.Start ();
+  snapshot.Start (flowmon, flowmonHelper.GetClassifier ());
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now ();
   Simulator::Run ();
+  double runSeconds = std::chrono::duration<double> (std::chrono::steady_clock::now () - start).count ();
+  ReportScheduler (runSeconds);
+  if (RttEstimatorStats::IsEnabled ())
+  {
+    // Simulator::Destroy, which would print them, is never called
+    RttEstimatorStats::Dump ();
+  }
 
-  flowmon->SerializeToXmlFile ("s4.flowmon", false, false);
+  flowmon->SerializeToXmlFile (outputPrefix + ".flowmon", false, false);
+  AppendResult (outputPrefix, flowmon, flowmonHelper.GetClassifier (), runSeconds);
+}
+
+void RttExperiment::AppendResult(std::string outputPrefix, Ptr<FlowMonitor> flowmon, Ptr<FlowClassifier> classifier, double runSeconds)
+{
+  if (m_results.empty())
+  {
+    return;
+  }
+  RunResult result;
+  result.scenario = "s4";
+  result.prefix = outputPrefix;
+  result.seed = m_seed;
+  result.run = RngSeedManager::GetRun();
+  result.flows = GetNumFlows();
+  result.nodes = GetNumNodes();
+  result.speed = m_nodeSpeed;
+  result.simTime = m_simTime;
+  result.SetEstimator(adhocNodes.Get(0));
+  result.SetErrors();
+  result.SetFlows(flowmon, classifier);
+  result.meanCwnd = g_cwndCount > 0 ? g_cwndSum / g_cwndCount : NAN;
+  result.wallSeconds = runSeconds;
+  if (!result.Append(m_results))
+  {
+    NS_LOG_INFO("Could not append the run to the results store " << m_results);
+  }
 }
 
 
 int 
 main (int argc, char *argv[])
 {
+  int trafficReplications = 0;
+  int jobs = 0;
+  unsigned int seed = 1;
+  std::string trajectories;
+  std::string scheduler = "Map";
+  double heartbeat = 0;
+  double snapshot = 0;
+  std::string results;
+  bool warmStart = false;
+
+  CommandLine cmd;
+  cmd.AddValue ("trafficReplications", "Number of replications forked from one topology, with the same node movement "
+                "and different flows, 0 for a single run", trafficReplications);
+  cmd.AddValue ("jobs", "Maximum number of traffic replications running at once, 0 for one per CPU", jobs);
+  cmd.AddValue ("seed", "Seed of the flows of the first traffic replication", seed);
+  cmd.AddValue ("trajectories", "Trajectory file from rtt-trajectory to play back instead of RandomWaypoint", trajectories);
+  cmd.AddValue ("scheduler", "Event scheduler: Map (default), Heap, List, Calendar or PriorityQueue", scheduler);
+  cmd.AddValue ("heartbeat", "Wall seconds between two progress lines of the .heartbeat file, 0 (default) for none", heartbeat);
+  cmd.AddValue ("snapshot", "Simulated seconds between two blocks of the .snapshot file, 0 (default) for none", snapshot);
+  cmd.AddValue ("results", "Results store directory each run appends a row to, e.g. rtt-results, empty (default) for none", results);
+  cmd.AddValue ("warmStart", "Use FixedShare and seed it from earlier connections to the same peer", warmStart);
+  cmd.Parse (argc, argv);
+
+  SelectScheduler (scheduler);
+  if (snapshot > 0 || !results.empty ())
+  {
+    // Must be on before the first estimator is created
+    RttEstimator::EnableErrorTracking ();
+  }
+
   LogComponentEnable ("RttExperiment", LOG_LEVEL_INFO);
 
   RttExperiment experiment;
+  experiment.SetTrajectories(trajectories);
+  experiment.SetHeartbeat(heartbeat);
+  experiment.SetSnapshot(snapshot);
+  experiment.SetResults(results);
+  experiment.SetWarmStart(warmStart);
 
-  experiment.Run();
+  if (trafficReplications > 0)
+  {
+    experiment.RunTrafficReplications(trafficReplications, jobs, seed);
+  }
+  else
+  {
+    experiment.Run();
+  }
 }
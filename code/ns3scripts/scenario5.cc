@@ -0,0 +1,422 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Scalability scenario family.
+ *
+ * Same network as scenario 1 (802.11b ad hoc, AODV, RandomWaypoint, bulk
+ * TCP flows with the FixedShare RTT estimator), but the number of nodes and
+ * flows are command line parameters, for networks of 50 to 1000 nodes and
+ * up to 10000 flows. The area grows with the number of nodes so that the
+ * node density stays that of the 20 nodes on 1500 x 1000 m of the other
+ * scenarios, and flows are drawn as unique node pairs.
+ *
+ * At the end of the run one "Scalability" line reports the wall time of
+ * the simulation, the peak RSS of the process and the share of the run
+ * spent in RTT estimator Measurement calls (from RttEstimatorStats), to see
+ * where the simulation and the estimator stop scaling. The time taken to
+ * build the topology is logged separately. Example:
+ *
+ *   ./waf --run "scratch/scenario5 --nodes=200 --flows=1000 --simTime=300"
+**/
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <unordered_set>
+#include <sys/resource.h>
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/aodv-module.h"
+#include "ns3/applications-module.h"
+#include "ns3/yans-wifi-helper.h"
+#include "ns3/flow-monitor.h"
+#include "ns3/flow-monitor-module.h"
+#include "ns3/flow-monitor-helper.h"
+#include "ns3/rtt-estimator-stats.h"
+#include "rtt-heartbeat.h"
+#include "rtt-results.h"
+#include "rtt-snapshot.h"
+#include "rtt-scheduler.h"
+#include "rtt-trajectory.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("RttExperiment");
+
+class RttExperiment
+{
+public:
+  RttExperiment(int numNodes, int numFlows, double simTime, double nodeSpeed, unsigned int seed);
+  void Run ();
+  void SetTrajectories (std::string trajectories);
+  void SetHeartbeat (double interval);
+  void SetSnapshot (double interval);
+  void SetResults (std::string results);
+  int GetNumFlows();
+  int GetNumNodes();
+
+private:
+  void BuildTopology ();
+  void RunTraffic (std::string outputPrefix);
+  void AppendResult (std::string outputPrefix, Ptr<FlowMonitor> flowmon, Ptr<FlowClassifier> classifier, double runSeconds);
+  std::vector<std::pair<int, int> > SelectPairs ();
+
+  uint32_t port;
+  int m_numFlows;
+  int m_numNodes;
+  double m_simTime;
+  double m_nodeSpeed;
+  double m_width;
+  double m_height;
+  std::string m_trajectories;
+  double m_heartbeat;
+  double m_snapshot;
+  std::string m_results;
+  std::mt19937 m_rng;
+  NodeContainer adhocNodes;
+  Ipv4InterfaceContainer adhocInterfaces;
+
+};
+
+RttExperiment::RttExperiment (int numNodes, int numFlows, double simTime, double nodeSpeed, unsigned int seed)
+  : port (1024),
+    m_numFlows(numFlows),
+    m_numNodes(numNodes),
+    m_simTime(simTime),
+    m_nodeSpeed(nodeSpeed),
+    m_heartbeat(0),
+    m_snapshot(0),
+    m_rng(seed)
+{
+  // Same density as 20 nodes on 1500 x 1000 m
+  double scale = std::sqrt (numNodes / 20.0);
+  m_width = 1500.0 * scale;
+  m_height = 1000.0 * scale;
+}
+
+int RttExperiment::GetNumFlows() { return m_numFlows; }
+int RttExperiment::GetNumNodes() { return m_numNodes; }
+
+void RttExperiment::SetTrajectories(std::string trajectories)
+{
+  // Precomputed trajectory file (see rtt-trajectory.h) replacing the RandomWaypoint mobility
+  m_trajectories = trajectories;
+}
+
+void RttExperiment::SetHeartbeat(double interval)
+{
+  // Wall seconds between two lines of the .heartbeat file, 0 for none
+  m_heartbeat = interval;
+}
+
+void RttExperiment::SetSnapshot(double interval)
+{
+  // Simulated seconds between two blocks of the .snapshot file, 0 for none
+  m_snapshot = interval;
+}
+
+void RttExperiment::SetResults(std::string results)
+{
+  // Results store directory (see rtt-results.h) each run appends a row to, empty for none
+  m_results = results;
+}
+
+void RttExperiment::Run()
+{
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now ();
+  BuildTopology();
+  NS_LOG_INFO("Topology built in " << std::chrono::duration<double> (std::chrono::steady_clock::now () - start).count () << " s");
+  RunTraffic("s5");
+  NS_LOG_INFO("Total wall time: " << std::chrono::duration<double> (std::chrono::steady_clock::now () - start).count () << " s");
+}
+
+void RttExperiment::BuildTopology()
+{
+  Packet::EnablePrinting ();
+
+  std::string phyMode ("DsssRate1Mbps");
+
+  Config::SetDefault ("ns3::TcpL4Protocol::RttEstimatorType", TypeIdValue(RttFixedShare::GetTypeId()));
+  Config::SetDefault ("ns3::BulkSendApplication::Protocol",   TypeIdValue (TcpSocketFactory::GetTypeId ()));
+  Config::SetDefault ("ns3::WifiRemoteStationManager::NonUnicastMode", StringValue (phyMode));
+  Config::SetDefault ("ns3::TcpSocket::SndBufSize", UintegerValue (16384));
+  Config::SetDefault ("ns3::TcpSocket::RcvBufSize", UintegerValue (16384));
+  Config::SetDefault ("ns3::RangePropagationLossModel::MaxRange", DoubleValue (100.0));
+  // Only deliver frames to the nodes within MaxRange, must not be smaller than it
+  Config::SetDefault ("ns3::YansWifiChannel::SpatialIndexRange", DoubleValue (100.0));
+  Config::SetDefault ("ns3::TcpSocket::DelAckCount", UintegerValue(1));
+
+  adhocNodes.Create (GetNumNodes());
+
+  WifiHelper wifi;
+  wifi.SetStandard (WIFI_PHY_STANDARD_80211b);
+
+  YansWifiPhyHelper wifiPhy =  YansWifiPhyHelper::Default ();
+  YansWifiChannelHelper wifiChannel;
+  wifiChannel.SetPropagationDelay ("ns3::ConstantSpeedPropagationDelayModel");
+  wifiChannel.AddPropagationLoss ("ns3::RangePropagationLossModel");
+
+  wifiPhy.SetChannel (wifiChannel.Create ());
+
+  WifiMacHelper wifiMac;
+  wifi.SetRemoteStationManager ("ns3::ConstantRateWifiManager",
+                                "DataMode",StringValue (phyMode),
+                                "ControlMode",StringValue (phyMode));
+
+  wifiMac.SetType ("ns3::AdhocWifiMac");
+
+  NetDeviceContainer adhocDevices = wifi.Install (wifiPhy, wifiMac, adhocNodes);
+
+  if (!m_trajectories.empty ())
+  {
+    TrajectoryFile trajectories (m_trajectories);
+    trajectories.Install (adhocNodes);
+    m_width = trajectories.GetHeader ().width;
+    m_height = trajectories.GetHeader ().height;
+  }
+  else
+  {
+    MobilityHelper mobilityAdhoc;
+    int64_t streamIndex = 0;
+
+    ObjectFactory pos;
+    pos.SetTypeId ("ns3::RandomRectanglePositionAllocator");
+    std::stringstream ssX;
+    ssX << "ns3::UniformRandomVariable[Min=0.0|Max=" << m_width << "]";
+    std::stringstream ssY;
+    ssY << "ns3::UniformRandomVariable[Min=0.0|Max=" << m_height << "]";
+    pos.Set ("X", StringValue (ssX.str ()));
+    pos.Set ("Y", StringValue (ssY.str ()));
+
+    Ptr<PositionAllocator> taPositionAlloc = pos.Create ()->GetObject<PositionAllocator> ();
+    streamIndex += taPositionAlloc->AssignStreams (streamIndex);
+
+    std::stringstream ssSpeed;
+    ssSpeed << "ns3::UniformRandomVariable[Min=1.0|Max=" << m_nodeSpeed << "]";
+    mobilityAdhoc.SetMobilityModel ("ns3::RandomWaypointMobilityModel",
+                                    "Speed", StringValue (ssSpeed.str ()),
+                                    "Pause", StringValue ("ns3::ConstantRandomVariable[Constant=0]"),
+                                    "PositionAllocator", PointerValue (taPositionAlloc));
+    mobilityAdhoc.SetPositionAllocator (taPositionAlloc);
+    mobilityAdhoc.Install (adhocNodes);
+    streamIndex += mobilityAdhoc.AssignStreams (adhocNodes, streamIndex);
+    NS_UNUSED (streamIndex);
+  }
+
+  AodvHelper aodv;
+  Ipv4ListRoutingHelper list;
+  InternetStackHelper internet;
+
+  internet.SetTcp("ns3::TcpL4Protocol");
+  list.Add (aodv, 100);
+  internet.SetRoutingHelper (list);
+  internet.Install (adhocNodes);
+
+  // A /16, for more than 254 nodes
+  Ipv4AddressHelper addressAdhoc;
+  addressAdhoc.SetBase ("10.1.0.0", "255.255.0.0");
+  adhocInterfaces = addressAdhoc.Assign (adhocDevices);
+}
+
+std::vector<std::pair<int, int> > RttExperiment::SelectPairs()
+{
+  // Like in the other scenarios, two flows must not share a node pair in
+  // either direction (see the flowMap comment in scenario1.cc), so the flows
+  // are drawn from the n (n - 1) / 2 unordered pairs.
+  uint64_t n = GetNumNodes();
+  uint64_t numPairs = n * (n - 1) / 2;
+  uint64_t numFlows = GetNumFlows();
+  NS_ABORT_MSG_IF (numFlows > numPairs, numFlows << " flows need more than the " << numPairs << " node pairs of " << n << " nodes");
+
+  std::vector<std::pair<int, int> > pairs;
+  if (numFlows * 2 <= numPairs)
+  {
+    // Sparse: rejection sampling, which takes less than two draws per flow
+    std::uniform_int_distribution<uint64_t> node (0, n - 1);
+    std::unordered_set<uint64_t> used;
+    while (pairs.size () < numFlows)
+    {
+      uint64_t a = node (m_rng);
+      uint64_t b = node (m_rng);
+      if (a == b || !used.insert (std::min (a, b) * n + std::max (a, b)).second)
+      {
+        continue;
+      }
+      pairs.push_back (std::make_pair ((int) a, (int) b));
+    }
+  }
+  else
+  {
+    // Dense: partial shuffle of every pair
+    std::vector<std::pair<int, int> > all;
+    all.reserve (numPairs);
+    for (uint64_t a = 0; a < n; a++)
+    {
+      for (uint64_t b = a + 1; b < n; b++)
+      {
+        all.push_back (std::make_pair ((int) a, (int) b));
+      }
+    }
+    for (uint64_t i = 0; i < numFlows; i++)
+    {
+      std::uniform_int_distribution<uint64_t> pick (i, numPairs - 1);
+      std::swap (all[i], all[pick (m_rng)]);
+      // Random direction
+      if (m_rng () & 1)
+      {
+        std::swap (all[i].first, all[i].second);
+      }
+      pairs.push_back (all[i]);
+    }
+  }
+  return pairs;
+}
+
+void RttExperiment::RunTraffic(std::string outputPrefix)
+{
+  std::vector<std::pair<int, int> > pairs = SelectPairs();
+  std::uniform_int_distribution<int> packets (1000, 100000); // Random number of packets between 1,000 and 100,000
+  std::uniform_int_distribution<int> start (0, static_cast<int>(m_simTime) - 1); // Time when to start sending data
+
+  Heartbeat heartbeat (outputPrefix + ".heartbeat", m_heartbeat);
+
+  for (size_t i = 0; i < pairs.size (); i++)
+  {
+    int senderIndex = pairs[i].first;
+    int receiverIndex = pairs[i].second;
+    int numPackets = packets (m_rng);
+    int startTime = start (m_rng);
+
+    NS_LOG_DEBUG("Flow from: " << senderIndex << " to: " << receiverIndex << ", " << numPackets << " packets at " << startTime << " s");
+
+    BulkSendHelper sendHelper ("ns3::TcpSocketFactory", (InetSocketAddress (adhocInterfaces.GetAddress (receiverIndex), port)));
+    ApplicationContainer senderApp = sendHelper.Install(adhocNodes.Get (senderIndex));
+    DynamicCast<BulkSendApplication> (senderApp.Get(0))->SetMaxBytes(512 * numPackets);
+
+    PacketSinkHelper sinkHelper ("ns3::TcpSocketFactory", InetSocketAddress(adhocInterfaces.GetAddress (receiverIndex), port++));
+    ApplicationContainer sinkApp = sinkHelper.Install(adhocNodes.Get (receiverIndex));
+
+    sinkApp.Start (Seconds (startTime));
+    senderApp.Start (Seconds (startTime));
+    sinkApp.Stop (Seconds (m_simTime));
+    senderApp.Stop (Seconds (m_simTime));
+    heartbeat.AddFlow (sinkApp.Get (0), 512 * numPackets, startTime, m_simTime);
+  }
+
+  Ptr<FlowMonitor> flowmon;
+  FlowMonitorHelper flowmonHelper;
+  flowmon = flowmonHelper.InstallAll ();
+  Snapshot snapshot (outputPrefix + ".snapshot", m_snapshot);
+
+  Simulator::Stop (Seconds (m_simTime));
+  heartbeat.Start ();
+  snapshot.Start (flowmon, flowmonHelper.GetClassifier ());
+  std::chrono::steady_clock::time_point runStart = std::chrono::steady_clock::now ();
+  double estimatorStart = RttEstimatorStats::GetMeasurementSeconds ();
+  Simulator::Run ();
+  double runSeconds = std::chrono::duration<double> (std::chrono::steady_clock::now () - runStart).count ();
+  double estimatorSeconds = RttEstimatorStats::GetMeasurementSeconds () - estimatorStart;
+  ReportScheduler (runSeconds);
+  if (RttEstimatorStats::IsEnabled ())
+  {
+    // Simulator::Destroy, which would print them, is never called
+    RttEstimatorStats::Dump ();
+  }
+
+  flowmon->SerializeToXmlFile (outputPrefix + ".flowmon", false, false);
+  AppendResult (outputPrefix, flowmon, flowmonHelper.GetClassifier (), runSeconds);
+
+  struct rusage usage;
+  getrusage (RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+  double peakRssMb = usage.ru_maxrss / (1024.0 * 1024.0); // Bytes on macOS
+#else
+  double peakRssMb = usage.ru_maxrss / 1024.0; // Kilobytes on Linux
+#endif
+
+  std::cout << "Scalability: " << GetNumNodes() << " nodes, " << pairs.size () << " flows, "
+            << m_width << " x " << m_height << " m, run " << runSeconds << " s, peak RSS "
+            << peakRssMb << " MB, estimator " << estimatorSeconds << " s ("
+            << (runSeconds > 0 ? 100 * estimatorSeconds / runSeconds : 0) << "% of the run)" << std::endl;
+}
+
+void RttExperiment::AppendResult(std::string outputPrefix, Ptr<FlowMonitor> flowmon, Ptr<FlowClassifier> classifier, double runSeconds)
+{
+  if (m_results.empty())
+  {
+    return;
+  }
+  RunResult result;
+  result.scenario = "s5";
+  result.prefix = outputPrefix;
+  result.seed = RngSeedManager::GetSeed();
+  result.run = RngSeedManager::GetRun();
+  result.flows = GetNumFlows();
+  result.nodes = GetNumNodes();
+  result.speed = m_nodeSpeed;
+  result.simTime = m_simTime;
+  result.SetEstimator(adhocNodes.Get(0));
+  result.SetErrors();
+  result.SetFlows(flowmon, classifier);
+  result.wallSeconds = runSeconds;
+  if (!result.Append(m_results))
+  {
+    NS_LOG_INFO("Could not append the run to the results store " << m_results);
+  }
+}
+
+
+int
+main (int argc, char *argv[])
+{
+  int nodes = 50;
+  int flows = 100;
+  double simTime = 25.0*60.0;
+  double speed = 50;
+  unsigned int seed = 1;
+  std::string trajectories;
+  std::string scheduler = "Map";
+  double heartbeat = 0;
+  double snapshot = 0;
+  std::string results;
+
+  CommandLine cmd;
+  cmd.AddValue ("nodes", "Number of nodes, the area grows with it at constant density", nodes);
+  cmd.AddValue ("flows", "Number of flows, each between a different pair of nodes", flows);
+  cmd.AddValue ("simTime", "Simulation time in seconds", simTime);
+  cmd.AddValue ("speed", "Max node speed in meters/second", speed);
+  cmd.AddValue ("seed", "Seed of the flow selection and of ns-3", seed);
+  cmd.AddValue ("trajectories", "Trajectory file from rtt-trajectory to play back instead of RandomWaypoint", trajectories);
+  cmd.AddValue ("scheduler", "Event scheduler: Map (default), Heap, List, Calendar or PriorityQueue", scheduler);
+  cmd.AddValue ("heartbeat", "Wall seconds between two progress lines of the .heartbeat file, 0 (default) for none", heartbeat);
+  cmd.AddValue ("snapshot", "Simulated seconds between two blocks of the .snapshot file, 0 (default) for none", snapshot);
+  cmd.AddValue ("results", "Results store directory each run appends a row to, e.g. rtt-results, empty (default) for none", results);
+  cmd.Parse (argc, argv);
+
+  NS_ABORT_MSG_IF (nodes < 2 || flows < 1 || simTime < 1, "Need at least 2 nodes, 1 flow and 1 s");
+  NS_ABORT_MSG_IF (1024 + flows > 65535, "Too many flows for the port range");
+
+  // The estimator share comes from RttEstimatorStats, which must be enabled
+  // before the first estimator is created
+  GlobalValue::Bind ("RttEstimatorStats", BooleanValue (true));
+  RngSeedManager::SetSeed (seed);
+  SelectScheduler (scheduler);
+  if (snapshot > 0 || !results.empty ())
+  {
+    // Must be on before the first estimator is created
+    RttEstimator::EnableErrorTracking ();
+  }
+
+  LogComponentEnable ("RttExperiment", LOG_LEVEL_INFO);
+
+  RttExperiment experiment (nodes, flows, simTime, speed, seed);
+  experiment.SetTrajectories(trajectories);
+  experiment.SetHeartbeat(heartbeat);
+  experiment.SetSnapshot(snapshot);
+  experiment.SetResults(results);
+  experiment.Run();
+}
@@ -0,0 +1,50 @@
+# Scheduler benchmark. Runs each scenario under each event scheduler and prints a table of the
+# events processed, wall time, events per second and peak event queue size of every run.
+# The scenarios must be in ns-3's scratch folder together with rtt-scheduler.h.
+
+import os
+import re
+import subprocess
+
+# ns-3.30.1/ folder, the runs are started from there
+pathstr = "/Users/kevin/Downloads/ns-allinone-3.30.1/ns-3.30.1"
+
+scenarios = ["scenario1", "scenario2", "scenario3", "scenario4"]
+schedulers = ["Map", "Heap", "List", "Calendar", "PriorityQueue"]
+
+# Extra arguments of every run, e.g. "--trajectories=traj.bin" so that all runs see the same motion
+extraargs = ""
+
+# Scheduler ns3::MapScheduler: 123 events processed in 4.5 s (27.3 events/s), 130 scheduled, peak queue size 12
+pattern = re.compile(r"Scheduler (\S+): (\d+) events processed in ([\d.e+-]+) s \(([\d.e+-]+) events/s\)"
+                     r"(?:, (\d+) scheduled, peak queue size (\d+))?")
+
+results = []
+for scenario in scenarios:
+    for scheduler in schedulers:
+        command = "./waf --run \"scratch/" + scenario + " --scheduler=" + scheduler + " " + extraargs + "\""
+        print ("Running", command)
+        # No NS_LOG, so that logging does not weigh on the timings
+        env = dict(os.environ)
+        env.pop("NS_LOG", None)
+        run = subprocess.run(command, shell=True, cwd=pathstr, env=env,
+                             stdout=subprocess.PIPE, stderr=subprocess.STDOUT, universal_newlines=True)
+        match = pattern.search(run.stdout)
+        if match is None:
+            # Most likely the tcp-tx-buffer.cc ASSERT (see Misc in README.txt)
+            print ("  failed, no Scheduler line in the output")
+            continue
+        results.append((scenario, scheduler, int(match.group(2)), float(match.group(3)),
+                        float(match.group(4)), match.group(6) or "-"))
+
+print ()
+print ("%-10s %-14s %14s %10s %14s %10s" % ("Scenario", "Scheduler", "Events", "Wall (s)", "Events/s", "Peak queue"))
+for r in results:
+    print ("%-10s %-14s %14d %10.1f %14.0f %10s" % r)
+
+# Fastest scheduler of each scenario
+for scenario in scenarios:
+    runs = [r for r in results if r[0] == scenario]
+    if runs:
+        best = max(runs, key=lambda r: r[4])
+        print ("Fastest for", scenario + ":", best[1], "(%.0f events/s)" % best[4])
@@ -0,0 +1,81 @@
+# Snapshot parser. For retreving the RTT mean error, delivery ratio, retransmission ratio and goodput
+# of a run from its .snapshot file, also when the run was aborted before writing its .flowmon file.
+
+pathstr = "/Users/kevin/Downloads/ns-allinone-3.30.1/ns-3.30.1/s4.snapshot"
+
+fdata = []
+with open (pathstr) as file:
+    fdata = file.read().splitlines()
+
+# Last complete snapshot, the one before the last "end" line (a crash may cut the one after it)
+lines = []
+time = None
+block = []
+for line in fdata:
+    fields = line.split()
+    if not fields:
+        continue
+    if fields[0] == "snapshot":
+        block = []
+        blockTime = float(fields[1])
+    elif fields[0] == "end":
+        lines = block
+        time = blockTime
+    else:
+        block.append(fields)
+
+if time is None:
+    print ("No complete snapshot in", pathstr)
+    exit(1)
+
+print ("Snapshot at", time, "s")
+
+# Same as MeanError.py, which only sees the estimators destroyed during the run
+num = 0
+den = 0
+for fields in lines:
+    if fields[0] != "estimator" or fields[2] != "done":
+        continue
+    err = float(fields[3])
+    weight = float(fields[4])
+    if (weight > 1):
+        num += (err * weight)
+        den += weight
+
+if den > 0:
+    print ("Average error: ", num/den, " with a weight of: ", den)
+
+# Same as FlowmonParser.py: TCP flows with more than one packet and some transmit and receive time
+# flow id protocol src srcPort dst dstPort txPackets rxPackets txBytes rxBytes lostPackets firstTx lastTx firstRx lastRx
+goodputSum = 0
+deliveryRatioSum = 0
+retransmitSum = 0
+txPacketSum = 0
+
+for fields in lines:
+    if fields[0] != "flow" or fields[2] != "6":
+        continue
+    txPackets = float(fields[7])
+    rxPackets = float(fields[8])
+    firstTx = int(fields[12])
+    lastTx = int(fields[13])
+    # Convert from ns to seconds
+    firstRx = int(fields[14]) / 1e+9
+    lastRx = int(fields[15]) / 1e+9
+    if txPackets <= 1 or firstRx == lastRx or firstTx == lastTx:
+        continue
+
+    # Unit: packets/second
+    rxRate = rxPackets / (lastRx - firstRx)
+
+    txPacketSum += txPackets
+    retransmitSum += (txPackets - rxPackets)
+    deliveryRatioSum += rxPackets
+    goodputSum += rxRate * txPackets
+
+if txPacketSum > 0:
+    # Weighted average of each where weight is based on transmitted packets
+    print('Packet weight: ', txPacketSum)
+    print('Goodput (p/s): ', goodputSum/txPacketSum)
+    print('Delivery ratio(%): ', deliveryRatioSum/txPacketSum)
+    print('Retransmit ratio(%): ', retransmitSum/txPacketSum)
@@ -0,0 +1,194 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+#if defined (__x86_64__) || defined (__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "rtt-estimator-stats.h"
+#include "ns3/boolean.h"
+#include "ns3/global-value.h"
+#include "ns3/simulator.h"
+
+namespace ns3 {
+
+/// Enables the RTT estimator stats registry
+static GlobalValue g_rttEstimatorStats =
+  GlobalValue ("RttEstimatorStats",
+               "Count RTT estimator calls and time Measurement, dumped at the end of the run",
+               BooleanValue (false),
+               MakeBooleanChecker ());
+
+namespace {
+
+std::chrono::steady_clock::time_point g_startTime; //!< Wall time when enabled
+uint64_t g_startCycles = 0;                         //!< Cycle counter when enabled
+bool g_dumped = false;                              //!< Whether Dump was called
+
+const char *g_eventNames[RttEstimatorStats::EVENT_COUNT] = {
+  "weight-underflow",
+  "zero-denominator",
+  "share-boost"
+};
+
+/// Dumps the counters at Simulator::Destroy, unless the program already did
+void
+DumpAtDestroy (void)
+{
+  if (!g_dumped)
+    {
+      RttEstimatorStats::Dump ();
+    }
+}
+
+} // anonymous namespace
+
+bool
+RttEstimatorStats::Initialize (void)
+{
+  BooleanValue enabled;
+  g_rttEstimatorStats.GetValue (enabled);
+  if (enabled.Get ())
+    {
+      g_startTime = std::chrono::steady_clock::now ();
+      g_startCycles = ReadCycles ();
+      Simulator::ScheduleDestroy (&DumpAtDestroy);
+    }
+  return enabled.Get ();
+}
+
+std::map<std::string, RttEstimatorStats::Counters> &
+RttEstimatorStats::GetRegistry (void)
+{
+  static std::map<std::string, Counters> registry;
+  return registry;
+}
+
+RttEstimatorStats::Counters &
+RttEstimatorStats::GetCounters (const std::string &typeName)
+{
+  std::map<std::string, Counters> &registry = GetRegistry ();
+  std::map<std::string, Counters>::iterator it = registry.find (typeName);
+  if (it == registry.end ())
+    {
+      Counters counters;
+      std::memset (&counters, 0, sizeof (counters));
+      it = registry.insert (std::make_pair (typeName, counters)).first;
+    }
+  return it->second;
+}
+
+uint64_t
+RttEstimatorStats::ReadCycles (void)
+{
+#if defined (__x86_64__) || defined (__i386__)
+  return __rdtsc ();
+#else
+  // Without a cycle counter, count nanoseconds instead
+  return std::chrono::duration_cast<std::chrono::nanoseconds> (
+    std::chrono::steady_clock::now ().time_since_epoch ()).count ();
+#endif
+}
+
+void
+RttEstimatorStats::RecordMeasurement (Counters &counters, uint64_t cycles)
+{
+  counters.measurements++;
+  counters.cycles += cycles;
+  uint32_t bucket = 0;
+  while (cycles > 1 && bucket < HISTOGRAM_BUCKETS - 1)
+    {
+      cycles >>= 1;
+      bucket++;
+    }
+  counters.histogram[bucket]++;
+}
+
+double
+RttEstimatorStats::GetWallSeconds (void)
+{
+  if (!IsEnabled ())
+    {
+      return 0;
+    }
+  return std::chrono::duration<double> (std::chrono::steady_clock::now () - g_startTime).count ();
+}
+
+double
+RttEstimatorStats::GetMeasurementSeconds (void)
+{
+  double wallSeconds = GetWallSeconds ();
+  uint64_t elapsedCycles = ReadCycles () - g_startCycles;
+  if (wallSeconds <= 0 || elapsedCycles == 0)
+    {
+      return 0;
+    }
+
+  // Convert with the cycle rate observed since the registry was enabled
+  uint64_t cycles = 0;
+  std::map<std::string, Counters> &registry = GetRegistry ();
+  for (std::map<std::string, Counters>::const_iterator it = registry.begin (); it != registry.end (); it++)
+    {
+      cycles += it->second.cycles;
+    }
+  return cycles * wallSeconds / elapsedCycles;
+}
+
+void
+RttEstimatorStats::Dump (void)
+{
+  g_dumped = true;
+  std::map<std::string, Counters> &registry = GetRegistry ();
+  for (std::map<std::string, Counters>::const_iterator it = registry.begin (); it != registry.end (); it++)
+    {
+      const Counters &c = it->second;
+      std::clog << "RttEstimatorStats " << it->first
+                << " constructions " << c.constructions
+                << " copies " << c.copies
+                << " resets " << c.resets
+                << " measurements " << c.measurements
+                << " cycles " << c.cycles
+                << " cycles/measurement " << (c.measurements ? c.cycles / c.measurements : 0);
+      for (uint32_t e = 0; e < EVENT_COUNT; e++)
+        {
+          std::clog << " " << g_eventNames[e] << " " << c.events[e];
+        }
+      std::clog << std::endl;
+
+      std::clog << "RttEstimatorStats " << it->first << " histogram";
+      for (uint32_t b = 0; b < HISTOGRAM_BUCKETS; b++)
+        {
+          if (c.histogram[b])
+            {
+              std::clog << " 2^" << b << ":" << c.histogram[b];
+            }
+        }
+      std::clog << std::endl;
+    }
+
+  double wallSeconds = GetWallSeconds ();
+  double measurementSeconds = GetMeasurementSeconds ();
+  std::clog << "RttEstimatorStats Measurement time " << measurementSeconds << " s of "
+            << wallSeconds << " s wall time ("
+            << (wallSeconds > 0 ? 100.0 * measurementSeconds / wallSeconds : 0) << "%)" << std::endl;
+}
+
+} // namespace ns3
@@ -0,0 +1,164 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef RTT_ESTIMATOR_STATS_H
+#define RTT_ESTIMATOR_STATS_H
+
+#include <map>
+#include <string>
+#include <stdint.h>
+
+namespace ns3 {
+
+/**
+ * \ingroup tcp
+ *
+ * \brief Registry of hot-path counters for the RTT estimators
+ *
+ * For each estimator type, the registry counts constructions, Copy,
+ * Reset and Measurement calls, the cycles spent in Measurement (in total
+ * and as a log2 histogram), and numeric events such as weight underflow.
+ * The counters are dumped to std::clog, together with an estimate of
+ * the share of the wall time spent in Measurement, by Dump or, if it was
+ * never called, when Simulator::Destroy runs.
+ *
+ * The registry is always compiled in but off by default; when off, each
+ * instrumented call costs a single branch.  It is turned on with the
+ * "RttEstimatorStats" global value, e.g. --RttEstimatorStats=1 on the
+ * command line or NS_GLOBAL_VALUE="RttEstimatorStats=1", which must be
+ * set before the first estimator is created.
+ */
+class RttEstimatorStats
+{
+public:
+  /**
+   * \brief Numeric events counted by the registry
+   */
+  enum Event
+  {
+    WEIGHT_UNDERFLOW = 0, //!< The total weight fell below the normal double range
+    ZERO_DENOMINATOR,     //!< The prediction had a zero or invalid denominator
+    SHARE_BOOST,          //!< The share rate was boosted after a route change
+    EVENT_COUNT           //!< Number of events, not an event
+  };
+
+  /// Number of buckets of the cycle histogram
+  static const uint32_t HISTOGRAM_BUCKETS = 32;
+
+  /**
+   * \brief Counters of one estimator type
+   */
+  struct Counters
+  {
+    uint64_t constructions;                  //!< Objects constructed, copies included
+    uint64_t copies;                         //!< Copy calls
+    uint64_t resets;                         //!< Reset calls
+    uint64_t measurements;                   //!< Measurement calls
+    uint64_t cycles;                         //!< Cycles spent in Measurement
+    uint64_t histogram[HISTOGRAM_BUCKETS];   //!< Measurement calls by floor (log2 (cycles))
+    uint64_t events[EVENT_COUNT];            //!< Numeric events
+  };
+
+  /**
+   * \return true if the registry is enabled
+   */
+  static bool IsEnabled (void)
+  {
+    static bool enabled = Initialize ();
+    return enabled;
+  }
+
+  /**
+   * \brief Gets the counters of an estimator type, creating them if needed
+   *
+   * Meant to be called once per type and cached by the caller.
+   *
+   * \param typeName the name of the estimator type
+   * \return the counters of that type
+   */
+  static Counters &GetCounters (const std::string &typeName);
+
+  /**
+   * \return the current value of the cycle counter
+   */
+  static uint64_t ReadCycles (void);
+
+  /**
+   * \brief Adds the cost of one Measurement call
+   * \param counters the counters of the estimator type
+   * \param cycles the cycles spent in the call
+   */
+  static void RecordMeasurement (Counters &counters, uint64_t cycles);
+
+  /**
+   * \return the estimated time spent in Measurement by all types, in seconds
+   */
+  static double GetMeasurementSeconds (void);
+
+  /**
+   * \return the wall time since the registry was enabled, in seconds
+   */
+  static double GetWallSeconds (void);
+
+  /**
+   * \brief Prints every counter to std::clog
+   */
+  static void Dump (void);
+
+  /**
+   * \brief Times a Measurement call for the lifetime of the object
+   */
+  class MeasurementTimer
+  {
+  public:
+    /**
+     * \brief Starts timing if the registry is enabled
+     * \param counters the counters of the estimator type
+     */
+    MeasurementTimer (Counters &counters)
+      : m_counters (counters),
+        m_start (IsEnabled () ? ReadCycles () : 0)
+    {
+    }
+    ~MeasurementTimer ()
+    {
+      if (IsEnabled ())
+        {
+          RecordMeasurement (m_counters, ReadCycles () - m_start);
+        }
+    }
+  private:
+    Counters &m_counters; //!< Counters to update
+    uint64_t m_start;     //!< Cycle counter at construction
+  };
+
+private:
+  /**
+   * \brief Reads the global value and schedules the dump
+   * \return true if the registry is enabled
+   */
+  static bool Initialize (void);
+
+  /**
+   * \return the registry, by type name
+   */
+  static std::map<std::string, Counters> &GetRegistry (void);
+};
+
+} // namespace ns3
+
+#endif /* RTT_ESTIMATOR_STATS_H */
@@ -25,13 +25,32 @@
 // Base class allows variations of round trip time estimators to be
 // implemented
 
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
 #include <iostream>
 #include <cmath>
+#include <limits>
+#include <list>
+#include <map>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <thread>
 
 #include "rtt-estimator.h"
+#include "rtt-estimator-stats.h"
+#include "rtt-fixed-share-prior.h"
+#include "ns3/abort.h"
+#include "ns3/boolean.h"
 #include "ns3/double.h"
+#include "ns3/enum.h"
 #include "ns3/integer.h"
 #include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/object-factory.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
 
 namespace ns3 {
 
@@ -42,6 +61,115 @@ NS_OBJECT_ENSURE_REGISTERED (RttEstimator);
 /// Tolerance used to check reciprocal of two numbers.
 static const double TOLERANCE = 1e-6;
 
+/// Version of the records written by RttEstimator::Serialize
+static const uint8_t SERIALIZATION_VERSION = 4;
+
+/// Largest number of experts or trackers a serialized state may hold
+static const uint32_t SERIALIZATION_MAX_SIZE = 1 << 20;
+
+namespace {
+
+/**
+ * \brief Helpers for the binary records of RttEstimator::Serialize
+ *
+ * Values are written as their in-memory bytes.  The readers leave the
+ * stream failed when a record is truncated, which Deserialize reports.
+ */
+template <typename T>
+void
+WriteValue (std::ostream &os, const T &value)
+{
+  os.write (reinterpret_cast<const char *> (&value), sizeof (T));
+}
+
+template <typename T>
+T
+ReadValue (std::istream &is)
+{
+  T value = T ();
+  is.read (reinterpret_cast<char *> (&value), sizeof (T));
+  return value;
+}
+
+void
+WriteTime (std::ostream &os, Time t)
+{
+  WriteValue<int64_t> (os, t.GetTimeStep ());
+}
+
+Time
+ReadTime (std::istream &is)
+{
+  return TimeStep (ReadValue<int64_t> (is));
+}
+
+void
+WriteString (std::ostream &os, const std::string &str)
+{
+  WriteValue<uint32_t> (os, str.size ());
+  os.write (str.data (), str.size ());
+}
+
+std::string
+ReadString (std::istream &is)
+{
+  uint32_t size = ReadValue<uint32_t> (is);
+  if (!is || size > SERIALIZATION_MAX_SIZE)
+    {
+      is.setstate (std::ios::failbit);
+      return std::string ();
+    }
+  std::string str (size, '\0');
+  is.read (&str[0], size);
+  return str;
+}
+
+void
+WriteDoubles (std::ostream &os, const double *values, uint32_t n)
+{
+  WriteValue<uint32_t> (os, n);
+  os.write (reinterpret_cast<const char *> (values), n * sizeof (double));
+}
+
+std::vector<double>
+ReadDoubles (std::istream &is)
+{
+  uint32_t n = ReadValue<uint32_t> (is);
+  if (!is || n > SERIALIZATION_MAX_SIZE)
+    {
+      is.setstate (std::ios::failbit);
+      return std::vector<double> ();
+    }
+  std::vector<double> values (n);
+  is.read (reinterpret_cast<char *> (values.data ()), n * sizeof (double));
+  return values;
+}
+
+/// Whether new estimators are tracked for RttEstimator::GetErrorSnapshot
+bool g_trackErrors = false;
+
+/**
+ * \return the tracked estimators that are alive
+ */
+std::set<RttEstimator *> &
+LiveEstimators (void)
+{
+  static std::set<RttEstimator *> live;
+  return live;
+}
+
+/**
+ * \return the errors of the tracked estimators that were destroyed
+ */
+std::vector<RttEstimator::ErrorRecord> &
+RetiredErrors (void)
+{
+  static std::vector<RttEstimator::ErrorRecord> retired;
+  return retired;
+}
+
+} // anonymous namespace
+
 TypeId 
 RttEstimator::GetTypeId (void)
 {
@@ -84,6 +212,10 @@ RttEstimator::RttEstimator ()
   m_estimatedVariation = Time (0);
   NS_LOG_DEBUG ("Initialize m_estimatedRtt to " << m_estimatedRtt.GetSeconds () << " sec.");
   NS_LOG_DEBUG ("Initialize m_estimatedVariation to " << m_estimatedVariation.GetSeconds () << " sec.");
+  if (g_trackErrors)
+    {
+      LiveEstimators ().insert (this);
+    }
 }
 
 RttEstimator::RttEstimator (const RttEstimator& c)
@@ -94,11 +226,19 @@ RttEstimator::RttEstimator (const RttEstimator& c)
     m_nSamples (c.m_nSamples)
 {
   NS_LOG_FUNCTION (this);
+  if (g_trackErrors)
+    {
+      LiveEstimators ().insert (this);
+    }
 }
 
 RttEstimator::~RttEstimator ()
 {
   NS_LOG_FUNCTION (this);
+  if (g_trackErrors)
+    {
+      LiveEstimators ().erase (this);
+    }
 }
 
 TypeId
@@ -119,15 +259,163 @@ void RttEstimator::Reset ()
 uint32_t 
 RttEstimator::GetNSamples (void) const
 {
+  Synchronize ();
   return m_nSamples;
 }
 
+void
+RttEstimator::Serialize (std::ostream &os) const
+{
+  NS_LOG_FUNCTION (this);
+  Synchronize ();
+  WriteString (os, GetInstanceTypeId ().GetName ());
+  WriteValue<uint8_t> (os, SERIALIZATION_VERSION);
+  WriteTime (os, m_initialEstimatedRtt);
+  WriteTime (os, m_estimatedRtt);
+  WriteTime (os, m_estimatedVariation);
+  WriteValue<uint32_t> (os, m_nSamples);
+  DoSerialize (os);
+}
+
+bool
+RttEstimator::Deserialize (std::istream &is)
+{
+  NS_LOG_FUNCTION (this);
+  std::string name = ReadString (is);
+  if (!is || name != GetInstanceTypeId ().GetName ())
+    {
+      NS_LOG_WARN ("Cannot restore a state of " << name << " into " << GetInstanceTypeId ().GetName ());
+      return false;
+    }
+  return DeserializeState (is);
+}
+
+Ptr<RttEstimator>
+RttEstimator::CreateFromSerialized (std::istream &is)
+{
+  std::string name = ReadString (is);
+  TypeId tid;
+  if (!is || !TypeId::LookupByNameFailSafe (name, &tid))
+    {
+      NS_LOG_WARN ("Unknown estimator type " << name);
+      return 0;
+    }
+  ObjectFactory factory;
+  factory.SetTypeId (tid);
+  Ptr<RttEstimator> rtt = factory.Create<RttEstimator> ();
+  if (rtt == 0 || !rtt->DeserializeState (is))
+    {
+      return 0;
+    }
+  return rtt;
+}
+
+bool
+RttEstimator::DeserializeState (std::istream &is)
+{
+  Synchronize ();
+  if (ReadValue<uint8_t> (is) != SERIALIZATION_VERSION || !is)
+    {
+      NS_LOG_WARN ("Unsupported or truncated estimator state");
+      return false;
+    }
+  Time initialEstimatedRtt = m_initialEstimatedRtt;
+  Time estimatedRtt = m_estimatedRtt;
+  Time estimatedVariation = m_estimatedVariation;
+  uint32_t nSamples = m_nSamples;
+  m_initialEstimatedRtt = ReadTime (is);
+  m_estimatedRtt = ReadTime (is);
+  m_estimatedVariation = ReadTime (is);
+  m_nSamples = ReadValue<uint32_t> (is);
+  if (!is || !DoDeserialize (is) || !is)
+    {
+      // Keep the previous estimate
+      NS_LOG_WARN ("Truncated or invalid estimator state");
+      m_initialEstimatedRtt = initialEstimatedRtt;
+      m_estimatedRtt = estimatedRtt;
+      m_estimatedVariation = estimatedVariation;
+      m_nSamples = nSamples;
+      return false;
+    }
+  return true;
+}
+
+void
+RttEstimator::DoSerialize (std::ostream &os) const
+{
+}
+
+bool
+RttEstimator::DoDeserialize (std::istream &is)
+{
+  return true;
+}
+
+void
+RttEstimator::Synchronize (void) const
+{
+}
+
+bool
+RttEstimator::GetErrorSum (double &errorSum, uint32_t &samples) const
+{
+  return false;
+}
+
+void
+RttEstimator::EnableErrorTracking (void)
+{
+  g_trackErrors = true;
+}
+
+std::vector<RttEstimator::ErrorRecord>
+RttEstimator::GetErrorSnapshot (void)
+{
+  std::vector<ErrorRecord> records = RetiredErrors ();
+  std::set<RttEstimator *> &live = LiveEstimators ();
+  for (std::set<RttEstimator *>::const_iterator it = live.begin (); it != live.end (); it++)
+    {
+      ErrorRecord record;
+      if ((*it)->GetErrorSum (record.errorSum, record.samples) && record.samples > 0)
+        {
+          record.typeName = (*it)->GetInstanceTypeId ().GetName ();
+          record.live = true;
+          records.push_back (record);
+        }
+    }
+  return records;
+}
+
+void
+RttEstimator::RetireErrors (void)
+{
+  if (!g_trackErrors || LiveEstimators ().erase (this) == 0)
+    {
+      return;
+    }
+  ErrorRecord record;
+  if (GetErrorSum (record.errorSum, record.samples) && record.samples > 0)
+    {
+      record.typeName = GetInstanceTypeId ().GetName ();
+      record.live = false;
+      RetiredErrors ().push_back (record);
+    }
+}
+
 //-----------------------------------------------------------------------------
 //-----------------------------------------------------------------------------
 // Mean-Deviation Estimator
 
 NS_OBJECT_ENSURE_REGISTERED (RttMeanDeviation);
 
+/// \return the stats counters of RttMeanDeviation
+static RttEstimatorStats::Counters &
+MeanDeviationStats (void)
+{
+  static RttEstimatorStats::Counters &counters = RttEstimatorStats::GetCounters ("ns3::RttMeanDeviation");
+  return counters;
+}
+
 TypeId 
 RttMeanDeviation::GetTypeId (void)
 {
@@ -150,14 +438,25 @@ RttMeanDeviation::GetTypeId (void)
 }
 
 RttMeanDeviation::RttMeanDeviation()
+  : m_diagSamples (0),
+    m_diagErrorSum (0)
 {
   NS_LOG_FUNCTION (this);
+  if (RttEstimatorStats::IsEnabled ())
+    {
+      MeanDeviationStats ().constructions++;
+    }
 }
 
 RttMeanDeviation::RttMeanDeviation (const RttMeanDeviation& c)
-  : RttEstimator (c), m_alpha (c.m_alpha), m_beta (c.m_beta)
+  : RttEstimator (c), m_alpha (c.m_alpha), m_beta (c.m_beta),
+    m_diagSamples (0), m_diagErrorSum (0)
 {
   NS_LOG_FUNCTION (this);
+  if (RttEstimatorStats::IsEnabled ())
+    {
+      MeanDeviationStats ().constructions++;
+    }
 }
 
 TypeId
@@ -241,8 +540,10 @@ RttMeanDeviation::IntegerUpdate (Time m, uint32_t rttShift, uint32_t variationSh
 void 
 RttMeanDeviation::Measurement (Time m)
 {
-  m_estimates.push_back(m_estimatedRtt.GetMilliSeconds());
-  m_actuals.push_back(m.GetMilliSeconds()); 
+  RttEstimatorStats::MeasurementTimer timer (MeanDeviationStats ());
+
+  m_diagErrorSum += std::abs(m_estimatedRtt.GetMilliSeconds() - m.GetMilliSeconds());
+  m_diagSamples++;
 
   if (m_nSamples)
     { 
@@ -274,6 +575,10 @@ Ptr<RttEstimator>
 RttMeanDeviation::Copy () const
 {
   NS_LOG_FUNCTION (this);
+  if (RttEstimatorStats::IsEnabled ())
+    {
+      MeanDeviationStats ().copies++;
+    }
   return CopyObject<RttMeanDeviation> (this);
 }
 
@@ -281,30 +586,62 @@ void
 RttMeanDeviation::Reset ()
 { 
   NS_LOG_FUNCTION (this);
+  if (RttEstimatorStats::IsEnabled ())
+    {
+      MeanDeviationStats ().resets++;
+    }
   RttEstimator::Reset ();
 }
 
+void
+RttMeanDeviation::DoSerialize (std::ostream &os) const
+{
+  WriteValue<double> (os, m_alpha);
+  WriteValue<double> (os, m_beta);
+  WriteValue<uint32_t> (os, m_diagSamples);
+  WriteValue<int64_t> (os, m_diagErrorSum);
+}
+
+bool
+RttMeanDeviation::DoDeserialize (std::istream &is)
+{
+  double alpha = ReadValue<double> (is);
+  double beta = ReadValue<double> (is);
+  uint32_t diagSamples = ReadValue<uint32_t> (is);
+  int64_t diagErrorSum = ReadValue<int64_t> (is);
+  if (!is || !(alpha >= 0 && alpha <= 1) || !(beta >= 0 && beta <= 1) || diagErrorSum < 0)
+    {
+      return false;
+    }
+  m_alpha = alpha;
+  m_beta = beta;
+  m_diagSamples = diagSamples;
+  m_diagErrorSum = diagErrorSum;
+  return true;
+}
+
 RttMeanDeviation::~RttMeanDeviation ()
 {
   // NS_LOG_DEBUG("In destructor");
-  if (m_actuals.size() > 0)
+  RetireErrors();
+  if (m_diagSamples > 0)
   {
     PrintDiagnostics();
   }
 }
 
-void RttMeanDeviation::PrintDiagnostics()
+bool RttMeanDeviation::GetErrorSum(double &errorSum, uint32_t &samples) const
 {
-  double differenceSum = 0;
-
-  for (int i = 0; i < m_actuals.size(); i++)
-  {
-    differenceSum += abs((double)m_estimates[i] - (double)m_actuals[i]);
-  }
+  errorSum = m_diagErrorSum;
+  samples = m_diagSamples;
+  return true;
+}
 
-  differenceSum /= (double)m_actuals.size();
+void RttMeanDeviation::PrintDiagnostics()
+{
+  double differenceSum = (double)m_diagErrorSum / (double)m_diagSamples;
 
-  NS_LOG_DEBUG("Mean error of " << differenceSum << " with a weight of " << m_actuals.size());
+  NS_LOG_DEBUG("Mean error of " << differenceSum << " with a weight of " << m_diagSamples);
   
 }
 
@@ -314,6 +651,354 @@ void RttMeanDeviation::PrintDiagnostics()
 
 NS_OBJECT_ENSURE_REGISTERED(RttFixedShare);
 
+/// \return the stats counters of RttFixedShare
+static RttEstimatorStats::Counters &
+FixedShareStats (void)
+{
+  static RttEstimatorStats::Counters &counters = RttEstimatorStats::GetCounters ("ns3::RttFixedShare");
+  return counters;
+}
+
+namespace {
+
+/**
+ * \ingroup tcp
+ *
+ * \brief Pool of per-expert state for RttFixedShare
+ *
+ * Every RttFixedShare needs the weights and losses of its experts.  They
+ * are handed out as fixed-size slabs of 2 * NumExperts doubles, carved
+ * out of larger cache-aligned chunks, so the estimators of flows created
+ * in sequence sit next to each other in memory.  Released slabs are kept
+ * on a free list and reused by later connections instead of going back
+ * to the allocator.  The expert grid itself is read-only and shared by
+ * all estimators of the same size.
+ *
+ * There is one pool per simulation, as estimators do not know their node.
+ */
+class RttFixedSharePool
+{
+public:
+  /**
+   * \param numExperts the number of experts
+   * \return a slab of 2 * numExperts doubles: the weights, then the losses
+   */
+  static double *Allocate (int numExperts)
+  {
+    SizeClass &sc = GetSizeClass (numExperts);
+    if (sc.freeList.empty ())
+      {
+        // Slabs are padded to a whole number of cache lines
+        uint32_t slabDoubles = (2 * numExperts + DOUBLES_PER_LINE - 1) / DOUBLES_PER_LINE * DOUBLES_PER_LINE;
+        sc.chunks.push_back (std::vector<double> (slabDoubles * SLABS_PER_CHUNK + DOUBLES_PER_LINE));
+        std::vector<double> &chunk = sc.chunks.back ();
+        uintptr_t base = reinterpret_cast<uintptr_t> (&chunk[0]);
+        double *slab = &chunk[(LINE_SIZE - base % LINE_SIZE) % LINE_SIZE / sizeof (double)];
+        // Hand out the lowest addresses first
+        for (uint32_t i = SLABS_PER_CHUNK; i > 0; i--)
+          {
+            sc.freeList.push_back (slab + (i - 1) * slabDoubles);
+          }
+      }
+    double *slab = sc.freeList.back ();
+    sc.freeList.pop_back ();
+    return slab;
+  }
+
+  /**
+   * \param numExperts the number of experts the slab was allocated for
+   * \param slab the slab to give back
+   */
+  static void Release (int numExperts, double *slab)
+  {
+    GetSizeClass (numExperts).freeList.push_back (slab);
+  }
+
+  /**
+   * \param numExperts the number of experts
+   * \return the shared expert grid
+   */
+  static const double *GetExperts (int numExperts)
+  {
+    return &GetSizeClass (numExperts).experts[0];
+  }
+
+private:
+  static const uint32_t LINE_SIZE = 64;                                //!< Cache line size, in bytes
+  static const uint32_t DOUBLES_PER_LINE = LINE_SIZE / sizeof (double); //!< Doubles per cache line
+  static const uint32_t SLABS_PER_CHUNK = 32;                          //!< Slabs allocated at once
+
+  /**
+   * \brief Slabs and expert grid for one number of experts
+   */
+  struct SizeClass
+  {
+    std::vector<double> experts;           //!< Shared expert grid
+    std::vector<double *> freeList;        //!< Slabs ready to be handed out
+    std::list<std::vector<double> > chunks; //!< Backing storage of the slabs
+  };
+
+  /**
+   * \param numExperts the number of experts
+   * \return the size class, created on first use
+   */
+  static SizeClass &GetSizeClass (int numExperts)
+  {
+    static std::map<int, SizeClass> sizeClasses;
+    SizeClass &sc = sizeClasses[numExperts];
+    if (sc.experts.empty ())
+      {
+        sc.experts = RttFixedShare::GetExpertGrid (numExperts);
+      }
+    return sc;
+  }
+};
+
+/**
+ * \brief First half of the Fixed Share update of an expert grid
+ *
+ * Computes the loss of every expert against the actual value, then
+ * applies the exponential update to the weights.
+ *
+ * \param experts the expert predictions
+ * \param weights the expert weights, updated
+ * \param losses the expert losses, overwritten
+ * \param n the number of experts
+ * \param actual the actual value
+ * \param lr the learning rate
+ * \param hedgeLoss incremented by the weighted loss, before the update
+ * \param minLoss lowered to the smallest loss
+ * \return the sum of the updated weights
+ */
+double
+FixedShareExpUpdate (const double *experts, double *weights, double *losses, int n,
+                     double actual, double lr, double &hedgeLoss, double &minLoss)
+{
+  for (int i = 0; i < n; i++)
+  {
+    if (experts[i] >= actual)
+    {
+      losses[i] = pow(experts[i] - actual, 2);
+    }
+    else
+    {
+      losses[i] = 2.0 * actual;
+    }
+    hedgeLoss += weights[i] * losses[i];
+    minLoss = std::min(minLoss, losses[i]);
+  }
+
+  for (int i = 0; i < n; i++)
+  {
+    weights[i] = weights[i] * exp(-lr * losses[i]);
+  }
+
+  double weightSum = 0;
+  for (int i = 0; i < n; i++)
+  {
+    weightSum += weights[i];
+  }
+  return weightSum;
+}
+
+/**
+ * \brief Second half of the Fixed Share update of an expert grid
+ *
+ * Scales the weights, then shares a fraction alpha of their total
+ * uniformly.
+ *
+ * \param weights the expert weights, updated
+ * \param n the number of experts
+ * \param alpha the share parameter
+ * \param weightSum the sum of the weights
+ * \param scale the factor applied to the weights, e.g. 1 / weightSum to normalize them
+ */
+void
+FixedShareShare (double *weights, int n, double alpha, double weightSum, double scale)
+{
+  double pool = alpha * weightSum * scale / n;
+  for (int i = 0; i < n; i++)
+  {
+    weights[i] = ((1 - alpha) * weights[i] * scale) + pool;
+  }
+}
+
+/**
+ * \brief Weighted quantile of an expert grid
+ *
+ * The cumulative weights are scanned from the smallest expert on every
+ * sample rather than maintained incrementally: every weight changes at
+ * each sample, so keeping a running cumulative position would cost a
+ * pass over the experts too.  The scan stops at the quantile, and with
+ * the default 100 experts it costs less than the weight update.
+ *
+ * \param experts the expert predictions, sorted
+ * \param weights the expert weights
+ * \param n the number of experts
+ * \param weightSum the sum of the weights
+ * \param quantile the quantile to locate, in (0, 1)
+ * \return the weighted quantile, interpolated between experts
+ */
+double
+FixedShareQuantile (const double *experts, const double *weights, int n,
+                    double weightSum, double quantile)
+{
+  double quantileTarget = quantile * weightSum;
+  double cumulativeWeight = 0;
+  for (int i = 0; i < n; i++)
+  {
+    if (weights[i] > 0 && cumulativeWeight + weights[i] >= quantileTarget)
+    {
+      // Interpolate between the previous expert and this one
+      double lower = (i > 0) ? experts[i - 1] : 0.0;
+      double fraction = (quantileTarget - cumulativeWeight) / weights[i];
+      return lower + fraction * (experts[i] - lower);
+    }
+    cumulativeWeight += weights[i];
+  }
+  return experts[n - 1];
+}
+
+} // anonymous namespace
+
+/**
+ * \ingroup tcp
+ *
+ * \brief Worker thread of the RttFixedShare estimators with AsyncUpdates
+ *
+ * Measurement pushes (estimator, sample) pairs into a lock-free single
+ * producer, single consumer ring, the producer being the simulator thread
+ * and the consumer the worker, which runs the Fixed Share update of each
+ * sample in order.  The worker sleeps on a condition variable when the
+ * ring is empty; the producer only takes the mutex to wake it up.
+ *
+ * The thread is started by the first sample, so that the scenarios can
+ * still fork replications from a topology that has not measured anything.
+ */
+class RttFixedShareWorker
+{
+public:
+  /**
+   * \return the worker, started on the first call
+   */
+  static RttFixedShareWorker &Get (void)
+  {
+    static RttFixedShareWorker worker;
+    return worker;
+  }
+
+  /**
+   * \return true if called on the worker thread
+   */
+  static bool IsWorkerThread (void)
+  {
+    return std::this_thread::get_id () == WorkerId ();
+  }
+
+  /**
+   * \brief Queues a sample, waiting while the ring is full.
+   * \param estimator the estimator to apply it to
+   * \param measure the sample
+   */
+  void Push (RttFixedShare *estimator, Time measure)
+  {
+    uint64_t head = m_head.load (std::memory_order_relaxed);
+    while (head - m_tail.load (std::memory_order_acquire) >= CAPACITY)
+      {
+        std::this_thread::yield ();
+      }
+    m_ring[head % CAPACITY].estimator = estimator;
+    m_ring[head % CAPACITY].measure = measure.GetTimeStep ();
+    m_head.store (head + 1, std::memory_order_seq_cst);
+    if (m_sleeping.load (std::memory_order_seq_cst))
+      {
+        std::lock_guard<std::mutex> lock (m_mutex);
+        m_wakeup.notify_one ();
+      }
+  }
+
+private:
+  RttFixedShareWorker ()
+    : m_head (0),
+      m_tail (0),
+      m_sleeping (false),
+      m_stop (false)
+  {
+    m_thread = std::thread (&RttFixedShareWorker::Run, this);
+    WorkerId () = m_thread.get_id ();
+  }
+
+  ~RttFixedShareWorker ()
+  {
+    {
+      std::lock_guard<std::mutex> lock (m_mutex);
+      m_stop = true;
+      m_wakeup.notify_one ();
+    }
+    m_thread.join ();
+  }
+
+  /**
+   * \return the id of the worker thread
+   */
+  static std::thread::id &WorkerId (void)
+  {
+    static std::thread::id id;
+    return id;
+  }
+
+  /**
+   * \brief Applies the queued samples until the worker is destroyed
+   */
+  void Run (void)
+  {
+    while (true)
+      {
+        uint64_t tail = m_tail.load (std::memory_order_relaxed);
+        if (tail == m_head.load (std::memory_order_acquire))
+          {
+            std::unique_lock<std::mutex> lock (m_mutex);
+            if (m_stop)
+              {
+                return;
+              }
+            m_sleeping.store (true, std::memory_order_seq_cst);
+            // The timeout covers a wakeup lost between the check and the wait
+            if (tail == m_head.load (std::memory_order_seq_cst))
+              {
+                m_wakeup.wait_for (lock, std::chrono::milliseconds (1));
+              }
+            m_sleeping.store (false, std::memory_order_relaxed);
+            continue;
+          }
+        RttFixedShare *estimator = m_ring[tail % CAPACITY].estimator;
+        Time measure (m_ring[tail % CAPACITY].measure);
+        m_tail.store (tail + 1, std::memory_order_release);
+        estimator->Update (measure);
+        estimator->m_pending.fetch_sub (1, std::memory_order_release);
+      }
+  }
+
+  /// Number of samples the ring holds
+  static const uint64_t CAPACITY = 4096;
+
+  /// A queued sample
+  struct Entry
+  {
+    RttFixedShare *estimator; //!< Estimator to apply the sample to
+    int64_t measure;          //!< Sample, in time steps
+  };
+
+  Entry m_ring[CAPACITY];           //!< Queued samples
+  std::atomic<uint64_t> m_head;     //!< Number of samples pushed, written by the producer
+  std::atomic<uint64_t> m_tail;     //!< Number of samples taken, written by the worker
+  std::atomic<bool> m_sleeping;     //!< Whether the worker may be waiting on m_wakeup
+  bool m_stop;                      //!< Whether the worker must exit, under m_mutex
+  std::mutex m_mutex;               //!< Mutex of m_wakeup
+  std::condition_variable m_wakeup; //!< Signaled when a sample is pushed to a sleeping worker
+  std::thread m_thread;             //!< The worker thread
+};
+
 // Public
 
 TypeId 
@@ -339,29 +1024,183 @@ RttFixedShare::GetTypeId (void)
                    MakeDoubleAccessor (&RttFixedShare::m_beta),
                    MakeDoubleChecker<double> (0, 1))
     .AddAttribute ("LR",
-                   "Learning rate, must be 0 < LR",
+                   "Learning rate, must be 0 < LR. With AdaptiveLR, only used until "
+                   "the first mixability gap is measured",
                    DoubleValue (2.0),
                    MakeDoubleAccessor (&RttFixedShare::m_lr),
                    MakeDoubleChecker<double> (0))
+    .AddAttribute ("AdaptiveLR",
+                   "Tune the learning rate online from the cumulative mixability "
+                   "gap (AdaHedge) instead of using LR",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&RttFixedShare::m_adaptiveLr),
+                   MakeBooleanChecker ())
+    .AddAttribute ("VariationMode",
+                   "How the RTT variation is estimated: from an EWMA of the absolute "
+                   "error (using Beta), from a weighted quantile of the experts, or "
+                   "by a second expert grid over the absolute error",
+                   EnumValue (RttFixedShare::EWMA_VARIATION),
+                   MakeEnumAccessor (&RttFixedShare::m_variationMode),
+                   MakeEnumChecker (RttFixedShare::EWMA_VARIATION, "Ewma",
+                                    RttFixedShare::QUANTILE_VARIATION, "Quantile",
+                                    RttFixedShare::EXPERT_VARIATION, "Experts"))
+    .AddAttribute ("Quantile",
+                   "Quantile of the expert distribution the RTO is set to in Quantile "
+                   "variation mode, must be 0 < quantile < 1. It is located by scanning "
+                   "the cumulative weights at each sample, O(NumExperts)",
+                   DoubleValue (0.9),
+                   MakeDoubleAccessor (&RttFixedShare::m_quantile),
+                   MakeDoubleChecker<double> (std::nextafter (0.0, 1.0), std::nextafter (1.0, 0.0)))
+    .AddAttribute ("BoostAlpha",
+                   "Share rate used right after a route change, decaying back to Alpha, "
+                   "must be 0 <= boostAlpha <= 1",
+                   DoubleValue (0.7),
+                   MakeDoubleAccessor (&RttFixedShare::m_boostAlpha),
+                   MakeDoubleChecker<double> (0, 1))
+    .AddAttribute ("BoostDecay",
+                   "Factor the share rate boost is multiplied by at each sample, "
+                   "must be 0 <= boostDecay < 1",
+                   DoubleValue (0.6),
+                   MakeDoubleAccessor (&RttFixedShare::m_boostDecay),
+                   MakeDoubleChecker<double> (0, std::nextafter (1.0, 0.0)))
+    .AddAttribute ("ShiftDetection",
+                   "Boost the share rate by itself when the prediction error spikes, "
+                   "as it does when the route changes",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&RttFixedShare::m_shiftDetection),
+                   MakeBooleanChecker ())
+    .AddAttribute ("ShiftThreshold",
+                   "Ratio of the absolute prediction error to its running average above which "
+                   "ShiftDetection assumes a route change",
+                   DoubleValue (8.0),
+                   MakeDoubleAccessor (&RttFixedShare::m_shiftThreshold),
+                   MakeDoubleChecker<double> (1))
+    .AddAttribute ("NumVariationExperts",
+                   "Number of experts of the variation grid in Experts variation mode, "
+                   "must be 0 < numVariationExperts",
+                   IntegerValue (32),
+                   MakeIntegerAccessor (&RttFixedShare::m_numVarExperts),
+                   MakeIntegerChecker<int> (1))
+    .AddAttribute ("VariationLR",
+                   "Learning rate of the variation grid in Experts variation mode, "
+                   "must be 0 < VariationLR. Higher than LR, as the losses of the "
+                   "absolute errors are much smaller than those of the RTTs",
+                   DoubleValue (1000.0),
+                   MakeDoubleAccessor (&RttFixedShare::m_varLr),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("PriorFile",
+                   "File of initial weights trained by rtt-train-prior, empty for "
+                   "uniform weights. Must have been trained for NumExperts experts",
+                   StringValue (""),
+                   MakeStringAccessor (&RttFixedShare::GetPriorFile,
+                                       &RttFixedShare::SetPriorFile),
+                   MakeStringChecker ())
+    .AddAttribute ("AsyncUpdates",
+                   "Apply the measurements on a worker thread, for emulation with "
+                   "the real-time simulator. Must be set before the first measurement",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&RttFixedShare::m_async),
+                   MakeBooleanChecker ())
+    .AddAttribute ("MaxPendingSamples",
+                   "Number of measurements that may wait for the worker thread "
+                   "with AsyncUpdates before Measurement blocks",
+                   UintegerValue (8),
+                   MakeUintegerAccessor (&RttFixedShare::m_maxPending),
+                   MakeUintegerChecker<uint32_t> (1))
   ;
   return tid;
 }
 
 RttFixedShare::RttFixedShare()
+  : m_slabExperts (0),
+    m_experts (0),
+    m_weights (0),
+    m_losses (0),
+    m_varSlabExperts (0),
+    m_varExperts (0),
+    m_varWeights (0),
+    m_varLosses (0),
+    m_async (false),
+    m_maxPending (8),
+    m_pending (0),
+    m_publishedRtt (0),
+    m_publishedVariation (0),
+    m_diagSamples (0),
+    m_diagErrorSum (0),
+    m_diagBiggestActual (0),
+    m_diagBiggestIndex (0)
 {      
   m_numExperts = 100;
   m_alpha = 0.08;
   m_beta = 0.25;
   m_lr = 2.0;
+  m_adaptiveLr = false;
+  m_cumulativeGap = 0.0;
+  m_variationMode = EWMA_VARIATION;
+  m_quantile = 0.9;
+  m_numVarExperts = 32;
+  m_varLr = 1000.0;
+  m_boostAlpha = 0.7;
+  m_boostDecay = 0.6;
+  m_shareBoost = 0.0;
+  m_shiftDetection = false;
+  m_shiftThreshold = 8.0;
+  m_errorAverage = 0.0;
+  m_prior = 0;
+  m_priorExperts = 0;
   InitializeVectors();
+  Publish ();
+  if (RttEstimatorStats::IsEnabled ())
+  {
+    FixedShareStats ().constructions++;
+  }
 }
 
 RttFixedShare::RttFixedShare (const RttFixedShare& c)
-  : RttEstimator (c), m_numExperts (c.m_numExperts), m_alpha (c.m_alpha), m_beta (c.m_beta), m_lr (c.m_lr)
+  : RttEstimator (Synchronized (c)), m_numExperts (c.m_numExperts), m_alpha (c.m_alpha), m_beta (c.m_beta), m_lr (c.m_lr),
+    m_adaptiveLr (c.m_adaptiveLr), m_cumulativeGap (c.m_cumulativeGap),
+    m_variationMode (c.m_variationMode), m_quantile (c.m_quantile), m_numVarExperts (c.m_numVarExperts), m_varLr (c.m_varLr),
+    m_boostAlpha (c.m_boostAlpha), m_boostDecay (c.m_boostDecay), m_shareBoost (c.m_shareBoost),
+    m_shiftDetection (c.m_shiftDetection), m_shiftThreshold (c.m_shiftThreshold), m_errorAverage (c.m_errorAverage),
+    m_priorFile (c.m_priorFile), m_prior (c.m_prior), m_priorExperts (c.m_priorExperts),
+    m_lastMeasurement (c.m_lastMeasurement),
+    m_async (c.m_async),
+    m_maxPending (c.m_maxPending),
+    m_pending (0),
+    m_publishedRtt (0),
+    m_publishedVariation (0),
+    m_diagSamples (0),
+    m_diagErrorSum (0),
+    m_diagBiggestActual (0),
+    m_diagBiggestIndex (0)
 {
   // Initialize member variables
-  
+  m_slabExperts = 0;
+  m_experts = 0;
+  m_weights = 0;
+  m_losses = 0;
+  m_varSlabExperts = 0;
+  m_varExperts = 0;
+  m_varWeights = 0;
+  m_varLosses = 0;
   InitializeVectors();
+
+  // Inherit the learned weights
+  if (c.m_slabExperts == m_slabExperts)
+  {
+    std::copy (c.m_weights, c.m_weights + m_numExperts, m_weights);
+  }
+  if (c.m_varSlabExperts > 0)
+  {
+    m_numVarExperts = c.m_varSlabExperts;
+    InitializeVariationVectors();
+    std::copy (c.m_varWeights, c.m_varWeights + m_varSlabExperts, m_varWeights);
+  }
+  Publish ();
+  if (RttEstimatorStats::IsEnabled ())
+  {
+    FixedShareStats ().constructions++;
+  }
 }
 
 TypeId
@@ -372,17 +1211,77 @@ RttFixedShare::GetInstanceTypeId (void) const
 
 void RttFixedShare::Measurement(Time measure)
 { 
-  if (m_nSamples > 0)
+  RttEstimatorStats::MeasurementTimer timer (FixedShareStats ());
+  m_lastMeasurement = Simulator::Now ();
+
+  if (!m_async)
   {
-    // This is the first measurement. Set est RTT to 0 and variance to RTT/2
-    m_estimatedRtt = measure;
-    m_estimatedVariation = measure / 2;
+    Update (measure);
     return;
   }
 
-  // Push values for logging
-  m_estimates.push_back(m_estimatedRtt.GetMilliSeconds());
-  m_actuals.push_back(measure.GetMilliSeconds()); 
+  // The slab pool belongs to the simulator thread, so resize the vectors
+  // here rather than on the worker
+  if (m_slabExperts != m_numExperts
+      || (m_variationMode == EXPERT_VARIATION && m_varSlabExperts != m_numVarExperts))
+  {
+    Synchronize ();
+    if (m_slabExperts != m_numExperts)
+    {
+      InitializeVectors ();
+    }
+    if (m_variationMode == EXPERT_VARIATION && m_varSlabExperts != m_numVarExperts)
+    {
+      InitializeVariationVectors ();
+    }
+  }
+
+  // Bound how far the published estimate lags behind
+  while (m_pending.load (std::memory_order_acquire) >= m_maxPending)
+  {
+    std::this_thread::yield ();
+  }
+  m_pending.fetch_add (1, std::memory_order_relaxed);
+  RttFixedShareWorker::Get ().Push (this, measure);
+}
+
+Time
+RttFixedShare::GetEstimate (void) const
+{
+  if (m_async)
+  {
+    return Time (m_publishedRtt.load (std::memory_order_acquire));
+  }
+  return m_estimatedRtt;
+}
+
+Time
+RttFixedShare::GetVariation (void) const
+{
+  if (m_async)
+  {
+    return Time (m_publishedVariation.load (std::memory_order_acquire));
+  }
+  return m_estimatedVariation;
+}
+
+void RttFixedShare::Update(Time measure)
+{
+  // NumExperts may have been changed through the attribute system after
+  // construction, so make sure the vectors match it
+  if (m_slabExperts != m_numExperts)
+  {
+    InitializeVectors ();
+  }
+
+  // Accumulate values for logging
+  if (measure.GetMilliSeconds() > m_diagBiggestActual)
+  {
+    m_diagBiggestActual = measure.GetMilliSeconds();
+    m_diagBiggestIndex = m_diagSamples;
+  }
+  m_diagErrorSum += std::abs(m_estimatedRtt.GetMilliSeconds() - measure.GetMilliSeconds());
+  m_diagSamples++;
   // NS_LOG_DEBUG("In measurement");
 
   // 0) Cast time to double, units in milliseconds
@@ -401,7 +1300,32 @@ void RttFixedShare::Measurement(Time measure)
     denominatorSum += m_weights[i];
   }
 
-  double yPredicted = numeratorSum / denominatorSum;
+  if (!(denominatorSum > 0))
+  {
+    // Every weight is gone; start over from the uniform prior
+    if (RttEstimatorStats::IsEnabled () && !m_async)
+    {
+      FixedShareStats ().events[RttEstimatorStats::ZERO_DENOMINATOR]++;
+    }
+    InitializeVectors();
+    numeratorSum = 0;
+    denominatorSum = 0;
+    for (int i = 0; i < m_numExperts; i++)
+    {
+      numeratorSum += m_weights[i] * m_experts[i];
+      denominatorSum += m_weights[i];
+    }
+  }
+
+  double yPredicted = numeratorSum / denominatorSum;
+
+  // The quantile comes from the same weights as the prediction, so that
+  // SRTT and RTO describe the same distribution
+  double quantileRtt = 0;
+  if (m_variationMode == QUANTILE_VARIATION)
+  {
+    quantileRtt = FixedShareQuantile (m_experts, m_weights, m_numExperts, denominatorSum, m_quantile);
+  }
 
   // Save old rtt for computing variation
   double oldEstimatedRtt = m_estimatedRtt.ToDouble(Time::S);
@@ -409,109 +1333,1319 @@ void RttFixedShare::Measurement(Time measure)
 
   // NS_LOG_DEBUG("Estimated rtt:" << m_estimatedRtt.GetMilliSeconds());
 
-  // 2) Compute the new losses
+  // 2) Compute the new losses and 3) apply exponential updates to weights
 
-  for (int i = 0; i < m_numExperts; i++)
-  {    
-    if (m_experts[i] >= actualRtt)
-    {      
-      m_losses[i] = pow(m_experts[i] - actualRtt, 2);
-      // m_losses.push_back(pow(m_experts[i] - actualRtt, 2));
-    }
-    else
-    {
-      m_losses[i] = 2.0 * actualRtt;
-      // m_losses.push_back(2.0 * actualRtt);
-    }
-  }
+  // Weighted and smallest loss, for the mixability gap in adaptive mode
+  double hedgeLoss = 0;
+  double minLoss = std::numeric_limits<double>::infinity();
 
-  // 3) Apply exponential updates to weights
+  double lr = GetLearningRate();
+  double weightSum = FixedShareExpUpdate (m_experts, m_weights, m_losses, m_numExperts,
+                                          actualRtt, lr, hedgeLoss, minLoss);
 
-  for (int i = 0; i < m_numExperts; i++)
+  if (m_shiftDetection)
   {
-    m_weights[i] = m_weights[i] * exp(-m_lr * m_losses[i]);
+    // A route change moves the RTT away from where the weight mass is.
+    // The absolute error is used rather than the weighted loss, which
+    // barely moves when the RTT drops since overestimates are cheap.
+    double error = std::fabs(actualRtt - yPredicted);
+    if (m_nSamples > 0 && error > m_shiftThreshold * m_errorAverage)
+    {
+      NS_LOG_DEBUG ("Error spike of " << error << " against " << m_errorAverage << ", boosting the share rate");
+      RouteChanged ();
+    }
+    m_errorAverage = (m_nSamples > 0) ? 0.875 * m_errorAverage + 0.125 * error : error;
   }
 
+  // The share rate, raised for a few samples after a route change
+  double alpha = std::min (1.0, m_alpha + m_shareBoost);
+  m_shareBoost *= m_boostDecay;
+
   // 4) Share weights
 
-  double pool = 0;
-  for (int i = 0; i < m_numExperts; i++)
+  if (weightSum < std::numeric_limits<double>::min() && RttEstimatorStats::IsEnabled () && !m_async)
   {
-    pool += m_alpha * m_weights[i];
+    FixedShareStats ().events[RttEstimatorStats::WEIGHT_UNDERFLOW]++;
   }
 
-  pool /= m_numExperts;
-
-  for (int i = 0; i < m_numExperts; i++)
+  double scale = 1.0;
+  if (m_adaptiveLr)
   {
-    m_weights[i] = ((1 - m_alpha) * m_weights[i]) + pool;
+    // AdaHedge: the mixability gap is the Hedge loss minus the mix loss
+    // -ln(sum(p * exp(-lr * loss))) / lr, where p are the normalized
+    // weights. weightSum / denominatorSum is that sum. If it underflowed,
+    // the smallest loss is used, which bounds the mix loss from below.
+    hedgeLoss /= denominatorSum;
+    double mixLoss = (weightSum > 0) ? -std::log(weightSum / denominatorSum) / lr : minLoss;
+    // Sharing keeps the weights spread, so the gap never stops growing and
+    // the rate would decay to zero. Forget old gaps as fast as sharing
+    // forgets old losses instead.
+    m_cumulativeGap = (1 - m_alpha) * m_cumulativeGap + std::max(0.0, hedgeLoss - std::min(mixLoss, hedgeLoss));
+
+    // The adaptive rate can grow large, so keep the weights normalized
+    if (weightSum > 0)
+    {
+      scale = 1.0 / weightSum;
+    }
   }
 
+  FixedShareShare (m_weights, m_numExperts, alpha, weightSum, scale);
+
   // Update variation
 
-  double oldRttVar = m_estimatedVariation.ToDouble(Time::S);
-  double newRttVar = (1 - m_beta) * oldRttVar + m_beta * (abs(measure.ToDouble(Time::S) - oldEstimatedRtt));
+  double newRttVar;
+  if (m_variationMode == QUANTILE_VARIATION)
+  {
+    // TCP sets RTO = SRTT + 4 * RTTVAR, so this makes the RTO the quantile
+    newRttVar = std::max (0.0, quantileRtt - yPredicted) / 4.0;
+  }
+  else if (m_variationMode == EXPERT_VARIATION)
+  {
+    newRttVar = UpdateVariationExperts (std::abs(actualRtt - oldEstimatedRtt));
+  }
+  else
+  {
+    double oldRttVar = m_estimatedVariation.ToDouble(Time::S);
+    newRttVar = (1 - m_beta) * oldRttVar + m_beta * (std::abs(measure.ToDouble(Time::S) - oldEstimatedRtt));
+  }
   m_estimatedVariation = Time::FromDouble (newRttVar, Time::S);
+
+  m_nSamples++;
+  Publish ();
 }
 
 Ptr<RttEstimator> 
 RttFixedShare::Copy () const
 {
+  if (RttEstimatorStats::IsEnabled ())
+  {
+    FixedShareStats ().copies++;
+  }
   return CopyObject<RttFixedShare> (this);
 }
 
 void 
 RttFixedShare::Reset ()
 { 
+  if (RttEstimatorStats::IsEnabled ())
+  {
+    FixedShareStats ().resets++;
+  }
   // RttEstimator::Reset ();
+  // The learned weights and estimates are kept, only the sample count restarts
+  Synchronize ();
+  m_nSamples = 0;
 }
 
 RttFixedShare::~RttFixedShare ()
 {
-  if (m_actuals.size() > 0)
+  Synchronize();
+  RetireErrors();
+  if (m_diagSamples > 0)
   {
     PrintDiagnostics();
   }
+  ReleaseVectors();
+}
+
+bool RttFixedShare::GetErrorSum(double &errorSum, uint32_t &samples) const
+{
+  Synchronize();
+  errorSum = m_diagErrorSum;
+  samples = m_diagSamples;
+  return true;
+}
+
+std::vector<double>
+RttFixedShare::GetExpertGrid (int numExperts)
+{
+  double rttMin = 0.0;
+  double rttMax = 0.4;
+  std::vector<double> experts;
+  experts.reserve (numExperts);
+  for (int i = 1; i <= numExperts; i++)
+    {
+      experts.push_back (rttMin + rttMax * std::pow (2, ((i - numExperts) / 4.0)));
+    }
+  return experts;
+}
+
+RttFixedShare::Summary
+RttFixedShare::GetSummary (void) const
+{
+  Synchronize ();
+  Summary summary;
+  summary.weights = GetWeights ();
+  summary.variation = m_estimatedVariation;
+  summary.cumulativeGap = m_cumulativeGap;
+  summary.lastMeasurement = m_lastMeasurement;
+  return summary;
+}
+
+void
+RttFixedShare::WarmStart (Ptr<const RttFixedShare> other, double keep)
+{
+  NS_LOG_FUNCTION (this << other << keep);
+  WarmStart (other->GetSummary (), keep);
+}
+
+void
+RttFixedShare::WarmStart (const Summary &summary, double keep)
+{
+  NS_LOG_FUNCTION (this << keep);
+  NS_ASSERT (keep >= 0 && keep <= 1);
+  Synchronize ();
+
+  if (m_slabExperts != m_numExperts)
+  {
+    InitializeVectors ();
+  }
+  if (summary.weights.size () != (uint32_t)m_slabExperts)
+  {
+    NS_LOG_DEBUG ("Not warm starting, expert grids differ");
+    return;
+  }
+
+  double otherSum = 0;
+  for (int i = 0; i < m_numExperts; i++)
+  {
+    otherSum += summary.weights[i];
+  }
+  if (otherSum <= 0)
+  {
+    return;
+  }
+
+  // Blend the normalized distribution of the other estimator with the
+  // uniform prior, then predict from it as Measurement would
+  double numeratorSum = 0;
+  for (int i = 0; i < m_numExperts; i++)
+  {
+    m_weights[i] = keep * summary.weights[i] / otherSum + (1 - keep) / m_numExperts;
+    numeratorSum += m_weights[i] * m_experts[i];
+  }
+  m_estimatedRtt = Time::FromDouble (numeratorSum, Time::S);
+  m_estimatedVariation = summary.variation;
+  // The learning rate that suited the other flow is a better start than LR
+  m_cumulativeGap = summary.cumulativeGap;
+  // The seeded knowledge is as old as the one it was copied from
+  m_lastMeasurement = summary.lastMeasurement;
+  Publish ();
+  NS_LOG_DEBUG ("Warm started to " << m_estimatedRtt.GetMilliSeconds () << " ms keeping " << keep);
+}
+
+Time
+RttFixedShare::GetLastMeasurementTime (void) const
+{
+  return m_lastMeasurement;
+}
+
+void
+RttFixedShare::RouteChanged (void)
+{
+  NS_LOG_FUNCTION (this);
+  Synchronize ();
+  if (RttEstimatorStats::IsEnabled () && !m_async)
+  {
+    FixedShareStats ().events[RttEstimatorStats::SHARE_BOOST]++;
+  }
+  m_shareBoost = std::max (m_shareBoost, m_boostAlpha - m_alpha);
+}
+
+double
+RttFixedShare::GetShareRate (void) const
+{
+  Synchronize ();
+  return std::min (1.0, m_alpha + m_shareBoost);
+}
+
+std::vector<double>
+RttFixedShare::GetWeights (void) const
+{
+  Synchronize ();
+  std::vector<double> weights (m_weights, m_weights + m_slabExperts);
+  double sum = 0;
+  for (uint32_t i = 0; i < weights.size (); i++)
+  {
+    sum += weights[i];
+  }
+  for (uint32_t i = 0; i < weights.size () && sum > 0; i++)
+  {
+    weights[i] /= sum;
+  }
+  return weights;
+}
+
+void
+RttFixedShare::SetPriorFile (std::string path)
+{
+  NS_LOG_FUNCTION (this << path);
+  Synchronize ();
+  if (path == m_priorFile)
+  {
+    return;
+  }
+  m_priorFile = path;
+  m_prior = path.empty () ? 0 : RttFixedSharePrior::Get (path, m_priorExperts);
+  InitializeVectors ();
+
+  // Start from the prediction of the prior rather than InitialEstimation
+  if (m_prior != 0 && m_nSamples == 0)
+  {
+    double numeratorSum = 0;
+    for (int i = 0; i < m_numExperts; i++)
+    {
+      numeratorSum += m_weights[i] * m_experts[i];
+    }
+    m_estimatedRtt = Time::FromDouble (numeratorSum, Time::S);
+  }
+  Publish ();
+}
+
+std::string
+RttFixedShare::GetPriorFile (void) const
+{
+  return m_priorFile;
+}
+
+void
+RttFixedShare::DoSerialize (std::ostream &os) const
+{
+  WriteValue<int32_t> (os, m_numExperts);
+  WriteValue<double> (os, m_alpha);
+  WriteValue<double> (os, m_beta);
+  WriteValue<double> (os, m_lr);
+  WriteValue<uint8_t> (os, m_adaptiveLr);
+  WriteValue<double> (os, m_cumulativeGap);
+  WriteValue<int32_t> (os, m_variationMode);
+  WriteValue<double> (os, m_quantile);
+  WriteValue<int32_t> (os, m_numVarExperts);
+  WriteValue<double> (os, m_varLr);
+  WriteValue<double> (os, m_boostAlpha);
+  WriteValue<double> (os, m_boostDecay);
+  WriteValue<double> (os, m_shareBoost);
+  WriteValue<uint8_t> (os, m_shiftDetection);
+  WriteValue<double> (os, m_shiftThreshold);
+  WriteValue<double> (os, m_errorAverage);
+  WriteString (os, m_priorFile);
+  WriteTime (os, m_lastMeasurement);
+  WriteValue<uint32_t> (os, m_diagSamples);
+  WriteValue<int64_t> (os, m_diagErrorSum);
+  WriteValue<int64_t> (os, m_diagBiggestActual);
+  WriteValue<uint32_t> (os, m_diagBiggestIndex);
+  WriteDoubles (os, m_weights, m_slabExperts);
+  WriteDoubles (os, m_varWeights, m_varSlabExperts);
+}
+
+bool
+RttFixedShare::DoDeserialize (std::istream &is)
+{
+  // Everything is read and checked before any member is touched, so that
+  // an invalid state leaves the estimator as it was
+  int32_t numExperts = ReadValue<int32_t> (is);
+  double alpha = ReadValue<double> (is);
+  double beta = ReadValue<double> (is);
+  double lr = ReadValue<double> (is);
+  uint8_t adaptiveLr = ReadValue<uint8_t> (is);
+  double cumulativeGap = ReadValue<double> (is);
+  int32_t variationMode = ReadValue<int32_t> (is);
+  double quantile = ReadValue<double> (is);
+  int32_t numVarExperts = ReadValue<int32_t> (is);
+  double varLr = ReadValue<double> (is);
+  double boostAlpha = ReadValue<double> (is);
+  double boostDecay = ReadValue<double> (is);
+  double shareBoost = ReadValue<double> (is);
+  uint8_t shiftDetection = ReadValue<uint8_t> (is);
+  double shiftThreshold = ReadValue<double> (is);
+  double errorAverage = ReadValue<double> (is);
+  std::string priorFile = ReadString (is);
+  Time lastMeasurement = ReadTime (is);
+  uint32_t diagSamples = ReadValue<uint32_t> (is);
+  int64_t diagErrorSum = ReadValue<int64_t> (is);
+  int64_t diagBiggestActual = ReadValue<int64_t> (is);
+  uint32_t diagBiggestIndex = ReadValue<uint32_t> (is);
+  std::vector<double> weights = ReadDoubles (is);
+  std::vector<double> varWeights = ReadDoubles (is);
+  if (!is || numExperts <= 0 || weights.size () != (uint32_t)numExperts
+      || !(alpha >= 0 && alpha <= 1) || !(beta >= 0 && beta <= 1) || !(lr >= 0)
+      || variationMode < EWMA_VARIATION || variationMode > EXPERT_VARIATION
+      || !(quantile > 0 && quantile < 1) || numVarExperts <= 0 || !(varLr >= 0)
+      || !(boostAlpha >= 0 && boostAlpha <= 1) || !(boostDecay >= 0 && boostDecay < 1)
+      || !(shiftThreshold >= 1))
+  {
+    return false;
+  }
+
+  // The prior only matters for later restarts, the weights are restored
+  // below, but a missing one would abort them
+  const double *prior = 0;
+  int priorExperts = 0;
+  if (!priorFile.empty ())
+  {
+    prior = RttFixedSharePrior::GetFailSafe (priorFile, priorExperts);
+    if (prior == 0 || priorExperts != numExperts)
+    {
+      NS_LOG_WARN ("Cannot restore the prior " << priorFile << " of the saved state");
+      return false;
+    }
+  }
+
+  m_numExperts = numExperts;
+  m_alpha = alpha;
+  m_beta = beta;
+  m_lr = lr;
+  m_adaptiveLr = adaptiveLr;
+  m_cumulativeGap = cumulativeGap;
+  m_variationMode = (VariationMode)variationMode;
+  m_quantile = quantile;
+  m_numVarExperts = numVarExperts;
+  m_varLr = varLr;
+  m_boostAlpha = boostAlpha;
+  m_boostDecay = boostDecay;
+  m_shareBoost = shareBoost;
+  m_shiftDetection = shiftDetection;
+  m_shiftThreshold = shiftThreshold;
+  m_errorAverage = errorAverage;
+  m_priorFile = priorFile;
+  m_prior = prior;
+  m_priorExperts = priorExperts;
+  m_lastMeasurement = lastMeasurement;
+  m_diagSamples = diagSamples;
+  m_diagErrorSum = diagErrorSum;
+  m_diagBiggestActual = diagBiggestActual;
+  m_diagBiggestIndex = diagBiggestIndex;
+
+  if (m_slabExperts != m_numExperts)
+  {
+    InitializeVectors();
+  }
+  std::copy (weights.begin (), weights.end (), m_weights);
+
+  if (!varWeights.empty ())
+  {
+    m_numVarExperts = varWeights.size ();
+    InitializeVariationVectors();
+    std::copy (varWeights.begin (), varWeights.end (), m_varWeights);
+  }
+  else if (m_varSlabExperts > 0)
+  {
+    InitializeVariationVectors();
+  }
+  Publish ();
+  return true;
+}
+
+double
+RttFixedShare::GetLearningRate (void) const
+{
+  Synchronize ();
+  if (m_adaptiveLr && m_cumulativeGap > 0)
+  {
+    return std::log((double)m_numExperts) / m_cumulativeGap;
+  }
+  return m_lr;
 }
 
 // Private
 
+void
+RttFixedShare::Synchronize (void) const
+{
+  // The worker itself reads the state while updating it
+  if (!m_async || RttFixedShareWorker::IsWorkerThread ())
+  {
+    return;
+  }
+  while (m_pending.load (std::memory_order_acquire) > 0)
+  {
+    std::this_thread::yield ();
+  }
+}
+
+const RttFixedShare &
+RttFixedShare::Synchronized (const RttFixedShare &c)
+{
+  c.Synchronize ();
+  return c;
+}
+
+void
+RttFixedShare::Publish (void)
+{
+  m_publishedRtt.store (m_estimatedRtt.GetTimeStep (), std::memory_order_release);
+  m_publishedVariation.store (m_estimatedVariation.GetTimeStep (), std::memory_order_release);
+}
+
 void RttFixedShare::InitializeVectors()
 { 
+  if (m_slabExperts != m_numExperts)
+  {
+    ReleaseVectors();
+    m_weights = RttFixedSharePool::Allocate(m_numExperts);
+    m_losses = m_weights + m_numExperts;
+    m_experts = RttFixedSharePool::GetExperts(m_numExperts);
+    m_slabExperts = m_numExperts;
+  }
+
+  if (m_prior != 0)
+  {
+    // Start from the trained prior, which is already normalized
+    NS_ABORT_MSG_IF (m_priorExperts != m_numExperts, "Prior " << m_priorFile << " was trained for "
+                     << m_priorExperts << " experts, not " << m_numExperts);
+    std::copy (m_prior, m_prior + m_numExperts, m_weights);
+    std::fill (m_losses, m_losses + m_numExperts, 0.0);
+    return;
+  }
+
   double initialWeight = 1.0 / m_numExperts;
-  double rttMin = 0.0;
-  double rttMax = 0.4;  
   // Initialize all weights uniform to 1/N  
-  for (int i = 1; i <= m_numExperts; i++)
+  for (int i = 0; i < m_numExperts; i++)
   {    
-    m_experts.push_back(rttMin + rttMax * pow(2, ((i - m_numExperts) / 4.0)));
-    m_weights.push_back(initialWeight);
-    m_losses.push_back(0.0);
+    m_weights[i] = initialWeight;
+    m_losses[i] = 0.0;
   }
 }
 
-void RttFixedShare::PrintDiagnostics()
+void RttFixedShare::ReleaseVectors()
 {
-  double differenceSum = 0;
-  double biggestActual = 0;
-  double biggestIndex = 0;
+  if (m_slabExperts > 0)
+  {
+    RttFixedSharePool::Release(m_slabExperts, m_weights);
+    m_weights = 0;
+    m_losses = 0;
+    m_experts = 0;
+    m_slabExperts = 0;
+  }
+  if (m_varSlabExperts > 0)
+  {
+    RttFixedSharePool::Release(m_varSlabExperts, m_varWeights);
+    m_varWeights = 0;
+    m_varLosses = 0;
+    m_varExperts = 0;
+    m_varSlabExperts = 0;
+  }
+}
 
-  for (int i = 0; i < m_actuals.size(); i++)
+void RttFixedShare::InitializeVariationVectors()
+{
+  if (m_varSlabExperts != m_numVarExperts)
   {
-    if (m_actuals[i] > biggestActual)
+    if (m_varSlabExperts > 0)
     {
-      biggestActual = m_actuals[i];
-      biggestIndex = i;
+      RttFixedSharePool::Release(m_varSlabExperts, m_varWeights);
     }
-    biggestActual = std::max(biggestActual, m_actuals[i]);
-    differenceSum += abs((double)m_estimates[i] - (double)m_actuals[i]);
+    m_varWeights = RttFixedSharePool::Allocate(m_numVarExperts);
+    m_varLosses = m_varWeights + m_numVarExperts;
+    m_varExperts = RttFixedSharePool::GetExperts(m_numVarExperts);
+    m_varSlabExperts = m_numVarExperts;
+  }
+
+  for (int i = 0; i < m_numVarExperts; i++)
+  {
+    m_varWeights[i] = 1.0 / m_numVarExperts;
+    m_varLosses[i] = 0.0;
+  }
+}
+
+double RttFixedShare::UpdateVariationExperts(double deviation)
+{
+  if (m_varSlabExperts != m_numVarExperts)
+  {
+    InitializeVariationVectors();
+  }
+
+  double hedgeLoss = 0;
+  double minLoss = std::numeric_limits<double>::infinity();
+  double weightSum = FixedShareExpUpdate (m_varExperts, m_varWeights, m_varLosses, m_varSlabExperts,
+                                          deviation, m_varLr, hedgeLoss, minLoss);
+  if (!(weightSum > 0))
+  {
+    InitializeVariationVectors();
+    weightSum = 1.0;
   }
 
-  differenceSum /= (double)m_actuals.size();
+  // The grid is small, so its weights are simply kept normalized
+  FixedShareShare (m_varWeights, m_varSlabExperts, m_alpha, weightSum, 1.0 / weightSum);
+
+  double predicted = 0;
+  for (int i = 0; i < m_varSlabExperts; i++)
+  {
+    predicted += m_varWeights[i] * m_varExperts[i];
+  }
+  return predicted;
+}
 
-  NS_LOG_DEBUG("Mean error of " << differenceSum << " with a weight of " << m_actuals.size());
-  NS_LOG_DEBUG("Max actual RTT: " << biggestActual << " at index " << biggestIndex << " out of " << m_actuals.size());
+void RttFixedShare::PrintDiagnostics()
+{
+  double differenceSum = (double)m_diagErrorSum / (double)m_diagSamples;
+
+  NS_LOG_DEBUG("Mean error of " << differenceSum << " with a weight of " << m_diagSamples);
+  NS_LOG_DEBUG("Max actual RTT: " << m_diagBiggestActual << " at index " << m_diagBiggestIndex << " out of " << m_diagSamples);
   
 }
 
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+// Kalman Estimator
+
+NS_OBJECT_ENSURE_REGISTERED (RttKalman);
+
+/// \return the stats counters of RttKalman
+static RttEstimatorStats::Counters &
+KalmanStats (void)
+{
+  static RttEstimatorStats::Counters &counters = RttEstimatorStats::GetCounters ("ns3::RttKalman");
+  return counters;
+}
+
+TypeId
+RttKalman::GetTypeId (void)
+{
+  // The default noises give a steady state gain of about 0.1, close to
+  // RttMeanDeviation's 1/8
+  static TypeId tid = TypeId ("ns3::RttKalman")
+    .SetParent<RttEstimator> ()
+    .SetGroupName ("Internet")
+    .AddConstructor<RttKalman> ()
+    .AddAttribute ("ProcessNoise",
+                   "Variance of the change of the RTT between two samples, in s^2",
+                   DoubleValue (1e-6),
+                   MakeDoubleAccessor (&RttKalman::m_processNoise),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("MeasurementNoise",
+                   "Variance of the noise of an RTT sample, in s^2",
+                   DoubleValue (1e-4),
+                   MakeDoubleAccessor (&RttKalman::m_measurementNoise),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("VariationGain",
+                   "Gain of the moving average of the absolute innovation giving the "
+                   "variation, like beta in RFC 6298, must be 0 <= variationGain <= 1",
+                   DoubleValue (0.25),
+                   MakeDoubleAccessor (&RttKalman::m_variationGain),
+                   MakeDoubleChecker<double> (0, 1))
+  ;
+  return tid;
+}
+
+RttKalman::RttKalman ()
+  : m_processNoise (1e-6),
+    m_measurementNoise (1e-4),
+    m_variationGain (0.25),
+    m_errorVariance (0),
+    m_diagSamples (0),
+    m_diagErrorSum (0)
+{
+  NS_LOG_FUNCTION (this);
+  if (RttEstimatorStats::IsEnabled ())
+    {
+      KalmanStats ().constructions++;
+    }
+}
+
+RttKalman::RttKalman (const RttKalman& c)
+  : RttEstimator (c),
+    m_processNoise (c.m_processNoise),
+    m_measurementNoise (c.m_measurementNoise),
+    m_variationGain (c.m_variationGain),
+    m_errorVariance (c.m_errorVariance),
+    m_diagSamples (0),
+    m_diagErrorSum (0)
+{
+  NS_LOG_FUNCTION (this);
+  if (RttEstimatorStats::IsEnabled ())
+    {
+      KalmanStats ().constructions++;
+    }
+}
+
+RttKalman::~RttKalman ()
+{
+  RetireErrors ();
+  if (m_diagSamples > 0)
+    {
+      PrintDiagnostics ();
+    }
+}
+
+bool
+RttKalman::GetErrorSum (double &errorSum, uint32_t &samples) const
+{
+  errorSum = m_diagErrorSum;
+  samples = m_diagSamples;
+  return true;
+}
+
+TypeId
+RttKalman::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+
+void
+RttKalman::Measurement (Time m)
+{
+  RttEstimatorStats::MeasurementTimer timer (KalmanStats ());
+
+  m_diagErrorSum += std::abs (m_estimatedRtt.GetMilliSeconds () - m.GetMilliSeconds ());
+  m_diagSamples++;
+
+  double sample = m.ToDouble (Time::S);
+  if (m_nSamples)
+    {
+      // Predict: the RTT may have drifted since the last sample
+      double predicted = m_errorVariance + m_processNoise;
+      double innovationVariance = predicted + m_measurementNoise;
+
+      // Update: move towards the sample by the Kalman gain
+      double gain = innovationVariance > 0 ? predicted / innovationVariance : 1.0;
+      double estimate = m_estimatedRtt.ToDouble (Time::S);
+      double innovation = sample - estimate;
+      estimate += gain * innovation;
+      m_estimatedRtt = Time::FromDouble (estimate, Time::S);
+      m_errorVariance = (1 - gain) * predicted;
+
+      // The variation follows the innovations rather than the model, whose
+      // noises are fixed and would give the same variation on any path
+      double variation = m_estimatedVariation.ToDouble (Time::S);
+      variation += m_variationGain * (std::abs (innovation) - variation);
+      m_estimatedVariation = Time::FromDouble (variation, Time::S);
+    }
+  else
+    { // First sample, known to within the measurement noise
+      m_estimatedRtt = m;
+      m_errorVariance = m_measurementNoise;
+      m_estimatedVariation = Time::FromDouble (std::sqrt (m_measurementNoise), Time::S);
+    }
+  m_nSamples++;
+}
+
+Ptr<RttEstimator>
+RttKalman::Copy () const
+{
+  NS_LOG_FUNCTION (this);
+  if (RttEstimatorStats::IsEnabled ())
+    {
+      KalmanStats ().copies++;
+    }
+  return CopyObject<RttKalman> (this);
+}
+
+void
+RttKalman::Reset ()
+{
+  NS_LOG_FUNCTION (this);
+  if (RttEstimatorStats::IsEnabled ())
+    {
+      KalmanStats ().resets++;
+    }
+  RttEstimator::Reset ();
+  m_errorVariance = 0;
+}
+
+double
+RttKalman::GetErrorVariance (void) const
+{
+  return m_errorVariance;
+}
+
+void
+RttKalman::DoSerialize (std::ostream &os) const
+{
+  WriteValue<double> (os, m_processNoise);
+  WriteValue<double> (os, m_measurementNoise);
+  WriteValue<double> (os, m_variationGain);
+  WriteValue<double> (os, m_errorVariance);
+  WriteValue<uint32_t> (os, m_diagSamples);
+  WriteValue<int64_t> (os, m_diagErrorSum);
+}
+
+bool
+RttKalman::DoDeserialize (std::istream &is)
+{
+  double processNoise = ReadValue<double> (is);
+  double measurementNoise = ReadValue<double> (is);
+  double variationGain = ReadValue<double> (is);
+  double errorVariance = ReadValue<double> (is);
+  uint32_t diagSamples = ReadValue<uint32_t> (is);
+  int64_t diagErrorSum = ReadValue<int64_t> (is);
+  if (!is || !(processNoise >= 0) || !(measurementNoise >= 0)
+      || !(variationGain >= 0 && variationGain <= 1) || !(errorVariance >= 0)
+      || diagErrorSum < 0)
+    {
+      return false;
+    }
+  m_processNoise = processNoise;
+  m_measurementNoise = measurementNoise;
+  m_variationGain = variationGain;
+  m_errorVariance = errorVariance;
+  m_diagSamples = diagSamples;
+  m_diagErrorSum = diagErrorSum;
+  return true;
+}
+
+void
+RttKalman::PrintDiagnostics (void)
+{
+  double differenceSum = (double)m_diagErrorSum / (double)m_diagSamples;
+
+  NS_LOG_DEBUG ("Mean error of " << differenceSum << " with a weight of " << m_diagSamples);
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+// Ensemble Estimator
+
+NS_OBJECT_ENSURE_REGISTERED (RttEnsemble);
+
+/// \return the stats counters of RttEnsemble
+static RttEstimatorStats::Counters &
+EnsembleStats (void)
+{
+  static RttEstimatorStats::Counters &counters = RttEstimatorStats::GetCounters ("ns3::RttEnsemble");
+  return counters;
+}
+
+/// Quantities of the per-tracker state, in the order of their blocks
+enum EnsembleBlock
+{
+  ENSEMBLE_ALPHA = 0,
+  ENSEMBLE_BETA,
+  ENSEMBLE_SRTT,
+  ENSEMBLE_RTTVAR,
+  ENSEMBLE_WEIGHT,
+  ENSEMBLE_BLOCKS
+};
+
+TypeId
+RttEnsemble::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::RttEnsemble")
+    .SetParent<RttEstimator> ()
+    .SetGroupName ("Internet")
+    .AddConstructor<RttEnsemble> ()
+    .AddAttribute ("NumTrackers",
+                   "Number of Mean-Deviation trackers, must be 0 < numTrackers",
+                   IntegerValue (12),
+                   MakeIntegerAccessor (&RttEnsemble::m_numTrackers),
+                   MakeIntegerChecker<int> (1))
+    .AddAttribute ("MinGain",
+                   "RTT gain (alpha) of the slowest tracker, must be 0 < gain <= MaxGain",
+                   DoubleValue (1.0 / 64),
+                   MakeDoubleAccessor (&RttEnsemble::m_minGain),
+                   MakeDoubleChecker<double> (std::numeric_limits<double>::min (), 1))
+    .AddAttribute ("MaxGain",
+                   "RTT gain (alpha) of the fastest tracker, must be MinGain <= gain <= 1",
+                   DoubleValue (0.75),
+                   MakeDoubleAccessor (&RttEnsemble::m_maxGain),
+                   MakeDoubleChecker<double> (std::numeric_limits<double>::min (), 1))
+    .AddAttribute ("Alpha",
+                   "Weight sharing parameter, must be 0 <= alpha <= 1",
+                   DoubleValue (0.08),
+                   MakeDoubleAccessor (&RttEnsemble::m_alpha),
+                   MakeDoubleChecker<double> (0, 1))
+    .AddAttribute ("LR",
+                   "Learning rate, must be 0 < LR. Higher than RttFixedShare's, as the "
+                   "trackers stay close to the samples and their losses are smaller",
+                   DoubleValue (200.0),
+                   MakeDoubleAccessor (&RttEnsemble::m_lr),
+                   MakeDoubleChecker<double> (0))
+  ;
+  return tid;
+}
+
+RttEnsemble::RttEnsemble ()
+  : m_numTrackers (12),
+    m_minGain (1.0 / 64),
+    m_maxGain (0.75),
+    m_alpha (0.08),
+    m_lr (200.0),
+    m_trackersStarted (false),
+    m_stateMinGain (0),
+    m_stateMaxGain (0),
+    m_diagSamples (0),
+    m_diagErrorSum (0)
+{
+  NS_LOG_FUNCTION (this);
+  InitializeState ();
+  if (RttEstimatorStats::IsEnabled ())
+    {
+      EnsembleStats ().constructions++;
+    }
+}
+
+RttEnsemble::RttEnsemble (const RttEnsemble& c)
+  : RttEstimator (c),
+    m_numTrackers (c.m_numTrackers),
+    m_minGain (c.m_minGain),
+    m_maxGain (c.m_maxGain),
+    m_alpha (c.m_alpha),
+    m_lr (c.m_lr),
+    m_trackersStarted (c.m_trackersStarted),
+    m_stateMinGain (c.m_stateMinGain),
+    m_stateMaxGain (c.m_stateMaxGain),
+    m_state (c.m_state),
+    m_diagSamples (0),
+    m_diagErrorSum (0)
+{
+  NS_LOG_FUNCTION (this);
+  if (RttEstimatorStats::IsEnabled ())
+    {
+      EnsembleStats ().constructions++;
+    }
+}
+
+RttEnsemble::~RttEnsemble ()
+{
+  RetireErrors ();
+  if (m_diagSamples > 0)
+    {
+      PrintDiagnostics ();
+    }
+}
+
+bool
+RttEnsemble::GetErrorSum (double &errorSum, uint32_t &samples) const
+{
+  errorSum = m_diagErrorSum;
+  samples = m_diagSamples;
+  return true;
+}
+
+TypeId
+RttEnsemble::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+
+void
+RttEnsemble::InitializeState (void)
+{
+  NS_ABORT_MSG_IF (!(m_minGain > 0 && m_minGain <= m_maxGain && m_maxGain <= 1),
+                   "RttEnsemble needs 0 < MinGain <= MaxGain <= 1, not " << m_minGain << " and " << m_maxGain);
+  uint32_t n = m_numTrackers;
+  m_state.assign (ENSEMBLE_BLOCKS * n, 0.0);
+  double *alpha = &m_state[ENSEMBLE_ALPHA * n];
+  double *beta = &m_state[ENSEMBLE_BETA * n];
+  double *weight = &m_state[ENSEMBLE_WEIGHT * n];
+  for (uint32_t k = 0; k < n; k++)
+    {
+      // Geometric spread from the slowest to the fastest gain
+      double position = (n > 1) ? (double)k / (n - 1) : 0.0;
+      alpha[k] = m_minGain * std::pow (m_maxGain / m_minGain, position);
+      beta[k] = std::min (1.0, 2 * alpha[k]);
+      weight[k] = 1.0 / n;
+    }
+  m_trackersStarted = false;
+  m_stateMinGain = m_minGain;
+  m_stateMaxGain = m_maxGain;
+}
+
+void
+RttEnsemble::CheckState (void)
+{
+  if (m_state.size () != ENSEMBLE_BLOCKS * (uint32_t)m_numTrackers
+      || m_stateMinGain != m_minGain || m_stateMaxGain != m_maxGain)
+    {
+      InitializeState ();
+    }
+}
+
+void
+RttEnsemble::Measurement (Time m)
+{
+  RttEstimatorStats::MeasurementTimer timer (EnsembleStats ());
+
+  CheckState ();
+  uint32_t n = m_numTrackers;
+
+  m_diagErrorSum += std::abs (m_estimatedRtt.GetMilliSeconds () - m.GetMilliSeconds ());
+  m_diagSamples++;
+
+  const double *alpha = &m_state[ENSEMBLE_ALPHA * n];
+  const double *beta = &m_state[ENSEMBLE_BETA * n];
+  double *srtt = &m_state[ENSEMBLE_SRTT * n];
+  double *rttvar = &m_state[ENSEMBLE_RTTVAR * n];
+  double *weight = &m_state[ENSEMBLE_WEIGHT * n];
+
+  double sample = m.ToDouble (Time::S);
+
+  if (!m_trackersStarted)
+    {
+      // First sample, as in RttMeanDeviation
+      for (uint32_t k = 0; k < n; k++)
+        {
+          srtt[k] = sample;
+          rttvar[k] = sample / 2;
+        }
+      m_trackersStarted = true;
+    }
+  else
+    {
+      // Score each tracker's prediction, then update the tracker with the
+      // sample. RttFixedShare's flat loss for underestimates would not
+      // tell the trackers apart while they all climb after a route change,
+      // so underestimates cost twice the squared error instead.
+      double weightSum = 0;
+      for (uint32_t k = 0; k < n; k++)
+        {
+          double err = sample - srtt[k];
+          double loss = (err > 0) ? 2.0 * err * err : err * err;
+          weight[k] *= std::exp (-m_lr * loss);
+          weightSum += weight[k];
+
+          srtt[k] += alpha[k] * err;
+          rttvar[k] += beta[k] * (std::abs (err) - rttvar[k]);
+        }
+
+      if (!(weightSum > 0))
+        {
+          if (RttEstimatorStats::IsEnabled ())
+            {
+              EnsembleStats ().events[RttEstimatorStats::WEIGHT_UNDERFLOW]++;
+            }
+          for (uint32_t k = 0; k < n; k++)
+            {
+              weight[k] = 1.0;
+            }
+          weightSum = n;
+        }
+
+      // Share, keeping the weights normalized
+      double pool = m_alpha / n;
+      for (uint32_t k = 0; k < n; k++)
+        {
+          weight[k] = (1 - m_alpha) * weight[k] / weightSum + pool;
+        }
+    }
+
+  double estimate = 0;
+  double variation = 0;
+  for (uint32_t k = 0; k < n; k++)
+    {
+      estimate += weight[k] * srtt[k];
+      variation += weight[k] * rttvar[k];
+    }
+  m_estimatedRtt = Time::FromDouble (estimate, Time::S);
+  m_estimatedVariation = Time::FromDouble (variation, Time::S);
+  m_nSamples++;
+}
+
+Ptr<RttEstimator>
+RttEnsemble::Copy () const
+{
+  NS_LOG_FUNCTION (this);
+  if (RttEstimatorStats::IsEnabled ())
+    {
+      EnsembleStats ().copies++;
+    }
+  return CopyObject<RttEnsemble> (this);
+}
+
+void
+RttEnsemble::Reset ()
+{
+  NS_LOG_FUNCTION (this);
+  if (RttEstimatorStats::IsEnabled ())
+    {
+      EnsembleStats ().resets++;
+    }
+  RttEstimator::Reset ();
+  // The trackers restart from the next sample, the weights are kept
+  m_trackersStarted = false;
+}
+
+double
+RttEnsemble::GetWeight (uint32_t i)
+{
+  CheckState ();
+  NS_ASSERT (i < (uint32_t)m_numTrackers);
+  return m_state[ENSEMBLE_WEIGHT * m_numTrackers + i];
+}
+
+double
+RttEnsemble::GetGain (uint32_t i)
+{
+  CheckState ();
+  NS_ASSERT (i < (uint32_t)m_numTrackers);
+  return m_state[ENSEMBLE_ALPHA * m_numTrackers + i];
+}
+
+void
+RttEnsemble::DoSerialize (std::ostream &os) const
+{
+  WriteValue<int32_t> (os, m_numTrackers);
+  WriteValue<double> (os, m_minGain);
+  WriteValue<double> (os, m_maxGain);
+  WriteValue<double> (os, m_alpha);
+  WriteValue<double> (os, m_lr);
+  WriteValue<uint8_t> (os, m_trackersStarted);
+  WriteValue<uint32_t> (os, m_diagSamples);
+  WriteValue<int64_t> (os, m_diagErrorSum);
+  WriteDoubles (os, m_state.data (), m_state.size ());
+}
+
+bool
+RttEnsemble::DoDeserialize (std::istream &is)
+{
+  int32_t numTrackers = ReadValue<int32_t> (is);
+  double minGain = ReadValue<double> (is);
+  double maxGain = ReadValue<double> (is);
+  double alpha = ReadValue<double> (is);
+  double lr = ReadValue<double> (is);
+  uint8_t trackersStarted = ReadValue<uint8_t> (is);
+  uint32_t diagSamples = ReadValue<uint32_t> (is);
+  int64_t diagErrorSum = ReadValue<int64_t> (is);
+  std::vector<double> state = ReadDoubles (is);
+  if (!is || numTrackers <= 0 || state.size () != ENSEMBLE_BLOCKS * (uint64_t)numTrackers
+      || !(minGain > 0 && minGain <= maxGain && maxGain <= 1)
+      || !(alpha >= 0 && alpha <= 1) || !(lr >= 0) || diagErrorSum < 0)
+    {
+      return false;
+    }
+  m_numTrackers = numTrackers;
+  m_minGain = minGain;
+  m_maxGain = maxGain;
+  m_alpha = alpha;
+  m_lr = lr;
+  m_trackersStarted = trackersStarted;
+  m_diagSamples = diagSamples;
+  m_diagErrorSum = diagErrorSum;
+  m_state.swap (state);
+  // The gains are restored along with the state
+  m_stateMinGain = m_minGain;
+  m_stateMaxGain = m_maxGain;
+  return true;
+}
+
+void
+RttEnsemble::PrintDiagnostics (void)
+{
+  double differenceSum = (double)m_diagErrorSum / (double)m_diagSamples;
+
+  NS_LOG_DEBUG ("Mean error of " << differenceSum << " with a weight of " << m_diagSamples);
+}
+
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+// Shadow Estimator
+
+NS_OBJECT_ENSURE_REGISTERED (RttShadowEstimator);
+
+TypeId
+RttShadowEstimator::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::RttShadowEstimator")
+    .SetParent<RttEstimator> ()
+    .SetGroupName ("Internet")
+    .AddConstructor<RttShadowEstimator> ()
+    .AddAttribute ("Primary",
+                   "Type of the estimator whose estimate is used by TCP",
+                   TypeIdValue (RttFixedShare::GetTypeId ()),
+                   MakeTypeIdAccessor (&RttShadowEstimator::m_primaryType),
+                   MakeTypeIdChecker ())
+    .AddAttribute ("Shadows",
+                   "Comma separated types of the estimators fed the same samples "
+                   "without affecting TCP, e.g. \"ns3::RttMeanDeviation\"",
+                   StringValue ("ns3::RttMeanDeviation"),
+                   MakeStringAccessor (&RttShadowEstimator::m_shadowTypes),
+                   MakeStringChecker ())
+  ;
+  return tid;
+}
+
+RttShadowEstimator::RttShadowEstimator ()
+  : m_primaryType (RttFixedShare::GetTypeId ()),
+    m_shadowTypes ("ns3::RttMeanDeviation"),
+    m_comparedSamples (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+RttShadowEstimator::RttShadowEstimator (const RttShadowEstimator& c)
+  : RttEstimator (c),
+    m_primaryType (c.m_primaryType),
+    m_shadowTypes (c.m_shadowTypes),
+    m_errorSum (c.m_errorSum.size (), 0.0),
+    m_comparedSamples (0)
+{
+  NS_LOG_FUNCTION (this);
+  for (uint32_t i = 0; i < c.m_estimators.size (); i++)
+    {
+      m_estimators.push_back (c.m_estimators[i]->Copy ());
+    }
+}
+
+RttShadowEstimator::~RttShadowEstimator ()
+{
+  NS_LOG_FUNCTION (this);
+  if (m_comparedSamples > 0)
+    {
+      PrintDiagnostics ();
+    }
+}
+
+TypeId
+RttShadowEstimator::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+
+void
+RttShadowEstimator::CreateEstimators (void)
+{
+  if (!m_estimators.empty ())
+    {
+      return;
+    }
+
+  ObjectFactory factory;
+  factory.SetTypeId (m_primaryType);
+  m_estimators.push_back (factory.Create<RttEstimator> ());
+
+  std::stringstream ss (m_shadowTypes);
+  std::string name;
+  while (std::getline (ss, name, ','))
+    {
+      if (name.empty ())
+        {
+          continue;
+        }
+      factory.SetTypeId (TypeId::LookupByName (name));
+      m_estimators.push_back (factory.Create<RttEstimator> ());
+    }
+  m_errorSum.assign (m_estimators.size (), 0.0);
+  NS_LOG_DEBUG ("Created " << m_estimators.size () << " estimators");
+}
+
+void
+RttShadowEstimator::UpdateFromPrimary (void)
+{
+  m_estimatedRtt = m_estimators[0]->GetEstimate ();
+  m_estimatedVariation = m_estimators[0]->GetVariation ();
+  m_nSamples = m_estimators[0]->GetNSamples ();
+}
+
+void
+RttShadowEstimator::Measurement (Time measure)
+{
+  NS_LOG_FUNCTION (this << measure);
+  CreateEstimators ();
+
+  for (uint32_t i = 0; i < m_estimators.size (); i++)
+    {
+      // Score the estimate the estimator had before seeing the sample
+      m_errorSum[i] += std::abs ((m_estimators[i]->GetEstimate () - measure).ToDouble (Time::MS));
+      m_estimators[i]->Measurement (measure);
+    }
+  m_comparedSamples++;
+  UpdateFromPrimary ();
+}
+
+Ptr<RttEstimator>
+RttShadowEstimator::Copy () const
+{
+  NS_LOG_FUNCTION (this);
+  return CopyObject<RttShadowEstimator> (this);
+}
+
+void
+RttShadowEstimator::Reset ()
+{
+  NS_LOG_FUNCTION (this);
+  RttEstimator::Reset ();
+  for (uint32_t i = 0; i < m_estimators.size (); i++)
+    {
+      m_estimators[i]->Reset ();
+    }
+  if (!m_estimators.empty ())
+    {
+      UpdateFromPrimary ();
+    }
+}
+
+uint32_t
+RttShadowEstimator::GetNEstimators (void)
+{
+  CreateEstimators ();
+  return m_estimators.size ();
+}
+
+Ptr<RttEstimator>
+RttShadowEstimator::GetEstimator (uint32_t i)
+{
+  CreateEstimators ();
+  NS_ASSERT (i < m_estimators.size ());
+  return m_estimators[i];
+}
+
+double
+RttShadowEstimator::GetMeanError (uint32_t i)
+{
+  CreateEstimators ();
+  NS_ASSERT (i < m_estimators.size ());
+  return m_comparedSamples ? m_errorSum[i] / m_comparedSamples : 0;
+}
+
+void
+RttShadowEstimator::DoSerialize (std::ostream &os) const
+{
+  WriteString (os, m_primaryType.GetName ());
+  WriteString (os, m_shadowTypes);
+  WriteValue<uint32_t> (os, m_comparedSamples);
+  WriteDoubles (os, m_errorSum.data (), m_errorSum.size ());
+  WriteValue<uint32_t> (os, m_estimators.size ());
+  for (uint32_t i = 0; i < m_estimators.size (); i++)
+    {
+      m_estimators[i]->Serialize (os);
+    }
+}
+
+bool
+RttShadowEstimator::DoDeserialize (std::istream &is)
+{
+  std::string primaryName = ReadString (is);
+  std::string shadowTypes = ReadString (is);
+  uint32_t comparedSamples = ReadValue<uint32_t> (is);
+  std::vector<double> errorSum = ReadDoubles (is);
+  uint32_t n = ReadValue<uint32_t> (is);
+  TypeId primaryType;
+  if (!is || !TypeId::LookupByNameFailSafe (primaryName, &primaryType) || n != errorSum.size ())
+    {
+      return false;
+    }
+  // The estimators are restored aside, the record may still be cut short
+  std::vector<Ptr<RttEstimator> > estimators;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      Ptr<RttEstimator> rtt = CreateFromSerialized (is);
+      if (rtt == 0)
+        {
+          return false;
+        }
+      estimators.push_back (rtt);
+    }
+  if (!estimators.empty () && estimators[0]->GetInstanceTypeId () != primaryType)
+    {
+      return false;
+    }
+  m_primaryType = primaryType;
+  m_shadowTypes = shadowTypes;
+  m_comparedSamples = comparedSamples;
+  m_errorSum.swap (errorSum);
+  m_estimators.swap (estimators);
+  return true;
+}
+
+void
+RttShadowEstimator::PrintDiagnostics (void)
+{
+  for (uint32_t i = 0; i < m_estimators.size (); i++)
+    {
+      NS_LOG_DEBUG ("Shadow comparison: " << (i == 0 ? "primary " : "shadow ")
+                    << m_estimators[i]->GetInstanceTypeId ().GetName ()
+                    << " mean error of " << m_errorSum[i] / m_comparedSamples
+                    << " with a weight of " << m_comparedSamples);
+    }
+}
+
 } //namespace ns3
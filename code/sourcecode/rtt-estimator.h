@@ -25,9 +25,13 @@
 #ifndef RTT_ESTIMATOR_H
 #define RTT_ESTIMATOR_H
 
+#include <atomic>
+#include <iostream>
+
 #include "ns3/nstime.h"
 #include "ns3/object.h"
 #include "ns3/assert.h"
+#include "ns3/type-id.h"
 
 namespace ns3 {
 
@@ -81,7 +85,7 @@ public:
    * \brief gets the RTT estimate.
    * \return The RTT estimate.
    */
-  Time GetEstimate (void) const;
+  virtual Time GetEstimate (void) const;
 
   /**
    * Note that this is not a formal statistical variance; it has the
@@ -91,7 +95,7 @@ public:
    * \brief gets the RTT estimate variation.
    * \return The RTT estimate variation.
    */
-  Time GetVariation (void) const;
+  virtual Time GetVariation (void) const;
 
   /**
    * \brief gets the number of samples used in the estimates
@@ -99,7 +103,111 @@ public:
    */
   uint32_t GetNSamples (void) const;
 
+  /**
+   * \brief Writes the complete state of the estimator, parameters included.
+   *
+   * The state is written as a compact binary record, in the byte order of
+   * the machine, starting with the name of the estimator type.  It can be
+   * restored with Deserialize or CreateFromSerialized to checkpoint and
+   * resume a run, or to reuse a learned state in another experiment.
+   *
+   * \param os the stream to write to
+   */
+  void Serialize (std::ostream &os) const;
+
+  /**
+   * \brief Restores a state written by Serialize.
+   * \param is the stream to read from
+   * \return false if the record is truncated, invalid, or was written by
+   * another type of estimator
+   */
+  bool Deserialize (std::istream &is);
+
+  /**
+   * \brief Creates an estimator of the type a record was written by, and
+   * restores its state.
+   * \param is the stream to read from
+   * \return the estimator, or 0 if the record cannot be restored
+   */
+  static Ptr<RttEstimator> CreateFromSerialized (std::istream &is);
+
+  /**
+   * \brief Gets the error accumulators the diagnostics are printed from.
+   * \param errorSum set to the sum of the absolute errors, in milliseconds
+   * \param samples set to the number of errors in the sum
+   * \return false if the estimator keeps no such accumulators
+   */
+  virtual bool GetErrorSum (double &errorSum, uint32_t &samples) const;
+
+  /**
+   * \brief Error accumulators of one estimator, see GetErrorSnapshot
+   */
+  struct ErrorRecord
+  {
+    std::string typeName; //!< Name of the estimator type
+    double errorSum;      //!< Sum of the absolute errors, in milliseconds
+    uint32_t samples;     //!< Number of errors in the sum
+    bool live;            //!< false if the estimator has been destroyed
+  };
+
+  /**
+   * \brief Keeps track of every estimator created from now on, for
+   * GetErrorSnapshot.  Meant to be called once, before the first
+   * estimator is created; off by default.
+   */
+  static void EnableErrorTracking (void);
+
+  /**
+   * \brief Gets the error accumulators of the tracked estimators that have
+   * errors, those still alive and those already destroyed, so that the
+   * results of a run can be saved while it is running.
+   * \return one record per estimator
+   */
+  static std::vector<ErrorRecord> GetErrorSnapshot (void);
+
+protected:
+  /**
+   * \brief Moves the errors of a tracked estimator to the destroyed ones.
+   *
+   * To be called by the destructors of the subclasses that implement
+   * GetErrorSum, while their accumulators still exist.
+   */
+  void RetireErrors (void);
+
+  /**
+   * \brief Waits until the state reflects every measurement.
+   *
+   * For the estimators that apply their measurements on another thread.
+   * Called before the state is read or written other than through
+   * Measurement, GetEstimate and GetVariation; does nothing by default.
+   */
+  virtual void Synchronize (void) const;
+
+  /**
+   * \brief Writes the state of the subclass, after the one of RttEstimator.
+   * \param os the stream to write to
+   */
+  virtual void DoSerialize (std::ostream &os) const;
+
+  /**
+   * \brief Restores the state written by DoSerialize.
+   *
+   * The whole state is read and checked before it is applied, so that an
+   * invalid or truncated one leaves the subclass as it was.
+   *
+   * \param is the stream to read from
+   * \return false if the state is invalid
+   */
+  virtual bool DoDeserialize (std::istream &is);
+
 private:
+  /**
+   * \brief Restores the record of Serialize that follows the type name.
+   * \param is the stream to read from
+   * \return false if the record is truncated or invalid
+   */
+  bool DeserializeState (std::istream &is);
+
   Time m_initialEstimatedRtt; //!< Initial RTT estimation
 
 protected:
@@ -152,7 +260,12 @@ public:
    */
   void Reset ();
 
+  virtual bool GetErrorSum (double &errorSum, uint32_t &samples) const;
+
 private:
+  virtual void DoSerialize (std::ostream &os) const;
+  virtual bool DoDeserialize (std::istream &is);
+
   /** 
    * Utility function to check for possible conversion
    * of a double value (0 < value < 1) to a reciprocal power of two
@@ -186,8 +299,8 @@ private:
   double       m_beta;        //!< Filter gain for variation
   
   // For analytics gathering:
-  std::vector<double> m_estimates;
-  std::vector<double> m_actuals;
+  uint32_t m_diagSamples;    //!< Number of measurements seen
+  int64_t m_diagErrorSum;    //!< Sum of absolute errors, in milliseconds
 
   ~RttMeanDeviation();
 
@@ -196,14 +309,23 @@ private:
 };
 
 
+class RttFixedShareWorker;
+
 /**
  * \ingroup tcp
  *
  * \brief The Fixed Share Experts RTT estimator, as defined in:
  * https://link.springer.com/article/10.1186/1687-1499-2014-47
  *
+ * With AsyncUpdates, for emulation with the real-time simulator, Measurement
+ * only queues the sample and a worker thread shared by all the estimators
+ * runs the update, so that a large expert grid does not hold up packet
+ * processing. GetEstimate and GetVariation return the last estimate the
+ * worker published, at most MaxPendingSamples samples behind; every other
+ * method waits for the queued samples first.
  */
 class RttFixedShare : public RttEstimator {
+  friend class RttFixedShareWorker;
 public:
 
   /**
@@ -212,6 +334,16 @@ public:
    */
   static TypeId GetTypeId (void);
 
+  /**
+   * \brief How the RTT variation is estimated
+   */
+  enum VariationMode
+  {
+    EWMA_VARIATION,     //!< EWMA of the absolute error, as in RttMeanDeviation
+    QUANTILE_VARIATION, //!< Weighted upper quantile of the expert distribution
+    EXPERT_VARIATION    //!< Fixed Share over a second grid of absolute error experts
+  };
+
   /**
    * Constructor for class
    *
@@ -235,34 +367,520 @@ public:
 
   ~RttFixedShare ();
 
+  virtual bool GetErrorSum (double &errorSum, uint32_t &samples) const;
+
+  /**
+   * With AsyncUpdates, this is the estimate published by the last sample
+   * the worker thread has applied, which lags Measurement by at most
+   * MaxPendingSamples samples.
+   *
+   * \brief gets the RTT estimate.
+   * \return The RTT estimate.
+   */
+  virtual Time GetEstimate (void) const;
+
+  /**
+   * \brief gets the RTT estimate variation, published like GetEstimate.
+   * \return The RTT estimate variation.
+   */
+  virtual Time GetVariation (void) const;
+
+  /**
+   * \brief Computes the expert grid used by the estimator.
+   *
+   * Expert i (1-based) predicts rttMax * 2^((i - numExperts) / 4) seconds,
+   * so the grid is dense at small RTTs and sparse at large ones.
+   *
+   * \param numExperts the number of experts
+   * \return the expert predictions, in seconds
+   */
+  static std::vector<double> GetExpertGrid (int numExperts);
+
+  /**
+   * \brief What an estimator learned, kept to warm start later ones
+   */
+  struct Summary
+  {
+    std::vector<double> weights; //!< Normalized expert weights
+    Time variation;              //!< Variation estimate
+    double cumulativeGap;        //!< Mixability gap of AdaptiveLR
+    Time lastMeasurement;        //!< Time of the last measurement, or zero
+  };
+
+  /**
+   * \return a copy of what the estimator learned, for WarmStart
+   */
+  Summary GetSummary (void) const;
+
+  /**
+   * \brief Seeds the weights from the distribution learned by another estimator.
+   *
+   * The seeded weights are keep * w + (1 - keep) / N, where w are the
+   * normalized weights of the other estimator, so that stale knowledge
+   * can be partially reverted to the uniform prior.  The estimate and
+   * variation are updated accordingly.  Nothing happens if the two
+   * estimators do not use the same number of experts.
+   *
+   * \param other the estimator to copy the weights from
+   * \param keep the fraction of the learned distribution to keep, in [0, 1]
+   */
+  void WarmStart (Ptr<const RttFixedShare> other, double keep);
+
+  /**
+   * \brief Seeds the weights from a summary of another estimator.
+   * \param summary what the other estimator learned, see GetSummary
+   * \param keep the fraction of the learned distribution to keep, in [0, 1]
+   */
+  void WarmStart (const Summary &summary, double keep);
+
+  /**
+   * For an estimator that was warm started and has not measured anything
+   * yet, this is the time of the last measurement of the estimator it
+   * was seeded from.
+   *
+   * \brief gets the simulation time of the last measurement
+   * \return the time of the last measurement, or zero if there was none
+   */
+  Time GetLastMeasurementTime (void) const;
+
+  /**
+   * With AdaptiveLR, the rate is ln (NumExperts) divided by the mixability
+   * gap accumulated so far, as in AdaHedge (de Rooij et al., "Follow the
+   * Leader If You Can, Hedge If You Must", JMLR 2014), so it no longer
+   * depends on the RTT scale of the network.  Unlike AdaHedge, the gap is
+   * discounted by 1 - Alpha per sample to match the sharing.  LR is used
+   * until a gap has been measured.
+   *
+   * \brief gets the learning rate used by the next measurement
+   * \return the learning rate
+   */
+  double GetLearningRate (void) const;
+
+  /**
+   * \brief Hints that the route to the peer changed.
+   *
+   * The RTT usually jumps when the route changes, and with the constant
+   * share rate Alpha it takes dozens of samples to move the weights.
+   * This raises the share rate to BoostAlpha, from which it decays back
+   * to Alpha by BoostDecay at each sample, so the weights reconverge in a
+   * few samples.  With ShiftDetection the estimator calls this by itself
+   * when the prediction error spikes.  It can be bound to a routing or socket
+   * trace with MakeCallback (&RttFixedShare::RouteChanged, estimator).
+   */
+  void RouteChanged (void);
+
+  /**
+   * \return the share rate the next measurement will use
+   */
+  double GetShareRate (void) const;
+
+  /**
+   * \return the current expert weights, normalized, in the order of
+   * GetExpertGrid.  Used to train priors (see PriorFile).
+   */
+  std::vector<double> GetWeights (void) const;
+
 private:
+  virtual void DoSerialize (std::ostream &os) const;
+  virtual bool DoDeserialize (std::istream &is);
+  virtual void Synchronize (void) const;
+
+  /**
+   * \brief Waits for the pending samples of an estimator being copied.
+   * \param c the estimator
+   * \return c
+   */
+  static const RttFixedShare &Synchronized (const RttFixedShare &c);
+
+  /**
+   * \brief Runs the Fixed Share update for one sample and publishes the
+   * new estimate and variation.
+   *
+   * Called by Measurement, or on the worker thread with AsyncUpdates.
+   *
+   * \param measure the RTT sample
+   */
+  void Update (Time measure);
+
+  /**
+   * \brief Copies the estimate and variation to the values GetEstimate and
+   * GetVariation return with AsyncUpdates.
+   */
+  void Publish (void);
+
+  /**
+   * \brief Sets the prior file and restarts the weights from it.
+   * \param path the prior file, empty for uniform weights
+   */
+  void SetPriorFile (std::string path);
+
+  /**
+   * \return the prior file, empty if none
+   */
+  std::string GetPriorFile (void) const;
+
 
   /** 
    * Members
   */
   int m_numExperts;
-  std::vector<double> m_experts;
-  std::vector<double> m_weights;
-  std::vector<double> m_losses;
+  int m_slabExperts;       //!< Number of experts the pooled slab holds, 0 if none
+  const double *m_experts; //!< Expert grid, shared by all estimators of the same size
+  double *m_weights;       //!< Per-expert weights, in a pooled slab
+  double *m_losses;        //!< Per-expert losses, in the same slab
   double m_alpha;
   double m_beta;
   double m_lr;
+  bool m_adaptiveLr;       //!< Whether the learning rate is tuned online
+  double m_cumulativeGap;  //!< Discounted cumulative mixability gap, for AdaptiveLR
+  VariationMode m_variationMode; //!< How the variation is estimated
+  double m_quantile;             //!< Quantile used in QUANTILE_VARIATION mode
+  int m_numVarExperts;           //!< Size of the variation grid in EXPERT_VARIATION mode
+  double m_varLr;                //!< Learning rate of the variation grid
+  int m_varSlabExperts;          //!< Number of experts the variation slab holds, 0 if none
+  const double *m_varExperts;    //!< Variation grid, shared like m_experts
+  double *m_varWeights;          //!< Variation expert weights, in a pooled slab
+  double *m_varLosses;           //!< Variation expert losses, in the same slab
+  double m_boostAlpha;           //!< Share rate right after a route change
+  double m_boostDecay;           //!< Decay factor of the share rate boost, per sample
+  double m_shareBoost;           //!< Current share rate on top of Alpha
+  bool m_shiftDetection;         //!< Whether error spikes are taken as route changes
+  double m_shiftThreshold;       //!< Error spike ratio taken as a route change
+  double m_errorAverage;         //!< Running average of the absolute prediction error
+  std::string m_priorFile;       //!< File of the initial weights, empty if uniform
+  const double *m_prior;         //!< Initial weights, mapped from m_priorFile, 0 if uniform
+  int m_priorExperts;            //!< Number of experts m_prior was trained for
+  Time m_lastMeasurement; //!< Simulation time of the last measurement
+  bool m_async;                  //!< Whether samples are applied on the worker thread
+  uint32_t m_maxPending;         //!< Samples that may wait for the worker before Measurement blocks
+  mutable std::atomic<uint32_t> m_pending;     //!< Samples queued and not yet applied
+  std::atomic<int64_t> m_publishedRtt;         //!< Published estimate, in time steps
+  std::atomic<int64_t> m_publishedVariation;   //!< Published variation, in time steps
 
   // For analytics gathering:
-  std::vector<double> m_estimates;
-  std::vector<double> m_actuals;
+  uint32_t m_diagSamples;      //!< Number of measurements seen
+  int64_t m_diagErrorSum;      //!< Sum of absolute errors, in milliseconds
+  int64_t m_diagBiggestActual; //!< Largest measurement, in milliseconds
+  uint32_t m_diagBiggestIndex; //!< Index of the largest measurement
 
 
   /** 
    * Method to initialize the expert and weight vectors.
+   *
+   * The per-expert state lives in a slab taken from a pool shared by all
+   * RttFixedShare instances of the same size, and is given back when the
+   * estimator is destroyed, i.e. when its socket goes away.
   */
   void InitializeVectors();
 
+  /**
+   * Gives the slabs back to the pool.
+   */
+  void ReleaseVectors();
+
+  /**
+   * Method to initialize the variation grid, with uniform weights.
+   *
+   * The grid has the shape of the RTT grid: its experts predict absolute
+   * errors between about a millisecond and 400 ms, and its slab comes
+   * from the same pool.
+   */
+  void InitializeVariationVectors();
+
+  /**
+   * Runs the Fixed Share update of the variation grid.
+   *
+   * \param deviation the absolute error of the last estimate, in seconds
+   * \return the predicted absolute error, in seconds
+   */
+  double UpdateVariationExperts(double deviation);
+
   // Method to print diagnostics about RTT
   void PrintDiagnostics();
   
 };
 
+
+/**
+ * \ingroup tcp
+ *
+ * \brief A scalar Kalman filter RTT estimator
+ *
+ * The RTT is modeled as a random walk observed through noisy samples:
+ * between samples the true RTT drifts with variance Q (ProcessNoise), and
+ * each sample adds independent noise of variance R (MeasurementNoise).
+ * Each sample moves the estimate towards it by the Kalman gain
+ * (P + Q) / (P + Q + R), P being the variance of the estimate, so the gain
+ * is large when the estimate is uncertain and shrinks as it settles.
+ * The variation is a moving average of the absolute innovation (sample
+ * minus estimate) with gain VariationGain, as RTTVAR in RFC 6298, so it
+ * follows the jitter of the path rather than the fixed noises of the
+ * model.  It starts at sqrt (R).
+ *
+ * The update is O(1) and allocation-free, for flows with too many
+ * samples for RttFixedShare.
+ */
+class RttKalman : public RttEstimator {
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  RttKalman ();
+
+  /**
+   * \brief Copy constructor
+   * \param r the object to copy
+   */
+  RttKalman (const RttKalman& r);
+
+  virtual ~RttKalman ();
+
+  virtual TypeId GetInstanceTypeId (void) const;
+
+  /**
+   * \brief Add a new measurement to the estimator.
+   * \param measure the new RTT measure.
+   */
+  void Measurement (Time measure);
+
+  Ptr<RttEstimator> Copy () const;
+
+  /**
+   * \brief Resets the estimator.
+   */
+  void Reset ();
+
+  /**
+   * \return the variance of the estimate, in s^2
+   */
+  double GetErrorVariance (void) const;
+
+  virtual bool GetErrorSum (double &errorSum, uint32_t &samples) const;
+
+private:
+  virtual void DoSerialize (std::ostream &os) const;
+  virtual bool DoDeserialize (std::istream &is);
+
+  /**
+   * \brief Prints the mean error of the estimator
+   */
+  void PrintDiagnostics (void);
+
+  double m_processNoise;     //!< Variance added to the RTT between samples, in s^2
+  double m_measurementNoise; //!< Variance of the sample noise, in s^2
+  double m_variationGain;    //!< Gain of the moving average of the absolute innovation
+  double m_errorVariance;    //!< Variance of the estimate (P), in s^2
+
+  // For analytics gathering:
+  uint32_t m_diagSamples;    //!< Number of measurements seen
+  int64_t m_diagErrorSum;    //!< Sum of absolute errors, in milliseconds
+};
+
+
+/**
+ * \ingroup tcp
+ *
+ * \brief Fixed Share over a bank of Mean--Deviation trackers
+ *
+ * Where RttFixedShare weighs constant experts, this estimator weighs
+ * NumTrackers EWMA trackers, each updated like RttMeanDeviation with its
+ * own gains.  The gains are spread geometrically between MinGain and
+ * MaxGain (beta being twice alpha, as in RFC 6298), so slow trackers
+ * give a smooth estimate while fast ones follow the jumps of a route
+ * change within a few samples.  The weights use the same exponential
+ * update (LR) and sharing (Alpha) as RttFixedShare, with the squared error
+ * as loss, doubled for underestimates; the estimate and variation are the
+ * weighted means of those of the trackers.
+ *
+ * The state is kept as one array per quantity, so a dozen trackers cost
+ * about as much per sample as RttFixedShare's 100 constant experts.
+ */
+class RttEnsemble : public RttEstimator {
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  RttEnsemble ();
+
+  /**
+   * \brief Copy constructor
+   * \param r the object to copy
+   */
+  RttEnsemble (const RttEnsemble& r);
+
+  virtual ~RttEnsemble ();
+
+  virtual TypeId GetInstanceTypeId (void) const;
+
+  /**
+   * \brief Add a new measurement to every tracker and reweigh them.
+   * \param measure the new RTT measure.
+   */
+  void Measurement (Time measure);
+
+  Ptr<RttEstimator> Copy () const;
+
+  /**
+   * \brief Resets the trackers, keeping their learned weights.
+   */
+  void Reset ();
+
+  virtual bool GetErrorSum (double &errorSum, uint32_t &samples) const;
+
+  /**
+   * \param i the tracker index, from the slowest to the fastest
+   * \return the normalized weight of the tracker
+   */
+  double GetWeight (uint32_t i);
+
+  /**
+   * \param i the tracker index, from the slowest to the fastest
+   * \return the RTT gain (alpha) of the tracker
+   */
+  double GetGain (uint32_t i);
+
+private:
+  virtual void DoSerialize (std::ostream &os) const;
+  virtual bool DoDeserialize (std::istream &is);
+
+  /**
+   * \brief Lays out the state for NumTrackers trackers with uniform weights
+   */
+  void InitializeState (void);
+
+  /**
+   * \brief Lays out the state again if NumTrackers, MinGain or MaxGain
+   * changed since it was laid out.
+   *
+   * The attributes are set after the constructor, so the state is only
+   * known to match them when it is used.
+   */
+  void CheckState (void);
+
+  /**
+   * \brief Prints the mean error of the estimator
+   */
+  void PrintDiagnostics (void);
+
+  int m_numTrackers;          //!< Number of trackers
+  double m_minGain;           //!< RTT gain of the slowest tracker
+  double m_maxGain;           //!< RTT gain of the fastest tracker
+  double m_alpha;             //!< Weight sharing parameter
+  double m_lr;                //!< Learning rate
+  bool m_trackersStarted;     //!< Whether the trackers have seen a sample since the last reset
+  double m_stateMinGain;      //!< MinGain the state was laid out with
+  double m_stateMaxGain;      //!< MaxGain the state was laid out with
+
+  /**
+   * Per-tracker state, one block of m_numTrackers doubles per quantity:
+   * RTT gains, variation gains, smoothed RTTs, variations, weights.
+   */
+  std::vector<double> m_state;
+
+  // For analytics gathering:
+  uint32_t m_diagSamples;    //!< Number of measurements seen
+  int64_t m_diagErrorSum;    //!< Sum of absolute errors, in milliseconds
+};
+
+
+/**
+ * \ingroup tcp
+ *
+ * \brief Feeds the same samples to several estimators for comparison
+ *
+ * The shadow estimator owns a primary estimator, whose estimate and
+ * variation are the ones TCP sees, and any number of shadow estimators
+ * that receive exactly the same samples but have no effect on the
+ * connection.  For every estimator the error of its estimate against
+ * each new sample is accumulated, so that one simulation yields a paired
+ * comparison of estimators on the same workload.
+ *
+ * The estimators are created with their default attributes when first
+ * needed.  The comparison is printed when the object is destroyed, one
+ * line per estimator, starting with "Shadow".
+ */
+class RttShadowEstimator : public RttEstimator {
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  RttShadowEstimator ();
+
+  /**
+   * \brief Copy constructor, which also copies the owned estimators
+   * \param r the object to copy
+   */
+  RttShadowEstimator (const RttShadowEstimator& r);
+
+  virtual ~RttShadowEstimator ();
+
+  virtual TypeId GetInstanceTypeId (void) const;
+
+  /**
+   * \brief Add a new measurement to every estimator.
+   * \param measure the new RTT measure.
+   */
+  void Measurement (Time measure);
+
+  Ptr<RttEstimator> Copy () const;
+
+  /**
+   * \brief Resets every estimator.
+   */
+  void Reset ();
+
+  /**
+   * \return the number of estimators, the primary included
+   */
+  uint32_t GetNEstimators (void);
+
+  /**
+   * \param i the estimator index, 0 being the primary
+   * \return the estimator
+   */
+  Ptr<RttEstimator> GetEstimator (uint32_t i);
+
+  /**
+   * \param i the estimator index, 0 being the primary
+   * \return the mean absolute error of the estimator, in milliseconds
+   */
+  double GetMeanError (uint32_t i);
+
+private:
+  virtual void DoSerialize (std::ostream &os) const;
+  virtual bool DoDeserialize (std::istream &is);
+
+  /**
+   * \brief Creates the estimators from the attributes, if not done yet
+   */
+  void CreateEstimators (void);
+
+  /**
+   * \brief Mirrors the state of the primary estimator
+   */
+  void UpdateFromPrimary (void);
+
+  /**
+   * \brief Prints the comparison of the estimators
+   */
+  void PrintDiagnostics (void);
+
+  TypeId m_primaryType;                       //!< Type of the primary estimator
+  std::string m_shadowTypes;                  //!< Comma separated types of the shadows
+  std::vector<Ptr<RttEstimator> > m_estimators; //!< Primary first, then the shadows
+  std::vector<double> m_errorSum;             //!< Sum of absolute errors, in milliseconds
+  uint32_t m_comparedSamples;                 //!< Number of samples compared
+};
+
 } // namespace ns3
 
 #endif /* RTT_ESTIMATOR_H */
@@ -0,0 +1,223 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include <cmath>
+
+#include "rtt-fixed-share-bank.h"
+#include "rtt-estimator.h"
+#include "ns3/assert.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("RttFixedShareBank");
+
+RttFixedShareBank::RttFixedShareBank (const std::vector<Config> &configs, Time initialEstimate)
+  : m_configs (configs),
+    m_initialEstimate (initialEstimate),
+    m_nSamples (0)
+{
+  NS_LOG_FUNCTION (this << configs.size () << initialEstimate);
+
+  uint32_t nConfigs = m_configs.size ();
+  m_weightOffset.resize (nConfigs);
+  m_factorRow.resize (nConfigs);
+  m_estimate.resize (nConfigs);
+  m_variation.resize (nConfigs);
+  m_errorSum.resize (nConfigs);
+
+  uint32_t nWeights = 0;
+  for (uint32_t k = 0; k < nConfigs; k++)
+    {
+      const Config &config = m_configs[k];
+      NS_ASSERT_MSG (config.numExperts > 0, "Number of experts must be positive");
+
+      // Find or create the grid for this number of experts
+      uint32_t g = 0;
+      while (g < m_grids.size () && m_grids[g].numExperts != config.numExperts)
+        {
+          g++;
+        }
+      if (g == m_grids.size ())
+        {
+          Grid grid;
+          grid.numExperts = config.numExperts;
+          grid.experts = RttFixedShare::GetExpertGrid (config.numExperts);
+          grid.losses.resize (config.numExperts);
+          m_grids.push_back (grid);
+        }
+      Grid &grid = m_grids[g];
+      grid.configs.push_back (k);
+
+      // Configurations with the same learning rate share a factor row
+      uint32_t row = 0;
+      while (row < grid.lrs.size () && grid.lrs[row] != config.lr)
+        {
+          row++;
+        }
+      if (row == grid.lrs.size ())
+        {
+          grid.lrs.push_back (config.lr);
+          grid.factors.resize (grid.lrs.size () * grid.numExperts);
+        }
+      m_factorRow[k] = row;
+
+      m_weightOffset[k] = nWeights;
+      nWeights += config.numExperts;
+    }
+  m_weights.resize (nWeights);
+
+  Reset ();
+}
+
+void
+RttFixedShareBank::Reset ()
+{
+  NS_LOG_FUNCTION (this);
+  for (uint32_t k = 0; k < m_configs.size (); k++)
+    {
+      int numExperts = m_configs[k].numExperts;
+      double *weights = &m_weights[m_weightOffset[k]];
+      for (int i = 0; i < numExperts; i++)
+        {
+          weights[i] = 1.0 / numExperts;
+        }
+      m_estimate[k] = m_initialEstimate.ToDouble (Time::S);
+      m_variation[k] = 0;
+      m_errorSum[k] = 0;
+    }
+  m_nSamples = 0;
+}
+
+void
+RttFixedShareBank::Measurement (Time measure)
+{
+  double actualRtt = measure.ToDouble (Time::S);
+  for (uint32_t g = 0; g < m_grids.size (); g++)
+    {
+      UpdateGrid (m_grids[g], actualRtt);
+    }
+  m_nSamples++;
+}
+
+void
+RttFixedShareBank::UpdateGrid (Grid &grid, double actualRtt)
+{
+  int numExperts = grid.numExperts;
+  const double *experts = &grid.experts[0];
+  double *losses = &grid.losses[0];
+
+  // The loss only depends on the grid, so compute it once for all configurations
+  for (int i = 0; i < numExperts; i++)
+    {
+      losses[i] = experts[i] >= actualRtt ? (experts[i] - actualRtt) * (experts[i] - actualRtt)
+                                          : 2.0 * actualRtt;
+    }
+
+  // Likewise the exponential factors, once per distinct learning rate
+  for (uint32_t row = 0; row < grid.lrs.size (); row++)
+    {
+      double lr = grid.lrs[row];
+      double *factors = &grid.factors[row * numExperts];
+      for (int i = 0; i < numExperts; i++)
+        {
+          factors[i] = std::exp (-lr * losses[i]);
+        }
+    }
+
+  for (uint32_t c = 0; c < grid.configs.size (); c++)
+    {
+      uint32_t k = grid.configs[c];
+      const Config &config = m_configs[k];
+      double *weights = &m_weights[m_weightOffset[k]];
+      const double *factors = &grid.factors[m_factorRow[k] * numExperts];
+
+      // 1) Predict from the current weights
+      double numeratorSum = 0;
+      double denominatorSum = 0;
+      for (int i = 0; i < numExperts; i++)
+        {
+          numeratorSum += weights[i] * experts[i];
+          denominatorSum += weights[i];
+        }
+      double oldEstimate = m_estimate[k];
+      m_estimate[k] = numeratorSum / denominatorSum;
+      m_errorSum[k] += std::abs (oldEstimate - actualRtt) * 1000.0;
+
+      // 2) Exponential update and share in a single sweep
+      double pool = 0;
+      for (int i = 0; i < numExperts; i++)
+        {
+          weights[i] *= factors[i];
+          pool += weights[i];
+        }
+      pool *= config.alpha / numExperts;
+      for (int i = 0; i < numExperts; i++)
+        {
+          weights[i] = (1 - config.alpha) * weights[i] + pool;
+        }
+
+      // 3) Update variation
+      m_variation[k] = (1 - config.beta) * m_variation[k] + config.beta * std::abs (actualRtt - oldEstimate);
+    }
+}
+
+uint32_t
+RttFixedShareBank::GetNConfigs (void) const
+{
+  return m_configs.size ();
+}
+
+const RttFixedShareBank::Config &
+RttFixedShareBank::GetConfig (uint32_t k) const
+{
+  NS_ASSERT (k < m_configs.size ());
+  return m_configs[k];
+}
+
+Time
+RttFixedShareBank::GetEstimate (uint32_t k) const
+{
+  NS_ASSERT (k < m_configs.size ());
+  return Time::FromDouble (m_estimate[k], Time::S);
+}
+
+Time
+RttFixedShareBank::GetVariation (uint32_t k) const
+{
+  NS_ASSERT (k < m_configs.size ());
+  return Time::FromDouble (m_variation[k], Time::S);
+}
+
+double
+RttFixedShareBank::GetMeanError (uint32_t k) const
+{
+  NS_ASSERT (k < m_configs.size ());
+  if (m_nSamples == 0)
+    {
+      return 0;
+    }
+  return m_errorSum[k] / m_nSamples;
+}
+
+uint32_t
+RttFixedShareBank::GetNSamples (void) const
+{
+  return m_nSamples;
+}
+
+} // namespace ns3
@@ -0,0 +1,151 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef RTT_FIXED_SHARE_BANK_H
+#define RTT_FIXED_SHARE_BANK_H
+
+#include <vector>
+#include <stdint.h>
+
+#include "ns3/nstime.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup tcp
+ *
+ * \brief Evaluates several RttFixedShare configurations side by side
+ *
+ * The bank holds the state of K Fixed Share estimators in a
+ * structure-of-arrays layout and advances all of them with every sample,
+ * which makes offline comparisons of parameter sets much cheaper than
+ * replaying the same trace through K separate RttFixedShare objects.
+ *
+ * Configurations with the same number of experts share one expert grid,
+ * and the per-expert loss is computed once per grid and sample.  The
+ * exponential weight factors are additionally shared between the
+ * configurations of a grid that use the same learning rate.
+ *
+ * Each configuration follows RttFixedShare::Measurement exactly: the
+ * estimate reported for a sample is the prediction of the weights before
+ * that sample is learned.  The mean error is accumulated in milliseconds,
+ * as in the estimator's own diagnostics.
+ */
+class RttFixedShareBank
+{
+public:
+  /**
+   * \brief Parameters of one Fixed Share configuration
+   */
+  struct Config
+  {
+    int numExperts; //!< Number of experts
+    double alpha;   //!< Weight sharing parameter
+    double beta;    //!< Gain used in estimating the RTT variation
+    double lr;      //!< Learning rate
+  };
+
+  /**
+   * \brief Constructor
+   * \param configs the configurations to evaluate
+   * \param initialEstimate the initial RTT estimate of every configuration
+   */
+  RttFixedShareBank (const std::vector<Config> &configs, Time initialEstimate);
+
+  /**
+   * \brief Adds a new measurement to every configuration.
+   * \param measure the new RTT measure.
+   */
+  void Measurement (Time measure);
+
+  /**
+   * \brief Resets every configuration to its initial state.
+   */
+  void Reset ();
+
+  /**
+   * \return the number of configurations in the bank
+   */
+  uint32_t GetNConfigs (void) const;
+
+  /**
+   * \param k the configuration index
+   * \return the parameters of configuration k
+   */
+  const Config &GetConfig (uint32_t k) const;
+
+  /**
+   * \param k the configuration index
+   * \return the current RTT estimate of configuration k
+   */
+  Time GetEstimate (uint32_t k) const;
+
+  /**
+   * \param k the configuration index
+   * \return the current RTT variation of configuration k
+   */
+  Time GetVariation (uint32_t k) const;
+
+  /**
+   * \param k the configuration index
+   * \return the mean absolute error of configuration k, in milliseconds
+   */
+  double GetMeanError (uint32_t k) const;
+
+  /**
+   * \return the number of samples fed to the bank
+   */
+  uint32_t GetNSamples (void) const;
+
+private:
+  /**
+   * \brief State shared by the configurations with the same number of experts
+   */
+  struct Grid
+  {
+    int numExperts;                //!< Number of experts
+    std::vector<double> experts;   //!< Expert predictions, in seconds
+    std::vector<double> losses;    //!< Per-expert loss of the current sample
+    std::vector<double> lrs;       //!< Distinct learning rates of the grid
+    std::vector<double> factors;   //!< exp (-lr * loss), one row per learning rate
+    std::vector<uint32_t> configs; //!< Configurations using this grid
+  };
+
+  /**
+   * \brief Advances the configurations of one grid by one sample.
+   * \param grid the grid
+   * \param actualRtt the measured RTT, in seconds
+   */
+  void UpdateGrid (Grid &grid, double actualRtt);
+
+  std::vector<Config> m_configs; //!< Configuration parameters
+  std::vector<Grid> m_grids;     //!< Shared expert grids
+  Time m_initialEstimate;        //!< Initial RTT estimate
+  uint32_t m_nSamples;           //!< Number of samples
+
+  // Per-configuration state, indexed by configuration
+  std::vector<uint32_t> m_weightOffset; //!< Offset of the weights in m_weights
+  std::vector<uint32_t> m_factorRow;    //!< Row of the weight factors in the grid
+  std::vector<double> m_estimate;       //!< Current estimate, in seconds
+  std::vector<double> m_variation;      //!< Current variation, in seconds
+  std::vector<double> m_errorSum;       //!< Sum of absolute errors, in milliseconds
+  std::vector<double> m_weights;        //!< Weights of every configuration, contiguous
+};
+
+} // namespace ns3
+
+#endif /* RTT_FIXED_SHARE_BANK_H */
@@ -0,0 +1,157 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "rtt-fixed-share-prior.h"
+#include "ns3/log.h"
+#include "ns3/fatal-error.h"
+
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("RttFixedSharePrior");
+
+namespace {
+
+const char g_priorMagic[8] = "FSPRIOR";
+const uint32_t g_priorVersion = 1;
+
+/**
+ * \brief A prior file mapped into memory
+ */
+struct MappedPrior
+{
+  const double *weights; //!< Weights, right after the header
+  int numExperts;        //!< Number of weights
+};
+
+/**
+ * \return the priors mapped so far, by path
+ */
+std::map<std::string, MappedPrior> &
+MappedPriors (void)
+{
+  static std::map<std::string, MappedPrior> priors;
+  return priors;
+}
+
+} // anonymous namespace
+
+const double *
+RttFixedSharePrior::Get (const std::string &path, int &numExperts)
+{
+  const double *weights = GetFailSafe (path, numExperts);
+  if (weights == 0)
+    {
+      NS_FATAL_ERROR ("Cannot read prior file " << path << " (see the RttFixedSharePrior log)");
+    }
+  return weights;
+}
+
+const double *
+RttFixedSharePrior::GetFailSafe (const std::string &path, int &numExperts)
+{
+  std::map<std::string, MappedPrior>::iterator it = MappedPriors ().find (path);
+  if (it != MappedPriors ().end ())
+    {
+      numExperts = it->second.numExperts;
+      return it->second.weights;
+    }
+
+  int fd = open (path.c_str (), O_RDONLY);
+  if (fd < 0)
+    {
+      NS_LOG_WARN ("Cannot open prior file " << path);
+      return 0;
+    }
+  struct stat st;
+  if (fstat (fd, &st) < 0 || st.st_size < (off_t) sizeof (Header))
+    {
+      close (fd);
+      NS_LOG_WARN ("Prior file " << path << " is too short");
+      return 0;
+    }
+  void *base = mmap (0, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  // The mapping keeps the file referenced
+  close (fd);
+  if (base == MAP_FAILED)
+    {
+      NS_LOG_WARN ("Cannot map prior file " << path);
+      return 0;
+    }
+
+  const Header *header = static_cast<const Header *> (base);
+  if (std::memcmp (header->magic, g_priorMagic, sizeof (g_priorMagic)) != 0
+      || header->version != g_priorVersion
+      || header->numExperts == 0
+      || (uint64_t) st.st_size != sizeof (Header) + header->numExperts * sizeof (double))
+    {
+      munmap (base, st.st_size);
+      NS_LOG_WARN ("Prior file " << path << " is not a valid prior");
+      return 0;
+    }
+
+  MappedPrior prior;
+  prior.weights = reinterpret_cast<const double *> (header + 1);
+  prior.numExperts = header->numExperts;
+  MappedPriors ()[path] = prior;
+  NS_LOG_DEBUG ("Mapped prior " << path << " of " << prior.numExperts << " experts");
+
+  numExperts = prior.numExperts;
+  return prior.weights;
+}
+
+bool
+RttFixedSharePrior::Write (const std::string &path, const std::vector<double> &weights)
+{
+  if (weights.empty ())
+    {
+      return false;
+    }
+  double sum = 0;
+  for (uint32_t i = 0; i < weights.size (); i++)
+    {
+      if (!(weights[i] > 0))
+        {
+          NS_LOG_WARN ("Weight " << i << " of the prior is not positive");
+          return false;
+        }
+      sum += weights[i];
+    }
+
+  Header header;
+  std::memcpy (header.magic, g_priorMagic, sizeof (g_priorMagic));
+  header.version = g_priorVersion;
+  header.numExperts = weights.size ();
+
+  std::ofstream out (path.c_str (), std::ios::binary | std::ios::trunc);
+  out.write (reinterpret_cast<const char *> (&header), sizeof (header));
+  for (uint32_t i = 0; i < weights.size (); i++)
+    {
+      double weight = weights[i] / sum;
+      out.write (reinterpret_cast<const char *> (&weight), sizeof (weight));
+    }
+  return bool (out);
+}
+
+} // namespace ns3
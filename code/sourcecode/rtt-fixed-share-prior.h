@@ -0,0 +1,92 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef RTT_FIXED_SHARE_PRIOR_H
+#define RTT_FIXED_SHARE_PRIOR_H
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+namespace ns3 {
+
+/**
+ * \ingroup tcp
+ *
+ * \brief Prior weight distributions for RttFixedShare, trained offline
+ *
+ * A prior file holds the initial weights of every expert of the grid
+ * RttFixedShare::GetExpertGrid builds for a given number of experts,
+ * learned from recorded RTT traces of a network class (see
+ * rtt-train-prior.cc).  An estimator whose PriorFile attribute names such
+ * a file starts from these weights instead of the uniform distribution.
+ *
+ * The file is a Header followed by numExperts doubles, in the byte order
+ * of the machine that wrote it.  It is mapped read-only the first time it
+ * is asked for and stays mapped until the end of the process, so all the
+ * estimators using it, and the replications forked after it was mapped,
+ * share the same pages.
+ */
+class RttFixedSharePrior
+{
+public:
+  /**
+   * \brief Layout of the beginning of a prior file
+   */
+  struct Header
+  {
+    char magic[8];       //!< "FSPRIOR" and a null byte
+    uint32_t version;    //!< Format version, currently 1
+    uint32_t numExperts; //!< Number of weights following the header
+  };
+
+  /**
+   * \brief Maps a prior file, or finds it among the files already mapped.
+   *
+   * Aborts if the file cannot be read or is not a valid prior.
+   *
+   * \param path the prior file
+   * \param numExperts set to the number of experts the prior was trained for
+   * \return the normalized weights, valid until the end of the process
+   */
+  static const double * Get (const std::string &path, int &numExperts);
+
+  /**
+   * \brief Same as Get, but returns 0 instead of aborting.
+   *
+   * \param path the prior file
+   * \param numExperts set to the number of experts the prior was trained for
+   * \return the normalized weights, valid until the end of the process, or
+   * 0 if the file cannot be read or is not a valid prior
+   */
+  static const double * GetFailSafe (const std::string &path, int &numExperts);
+
+  /**
+   * \brief Writes a prior file.
+   *
+   * The weights are normalized before they are written.
+   *
+   * \param path the prior file
+   * \param weights one weight per expert, all positive
+   * \return true on success
+   */
+  static bool Write (const std::string &path, const std::vector<double> &weights);
+};
+
+} // namespace ns3
+
+#endif /* RTT_FIXED_SHARE_PRIOR_H */
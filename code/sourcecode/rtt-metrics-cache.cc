@@ -0,0 +1,128 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "rtt-metrics-cache.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("RttMetricsCache");
+
+NS_OBJECT_ENSURE_REGISTERED (RttMetricsCache);
+
+TypeId
+RttMetricsCache::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::RttMetricsCache")
+    .SetParent<Object> ()
+    .SetGroupName ("Internet")
+    .AddConstructor<RttMetricsCache> ()
+    .AddAttribute ("Timeout",
+                   "Age after which the RTT knowledge about a peer is discarded",
+                   TimeValue (Seconds (600)),
+                   MakeTimeAccessor (&RttMetricsCache::m_timeout),
+                   MakeTimeChecker ())
+  ;
+  return tid;
+}
+
+RttMetricsCache::RttMetricsCache ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+RttMetricsCache::~RttMetricsCache ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+RttMetricsCache::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_entries.clear ();
+  Object::DoDispose ();
+}
+
+void
+RttMetricsCache::Expire (void)
+{
+  std::map<Ipv4Address, RttFixedShare::Summary>::iterator it = m_entries.begin ();
+  while (it != m_entries.end ())
+    {
+      if (Simulator::Now () - it->second.lastMeasurement >= m_timeout)
+        {
+          NS_LOG_DEBUG ("Knowledge about " << it->first << " expired");
+          m_entries.erase (it++);
+        }
+      else
+        {
+          it++;
+        }
+    }
+}
+
+bool
+RttMetricsCache::Seed (Ipv4Address peer, Ptr<RttFixedShare> rtt)
+{
+  NS_LOG_FUNCTION (this << peer << rtt);
+  Expire ();
+
+  std::map<Ipv4Address, RttFixedShare::Summary>::const_iterator it = m_entries.find (peer);
+  if (it == m_entries.end ())
+    {
+      return false;
+    }
+  Time age = Simulator::Now () - it->second.lastMeasurement;
+  double keep = 1.0 - age.ToDouble (Time::S) / m_timeout.ToDouble (Time::S);
+  rtt->WarmStart (it->second, keep);
+  NS_LOG_DEBUG ("Seeded estimator for " << peer << " from knowledge " << age.GetSeconds () << " s old");
+  return true;
+}
+
+void
+RttMetricsCache::Update (Ipv4Address peer, Ptr<const RttFixedShare> rtt)
+{
+  NS_LOG_FUNCTION (this << peer << rtt);
+  Expire ();
+
+  RttFixedShare::Summary summary = rtt->GetSummary ();
+  if (!summary.lastMeasurement.IsStrictlyPositive ())
+    {
+      return;
+    }
+  std::map<Ipv4Address, RttFixedShare::Summary>::iterator it = m_entries.find (peer);
+  if (it != m_entries.end () && it->second.lastMeasurement >= summary.lastMeasurement)
+    {
+      // Another connection measured the peer more recently, or this one
+      // was seeded from the entry and has measured nothing since
+      return;
+    }
+  if (Simulator::Now () - summary.lastMeasurement < m_timeout)
+    {
+      m_entries[peer] = summary;
+    }
+}
+
+uint32_t
+RttMetricsCache::GetNEntries (void) const
+{
+  return m_entries.size ();
+}
+
+} // namespace ns3
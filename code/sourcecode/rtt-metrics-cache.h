@@ -0,0 +1,102 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef RTT_METRICS_CACHE_H
+#define RTT_METRICS_CACHE_H
+
+#include <map>
+
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/ipv4-address.h"
+#include "rtt-estimator.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup tcp
+ *
+ * \brief Per-node cache of the RTT knowledge learned for each peer
+ *
+ * Similar to the Linux tcp_metrics cache, this object remembers, for
+ * each peer address, a summary of what the RttFixedShare estimator of
+ * the last connection to it learned: a copy of the expert weights and
+ * the time of its last measurement.  When a new connection to the same
+ * peer is opened, its estimator is warm started from that distribution
+ * instead of the uniform prior.
+ *
+ * Knowledge ages linearly: a distribution learned dt ago is kept with a
+ * weight of 1 - dt / Timeout and blended with the uniform prior, and
+ * entries older than Timeout are erased the next time the cache is used.
+ *
+ * The cache is meant to be aggregated to a Node.  The summary is copied
+ * when a connection closes, so no work is added to the per-sample path
+ * and the estimators of closed connections are not kept alive.
+ */
+class RttMetricsCache : public Object
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  RttMetricsCache ();
+  virtual ~RttMetricsCache ();
+
+  /**
+   * \brief Seeds the estimator of a new connection to a peer.
+   * \param peer the address of the peer
+   * \param rtt the estimator of the new connection
+   * \return true if the estimator was warm started
+   */
+  bool Seed (Ipv4Address peer, Ptr<RttFixedShare> rtt);
+
+  /**
+   * \brief Remembers what the estimator of a connection to a peer learned.
+   *
+   * Meant to be called when the connection closes.  Estimators that have
+   * not measured anything, or less recently than the entry of the peer,
+   * leave the entry as it is.
+   *
+   * \param peer the address of the peer
+   * \param rtt the estimator of the connection
+   */
+  void Update (Ipv4Address peer, Ptr<const RttFixedShare> rtt);
+
+  /**
+   * \return the number of peers in the cache
+   */
+  uint32_t GetNEntries (void) const;
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  /**
+   * \brief Erases the entries older than Timeout.
+   */
+  void Expire (void);
+
+  Time m_timeout; //!< Age after which an entry is discarded
+  std::map<Ipv4Address, RttFixedShare::Summary> m_entries; //!< Last knowledge per peer
+};
+
+} // namespace ns3
+
+#endif /* RTT_METRICS_CACHE_H */
@@ -17,11 +17,26 @@
 
 #include "ns3/test.h"
 #include "ns3/rtt-estimator.h"
+#include "ns3/rtt-fixed-share-bank.h"
+#include "ns3/rtt-fixed-share-prior.h"
+#include "ns3/rtt-estimator-stats.h"
+#include "ns3/rtt-metrics-cache.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/simulator.h"
 #include "ns3/attribute.h"
 #include "ns3/nstime.h"
 #include "ns3/config.h"
 #include "ns3/log.h"
+#include "ns3/boolean.h"
 #include "ns3/double.h"
+#include "ns3/enum.h"
+#include "ns3/integer.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
+#include "ns3/object-factory.h"
+
+#include <algorithm>
+#include <sstream>
 
 using namespace ns3;
 
@@ -172,6 +187,1326 @@ RttEstimatorTestCase::DoTeardown (void)
 {
 }
 
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief RttFixedShareBank Test
+ *
+ * Checks that every configuration of the bank follows the same
+ * trajectory as an RttFixedShare fed with the same samples.
+ */
+class RttFixedShareBankTestCase : public TestCase
+{
+public:
+  RttFixedShareBankTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+RttFixedShareBankTestCase::RttFixedShareBankTestCase ()
+  : TestCase ("RttFixedShareBank Test")
+{
+}
+
+void
+RttFixedShareBankTestCase::DoRun (void)
+{
+  Config::SetDefault ("ns3::RttEstimator::InitialEstimation", TimeValue (Seconds (1)));
+  Config::SetDefault ("ns3::RttFixedShare::Alpha", DoubleValue (0.08));
+  Config::SetDefault ("ns3::RttFixedShare::Beta", DoubleValue (0.25));
+  Config::SetDefault ("ns3::RttFixedShare::LR", DoubleValue (2.0));
+
+  std::vector<RttFixedShareBank::Config> configs;
+  RttFixedShareBank::Config defaults = { 100, 0.08, 0.25, 2.0 };
+  RttFixedShareBank::Config other = { 40, 0.5, 0.125, 0.5 };
+  configs.push_back (other);
+  configs.push_back (defaults);
+  configs.push_back (defaults);
+  Ptr<RttFixedShare> rtt = CreateObject<RttFixedShare> ();
+  RttFixedShareBank bank (configs, rtt->GetEstimate ());
+
+  for (uint32_t i = 0; i < 200; i++)
+    {
+      Time m = MilliSeconds (20 + (i * 37) % 180);
+      rtt->Measurement (m);
+      bank.Measurement (m);
+      NS_TEST_EXPECT_MSG_EQ_TOL (bank.GetEstimate (1), rtt->GetEstimate (), Time (NanoSeconds (1)), "Estimate not correct");
+      NS_TEST_EXPECT_MSG_EQ_TOL (bank.GetVariation (1), rtt->GetVariation (), Time (MicroSeconds (1)), "Variation not correct");
+      NS_TEST_EXPECT_MSG_EQ (bank.GetEstimate (2), bank.GetEstimate (1), "Identical configurations diverged");
+    }
+  NS_TEST_EXPECT_MSG_EQ (bank.GetNSamples (), 200, "Incorrect number of samples");
+  NS_TEST_EXPECT_MSG_NE (bank.GetEstimate (0), bank.GetEstimate (1), "Different configurations should differ");
+
+  bank.Reset ();
+  NS_TEST_EXPECT_MSG_EQ (bank.GetEstimate (0), CreateObject<RttFixedShare> ()->GetEstimate (), "Incorrect initial estimate");
+  NS_TEST_EXPECT_MSG_EQ (bank.GetVariation (0), Time (Seconds (0)), "Incorrect initial variation");
+  NS_TEST_EXPECT_MSG_EQ (bank.GetNSamples (), 0, "Incorrect initial number of samples");
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief RttFixedShare slab pool Test
+ */
+class RttFixedSharePoolTestCase : public TestCase
+{
+public:
+  RttFixedSharePoolTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * \brief Checks that an estimator starts from the uniform prior.
+   * \param rtt the estimator
+   * \param numExperts the expected number of experts
+   */
+  void CheckUniform (Ptr<RttFixedShare> rtt, uint32_t numExperts);
+};
+
+RttFixedSharePoolTestCase::RttFixedSharePoolTestCase ()
+  : TestCase ("RttFixedShare Pool Test")
+{
+}
+
+void
+RttFixedSharePoolTestCase::CheckUniform (Ptr<RttFixedShare> rtt, uint32_t numExperts)
+{
+  std::vector<double> weights = rtt->GetWeights ();
+  NS_TEST_ASSERT_MSG_EQ (weights.size (), numExperts, "Incorrect number of weights");
+  for (uint32_t i = 0; i < weights.size (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ_TOL (weights[i], 1.0 / numExperts, 1e-12, "Weight " << i << " should be uniform");
+    }
+}
+
+void
+RttFixedSharePoolTestCase::DoRun (void)
+{
+  // More estimators than a chunk holds, trained and then destroyed, so
+  // that the next ones are handed slabs holding learned weights
+  Ptr<RttFixedShare> reference = CreateObject<RttFixedShare> ();
+  reference->Measurement (MilliSeconds (50));
+  {
+    std::vector<Ptr<RttFixedShare> > trained;
+    for (uint32_t i = 0; i < 40; i++)
+      {
+        trained.push_back (CreateObject<RttFixedShare> ());
+        for (uint32_t j = 0; j < 20; j++)
+          {
+            trained.back ()->Measurement (MilliSeconds (300));
+          }
+      }
+  }
+  for (uint32_t i = 0; i < 40; i++)
+    {
+      Ptr<RttFixedShare> rtt = CreateObject<RttFixedShare> ();
+      CheckUniform (rtt, 100);
+      rtt->Measurement (MilliSeconds (50));
+      NS_TEST_EXPECT_MSG_EQ (rtt->GetEstimate (), reference->GetEstimate (), "A reused slab should behave as a new one");
+    }
+
+  // Estimators of different sizes draw from different slabs and grids,
+  // the smaller grids only reaching down to larger RTTs
+  uint32_t sizes[] = { 8, 24, 100, 150 };
+  double rtts[] = { 0.3, 0.2, 0.1, 0.05 };
+  std::vector<Ptr<RttFixedShare> > sized;
+  for (uint32_t s = 0; s < 4; s++)
+    {
+      sized.push_back (CreateObject<RttFixedShare> ());
+      sized.back ()->SetAttribute ("NumExperts", IntegerValue (sizes[s]));
+      sized.back ()->Measurement (MilliSeconds (100));
+    }
+  for (uint32_t i = 0; i < 100; i++)
+    {
+      for (uint32_t s = 0; s < 4; s++)
+        {
+          sized[s]->Measurement (Seconds (rtts[s]));
+        }
+    }
+  for (uint32_t s = 0; s < 4; s++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (sized[s]->GetWeights ().size (), sizes[s], "Incorrect number of experts");
+      NS_TEST_EXPECT_MSG_EQ_TOL (sized[s]->GetEstimate ().GetSeconds (), rtts[s], 0.2 * rtts[s],
+                                 "Estimator with " << sizes[s] << " experts should follow its own RTT");
+    }
+  // Changing the size takes a new slab, starting over from the prior
+  sized[0]->SetAttribute ("NumExperts", IntegerValue (24));
+  sized[0]->Measurement (MilliSeconds (100));
+  NS_TEST_EXPECT_MSG_EQ (sized[0]->GetWeights ().size (), 24, "The estimator should have been resized");
+  NS_TEST_EXPECT_MSG_EQ_TOL (sized[1]->GetEstimate ().GetSeconds (), rtts[1], 0.2 * rtts[1], "Resizing should not affect the others");
+
+  // A copy takes its own slab with the learned weights
+  Ptr<RttFixedShare> original = sized[2];
+  Ptr<RttFixedShare> copy = DynamicCast<RttFixedShare> (original->Copy ());
+  std::vector<double> originalWeights = original->GetWeights ();
+  std::vector<double> copyWeights = copy->GetWeights ();
+  NS_TEST_ASSERT_MSG_EQ (copyWeights.size (), originalWeights.size (), "The copy should have as many experts");
+  for (uint32_t i = 0; i < copyWeights.size (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (copyWeights[i], originalWeights[i], "Copy should carry weight " << i);
+    }
+  NS_TEST_EXPECT_MSG_EQ (copy->GetEstimate (), original->GetEstimate (), "Copy should carry the estimate");
+  for (uint32_t i = 0; i < 10; i++)
+    {
+      original->Measurement (MilliSeconds (400));
+    }
+  copyWeights = copy->GetWeights ();
+  for (uint32_t i = 0; i < copyWeights.size (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (copyWeights[i], originalWeights[i], "The copy should not share the slab, weight " << i);
+    }
+  copy->Measurement (Seconds (rtts[2]));
+  NS_TEST_EXPECT_MSG_EQ_TOL (copy->GetEstimate ().GetSeconds (), rtts[2], 0.2 * rtts[2], "The copy should go on from the learned weights");
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief RttShadowEstimator Test
+ *
+ * Checks that the shadow estimator exposes the state of its primary
+ * estimator and feeds the same samples to the shadows.
+ */
+class RttShadowEstimatorTestCase : public TestCase
+{
+public:
+  RttShadowEstimatorTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+RttShadowEstimatorTestCase::RttShadowEstimatorTestCase ()
+  : TestCase ("RttShadowEstimator Test")
+{
+}
+
+void
+RttShadowEstimatorTestCase::DoRun (void)
+{
+  Ptr<RttShadowEstimator> shadow = CreateObject<RttShadowEstimator> ();
+  bool ok = shadow->SetAttributeFailSafe ("Primary", TypeIdValue (RttFixedShare::GetTypeId ()));
+  NS_TEST_EXPECT_MSG_EQ (ok, true, "Attribute should be settable");
+  ok = shadow->SetAttributeFailSafe ("Shadows", StringValue ("ns3::RttMeanDeviation"));
+  NS_TEST_EXPECT_MSG_EQ (ok, true, "Attribute should be settable");
+
+  Ptr<RttFixedShare> primary = CreateObject<RttFixedShare> ();
+  Ptr<RttMeanDeviation> meanDev = CreateObject<RttMeanDeviation> ();
+  NS_TEST_EXPECT_MSG_EQ (shadow->GetNEstimators (), 2, "Incorrect number of estimators");
+
+  for (uint32_t i = 0; i < 50; i++)
+    {
+      Time m = MilliSeconds (50 + (i * 13) % 70);
+      shadow->Measurement (m);
+      primary->Measurement (m);
+      meanDev->Measurement (m);
+      NS_TEST_EXPECT_MSG_EQ (shadow->GetEstimate (), primary->GetEstimate (), "Estimate should be the primary's");
+      NS_TEST_EXPECT_MSG_EQ (shadow->GetVariation (), primary->GetVariation (), "Variation should be the primary's");
+      NS_TEST_EXPECT_MSG_EQ (shadow->GetEstimator (1)->GetEstimate (), meanDev->GetEstimate (), "Shadow should see the same samples");
+    }
+  NS_TEST_EXPECT_MSG_EQ (shadow->GetNSamples (), primary->GetNSamples (), "Incorrect number of samples");
+  NS_TEST_EXPECT_MSG_GT (shadow->GetMeanError (1), 0.0, "Shadow error should be accumulated");
+
+  Ptr<RttEstimator> copy = shadow->Copy ();
+  copy->Measurement (MilliSeconds (60));
+  shadow->Measurement (MilliSeconds (60));
+  NS_TEST_EXPECT_MSG_EQ (copy->GetEstimate (), shadow->GetEstimate (), "Copy should have inherited state");
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief RttFixedShare adaptive learning rate Test
+ */
+class RttFixedShareAdaptiveLrTestCase : public TestCase
+{
+public:
+  RttFixedShareAdaptiveLrTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \brief Feeds samples jittered around an RTT
+   * \param rtt the estimator
+   * \param mean the mean RTT, in seconds
+   */
+  void Feed (Ptr<RttFixedShare> rtt, double mean);
+};
+
+RttFixedShareAdaptiveLrTestCase::RttFixedShareAdaptiveLrTestCase ()
+  : TestCase ("RttFixedShare AdaptiveLR Test")
+{
+}
+
+void
+RttFixedShareAdaptiveLrTestCase::Feed (Ptr<RttFixedShare> rtt, double mean)
+{
+  for (uint32_t i = 0; i < 300; i++)
+    {
+      rtt->Measurement (Seconds (mean * (1 + 0.05 * ((i * 7) % 5 - 2.0))));
+    }
+}
+
+void
+RttFixedShareAdaptiveLrTestCase::DoRun (void)
+{
+  Ptr<RttFixedShare> fixedSmall = CreateObject<RttFixedShare> ();
+  Ptr<RttFixedShare> adaptiveSmall = CreateObject<RttFixedShare> ();
+  Ptr<RttFixedShare> adaptiveLarge = CreateObject<RttFixedShare> ();
+  bool ok = adaptiveSmall->SetAttributeFailSafe ("AdaptiveLR", BooleanValue (true));
+  NS_TEST_EXPECT_MSG_EQ (ok, true, "Attribute should be settable");
+  adaptiveLarge->SetAttribute ("AdaptiveLR", BooleanValue (true));
+
+  NS_TEST_EXPECT_MSG_EQ (adaptiveSmall->GetLearningRate (), 2.0, "LR should be used before any sample");
+
+  Feed (fixedSmall, 0.005);
+  Feed (adaptiveSmall, 0.005);
+  Feed (adaptiveLarge, 0.3);
+
+  // At small RTTs the losses are tiny and LR = 2 barely learns
+  double fixedError = std::abs (fixedSmall->GetEstimate ().GetSeconds () - 0.005);
+  double adaptiveError = std::abs (adaptiveSmall->GetEstimate ().GetSeconds () - 0.005);
+  NS_TEST_EXPECT_MSG_LT (adaptiveError, fixedError, "Adaptive rate should track small RTTs better");
+  NS_TEST_EXPECT_MSG_LT (std::abs (adaptiveLarge->GetEstimate ().GetSeconds () - 0.3), 0.03, "Adaptive rate should track large RTTs");
+
+  // The rate scales with the losses, and does not decay to zero
+  NS_TEST_EXPECT_MSG_GT (adaptiveSmall->GetLearningRate (), 10 * adaptiveLarge->GetLearningRate (), "Rate should grow as losses shrink");
+  NS_TEST_EXPECT_MSG_GT (adaptiveLarge->GetLearningRate (), 1.0, "Rate should not vanish");
+
+  Ptr<RttFixedShare> copy = DynamicCast<RttFixedShare> (adaptiveSmall->Copy ());
+  NS_TEST_EXPECT_MSG_EQ (copy->GetLearningRate (), adaptiveSmall->GetLearningRate (), "Copy should inherit the rate");
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief RttFixedShare expert variation Test
+ */
+class RttFixedShareExpertVariationTestCase : public TestCase
+{
+public:
+  RttFixedShareExpertVariationTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+RttFixedShareExpertVariationTestCase::RttFixedShareExpertVariationTestCase ()
+  : TestCase ("RttFixedShare Experts VariationMode Test")
+{
+}
+
+void
+RttFixedShareExpertVariationTestCase::DoRun (void)
+{
+  Ptr<RttFixedShare> low = CreateObject<RttFixedShare> ();
+  Ptr<RttFixedShare> high = CreateObject<RttFixedShare> ();
+  bool ok = low->SetAttributeFailSafe ("VariationMode", EnumValue (RttFixedShare::EXPERT_VARIATION));
+  NS_TEST_EXPECT_MSG_EQ (ok, true, "Attribute should be settable");
+  ok = low->SetAttributeFailSafe ("NumVariationExperts", IntegerValue (24));
+  NS_TEST_EXPECT_MSG_EQ (ok, true, "Attribute should be settable");
+  high->SetAttribute ("VariationMode", EnumValue (RttFixedShare::EXPERT_VARIATION));
+  high->SetAttribute ("NumVariationExperts", IntegerValue (24));
+
+  // The same base RTT with 1 ms and 50 ms of jitter, the variation being
+  // averaged once the grids have settled
+  double lowSum = 0;
+  double highSum = 0;
+  for (uint32_t i = 0; i < 600; i++)
+    {
+      low->Measurement (MilliSeconds (100 + (i * 37) % 2));
+      high->Measurement (MilliSeconds (100 + (i * 37) % 50));
+      if (i >= 200)
+        {
+          lowSum += low->GetVariation ().GetSeconds ();
+          highSum += high->GetVariation ().GetSeconds ();
+        }
+    }
+  NS_TEST_EXPECT_MSG_LT (lowSum, 0.6 * highSum, "Variation should follow the jitter");
+  NS_TEST_EXPECT_MSG_LT (low->GetVariation (), MilliSeconds (40), "Variation should be small without jitter");
+  NS_TEST_EXPECT_MSG_GT (high->GetVariation (), MilliSeconds (10), "Variation should grow with the jitter");
+
+  Ptr<RttFixedShare> rtt = high;
+  // The variation grid is copied along with the RTT grid
+  Ptr<RttEstimator> copy = rtt->Copy ();
+  copy->Measurement (MilliSeconds (180));
+  rtt->Measurement (MilliSeconds (180));
+  NS_TEST_EXPECT_MSG_EQ (copy->GetVariation (), rtt->GetVariation (), "Copy should have inherited the variation grid");
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief RttFixedShare Quantile VariationMode Test
+ */
+class RttFixedShareQuantileTestCase : public TestCase
+{
+public:
+  RttFixedShareQuantileTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * \brief Locates a quantile of the weights of an estimator.
+   * \param rtt the estimator
+   * \param quantile the quantile
+   * \return the quantile, interpolated between experts
+   */
+  double GetQuantile (Ptr<RttFixedShare> rtt, double quantile);
+};
+
+RttFixedShareQuantileTestCase::RttFixedShareQuantileTestCase ()
+  : TestCase ("RttFixedShare Quantile VariationMode Test")
+{
+}
+
+double
+RttFixedShareQuantileTestCase::GetQuantile (Ptr<RttFixedShare> rtt, double quantile)
+{
+  std::vector<double> weights = rtt->GetWeights ();
+  std::vector<double> experts = RttFixedShare::GetExpertGrid (weights.size ());
+  double cumulative = 0;
+  for (uint32_t i = 0; i < weights.size (); i++)
+    {
+      if (weights[i] > 0 && cumulative + weights[i] >= quantile)
+        {
+          double lower = (i > 0) ? experts[i - 1] : 0.0;
+          return lower + (quantile - cumulative) / weights[i] * (experts[i] - lower);
+        }
+      cumulative += weights[i];
+    }
+  return experts.back ();
+}
+
+void
+RttFixedShareQuantileTestCase::DoRun (void)
+{
+  Ptr<RttFixedShare> rtt = CreateObject<RttFixedShare> ();
+  NS_TEST_EXPECT_MSG_EQ (rtt->SetAttributeFailSafe ("Quantile", DoubleValue (0.0)), false, "Quantile 0 should be rejected");
+  NS_TEST_EXPECT_MSG_EQ (rtt->SetAttributeFailSafe ("Quantile", DoubleValue (1.0)), false, "Quantile 1 should be rejected");
+
+  double quantiles[] = { 0.75, 0.9, 0.99 };
+  Time lastRto;
+  for (uint32_t q = 0; q < 3; q++)
+    {
+      rtt = CreateObject<RttFixedShare> ();
+      rtt->SetAttribute ("VariationMode", EnumValue (RttFixedShare::QUANTILE_VARIATION));
+      rtt->SetAttribute ("Quantile", DoubleValue (quantiles[q]));
+      for (uint32_t i = 0; i < 200; i++)
+        {
+          // SRTT and RTO must both come from the weights the sample is
+          // predicted with
+          std::vector<double> weights = rtt->GetWeights ();
+          double mean = 0;
+          std::vector<double> experts = RttFixedShare::GetExpertGrid (weights.size ());
+          for (uint32_t j = 0; j < weights.size (); j++)
+            {
+              mean += weights[j] * experts[j];
+            }
+          double expected = std::max (mean, GetQuantile (rtt, quantiles[q]));
+          rtt->Measurement (MilliSeconds (100 + (i * 37) % 50));
+          Time rto = rtt->GetEstimate () + rtt->GetVariation () * 4;
+          NS_TEST_EXPECT_MSG_EQ_TOL (rtt->GetEstimate ().GetSeconds (), mean, 1e-6, "SRTT should be the weighted mean");
+          NS_TEST_EXPECT_MSG_EQ_TOL (rto.GetSeconds (), expected, 1e-6,
+                                     "RTO should be quantile " << quantiles[q] << " at sample " << i);
+        }
+      Time rto = rtt->GetEstimate () + rtt->GetVariation () * 4;
+      NS_TEST_EXPECT_MSG_GT (rto, lastRto, "A higher quantile should give a higher RTO");
+      NS_TEST_EXPECT_MSG_GT (rto, MilliSeconds (100), "RTO should be above the smallest RTT");
+      lastRto = rto;
+    }
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief RttFixedShare route change Test
+ */
+class RttFixedShareRouteChangeTestCase : public TestCase
+{
+public:
+  RttFixedShareRouteChangeTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * \brief Counts the samples an estimator takes to follow a step of the RTT.
+   * \param rtt the estimator, converged on the RTT before the step
+   * \param target the RTT after the step
+   * \return the number of samples until the estimate is within 10% of target
+   */
+  uint32_t SamplesToConverge (Ptr<RttEstimator> rtt, Time target);
+};
+
+RttFixedShareRouteChangeTestCase::RttFixedShareRouteChangeTestCase ()
+  : TestCase ("RttFixedShare RouteChanged Test")
+{
+}
+
+uint32_t
+RttFixedShareRouteChangeTestCase::SamplesToConverge (Ptr<RttEstimator> rtt, Time target)
+{
+  uint32_t samples = 0;
+  while (samples < 200 && std::abs ((rtt->GetEstimate () - target).GetSeconds ()) > 0.1 * target.GetSeconds ())
+    {
+      rtt->Measurement (target);
+      samples++;
+    }
+  return samples;
+}
+
+void
+RttFixedShareRouteChangeTestCase::DoRun (void)
+{
+  Ptr<RttFixedShare> plain = CreateObject<RttFixedShare> ();
+  for (uint32_t i = 0; i < 100; i++)
+    {
+      plain->Measurement (MilliSeconds (300));
+    }
+  Ptr<RttFixedShare> hinted = DynamicCast<RttFixedShare> (plain->Copy ());
+  NS_TEST_EXPECT_MSG_EQ_TOL (hinted->GetShareRate (), 0.08, 1e-12, "No boost before a route change");
+
+  // The route gets shorter. Overestimating experts lose little, so with a
+  // constant share rate the weight mass takes dozens of samples to move.
+  hinted->RouteChanged ();
+  NS_TEST_EXPECT_MSG_EQ_TOL (hinted->GetShareRate (), 0.7, 1e-12, "Share rate should be boosted to BoostAlpha");
+  uint32_t hintedSamples = SamplesToConverge (hinted, MilliSeconds (100));
+  uint32_t plainSamples = SamplesToConverge (plain, MilliSeconds (100));
+  NS_TEST_EXPECT_MSG_LT (hintedSamples, 10u, "RouteChanged should reconverge within a few samples");
+  NS_TEST_EXPECT_MSG_GT (plainSamples, 50u, "Without the hint the reconvergence should be slow");
+  for (uint32_t i = 0; i < 20; i++)
+    {
+      hinted->Measurement (MilliSeconds (100));
+    }
+  NS_TEST_EXPECT_MSG_LT (hinted->GetShareRate (), 0.081, "Boost should have decayed back to Alpha");
+
+  // A boost that never decays is refused
+  NS_TEST_EXPECT_MSG_EQ (hinted->SetAttributeFailSafe ("BoostDecay", DoubleValue (1.0)), false, "BoostDecay 1 should be refused");
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief RttFixedShare WarmStart Test
+ */
+class RttFixedShareWarmStartTestCase : public TestCase
+{
+public:
+  RttFixedShareWarmStartTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * \brief Checks the weights seeded with a given keep fraction.
+   * \param learned the estimator to seed from
+   * \param keep the fraction of the learned distribution to keep
+   */
+  void CheckWarmStart (Ptr<RttFixedShare> learned, double keep);
+  /**
+   * \brief Feeds an estimator with a constant RTT.
+   * \param rtt the estimator
+   * \param sample the RTT
+   */
+  void Learn (Ptr<RttFixedShare> rtt, Time sample);
+  /**
+   * \brief Seeds the estimator of a new connection from the cache.
+   * \param cache the cache
+   * \param rtt the new estimator
+   * \param learned the estimator the knowledge comes from
+   * \param expected whether the knowledge should still be valid
+   */
+  void Seed (Ptr<RttMetricsCache> cache, Ptr<RttFixedShare> rtt, Ptr<RttFixedShare> learned, bool expected);
+  /**
+   * \brief Remembers the estimator of a closing connection in the cache.
+   * \param cache the cache
+   * \param rtt the estimator of the connection
+   * \param entries the number of entries expected afterwards
+   */
+  void Remember (Ptr<RttMetricsCache> cache, Ptr<RttFixedShare> rtt, uint32_t entries);
+};
+
+RttFixedShareWarmStartTestCase::RttFixedShareWarmStartTestCase ()
+  : TestCase ("RttFixedShare WarmStart Test")
+{
+}
+
+void
+RttFixedShareWarmStartTestCase::CheckWarmStart (Ptr<RttFixedShare> learned, double keep)
+{
+  Ptr<RttFixedShare> rtt = CreateObject<RttFixedShare> ();
+  rtt->WarmStart (learned, keep);
+  std::vector<double> weights = rtt->GetWeights ();
+  std::vector<double> learnedWeights = learned->GetWeights ();
+  NS_TEST_ASSERT_MSG_EQ (weights.size (), learnedWeights.size (), "The expert grids should match");
+  double estimate = 0;
+  std::vector<double> experts = RttFixedShare::GetExpertGrid (weights.size ());
+  for (uint32_t i = 0; i < weights.size (); i++)
+    {
+      double expected = keep * learnedWeights[i] + (1 - keep) / weights.size ();
+      NS_TEST_EXPECT_MSG_EQ_TOL (weights[i], expected, 1e-9, "Weight " << i << " with keep " << keep);
+      estimate += expected * experts[i];
+    }
+  NS_TEST_EXPECT_MSG_EQ_TOL (rtt->GetEstimate ().GetSeconds (), estimate, 1e-6, "The estimate should follow the seeded weights");
+}
+
+void
+RttFixedShareWarmStartTestCase::Learn (Ptr<RttFixedShare> rtt, Time sample)
+{
+  for (uint32_t i = 0; i < 100; i++)
+    {
+      rtt->Measurement (sample);
+    }
+}
+
+void
+RttFixedShareWarmStartTestCase::Seed (Ptr<RttMetricsCache> cache, Ptr<RttFixedShare> rtt, Ptr<RttFixedShare> learned,
+                                      bool expected)
+{
+  std::vector<double> uniform = rtt->GetWeights ();
+  NS_TEST_EXPECT_MSG_EQ (cache->Seed (Ipv4Address ("10.1.1.2"), rtt), expected,
+                         "Unexpected warm start at " << Simulator::Now ().GetSeconds () << " s");
+  std::vector<double> weights = rtt->GetWeights ();
+  std::vector<double> learnedWeights = learned->GetWeights ();
+  double age = (Simulator::Now () - learned->GetLastMeasurementTime ()).GetSeconds ();
+  for (uint32_t i = 0; i < weights.size (); i++)
+    {
+      double seeded = expected ? (1 - age / 10.0) * learnedWeights[i] + age / 10.0 / weights.size () : uniform[i];
+      NS_TEST_EXPECT_MSG_EQ_TOL (weights[i], seeded, 1e-9, "Weight " << i << " at " << Simulator::Now ().GetSeconds () << " s");
+    }
+}
+
+void
+RttFixedShareWarmStartTestCase::Remember (Ptr<RttMetricsCache> cache, Ptr<RttFixedShare> rtt, uint32_t entries)
+{
+  cache->Update (Ipv4Address ("10.1.1.2"), rtt);
+  NS_TEST_EXPECT_MSG_EQ (cache->GetNEntries (), entries, "Unexpected entries at " << Simulator::Now ().GetSeconds () << " s");
+}
+
+void
+RttFixedShareWarmStartTestCase::DoRun (void)
+{
+  Ptr<RttFixedShare> learned = CreateObject<RttFixedShare> ();
+  Learn (learned, MilliSeconds (300));
+
+  CheckWarmStart (learned, 0.0);
+  CheckWarmStart (learned, 0.25);
+  CheckWarmStart (learned, 1.0);
+
+  // Reset restarts the sample count but keeps what was learned
+  std::vector<double> before = learned->GetWeights ();
+  Time estimate = learned->GetEstimate ();
+  learned->Reset ();
+  std::vector<double> after = learned->GetWeights ();
+  for (uint32_t i = 0; i < before.size (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ_TOL (after[i], before[i], 1e-12, "Reset should keep weight " << i);
+    }
+  NS_TEST_EXPECT_MSG_EQ (learned->GetEstimate (), estimate, "Reset should keep the estimate");
+  NS_TEST_EXPECT_MSG_EQ (learned->GetNSamples (), 0, "Reset should restart the sample count");
+
+  // The first connection learns at 2 s and closes at 4 s; reference
+  // learns the same.  The cache keeps a copy of the weights, so what the
+  // first estimator does afterwards is not passed on.  The second
+  // connection, seeded at 6 s, closes without measuring anything and
+  // leaves the entry as it was for the third one.  By 12.5 s the
+  // knowledge is past the 10 s timeout, erased, and the fourth connection
+  // starts from the uniform prior.
+  Ptr<RttMetricsCache> cache = CreateObject<RttMetricsCache> ();
+  cache->SetAttribute ("Timeout", TimeValue (Seconds (10)));
+  Ptr<RttFixedShare> first = CreateObject<RttFixedShare> ();
+  Ptr<RttFixedShare> second = CreateObject<RttFixedShare> ();
+  Ptr<RttFixedShare> reference = CreateObject<RttFixedShare> ();
+  Simulator::Schedule (Seconds (1), &RttFixedShareWarmStartTestCase::Seed, this, cache, first, reference, false);
+  Simulator::Schedule (Seconds (1.5), &RttFixedShareWarmStartTestCase::Remember, this, cache, first, 0);
+  Simulator::Schedule (Seconds (2), &RttFixedShareWarmStartTestCase::Learn, this, first, MilliSeconds (300));
+  Simulator::Schedule (Seconds (2), &RttFixedShareWarmStartTestCase::Learn, this, reference, MilliSeconds (300));
+  Simulator::Schedule (Seconds (4), &RttFixedShareWarmStartTestCase::Remember, this, cache, first, 1);
+  Simulator::Schedule (Seconds (5), &RttFixedShareWarmStartTestCase::Learn, this, first, MilliSeconds (100));
+  Simulator::Schedule (Seconds (6), &RttFixedShareWarmStartTestCase::Seed, this, cache, second, reference, true);
+  Simulator::Schedule (Seconds (6.5), &RttFixedShareWarmStartTestCase::Remember, this, cache, second, 1);
+  Simulator::Schedule (Seconds (7), &RttFixedShareWarmStartTestCase::Seed, this, cache,
+                       CreateObject<RttFixedShare> (), reference, true);
+  Simulator::Schedule (Seconds (12.5), &RttFixedShareWarmStartTestCase::Seed, this, cache,
+                       CreateObject<RttFixedShare> (), reference, false);
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (cache->GetNEntries (), 0, "Expired knowledge should be erased");
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief RttFixedShare AsyncUpdates Test
+ */
+class RttFixedShareAsyncTestCase : public TestCase
+{
+public:
+  RttFixedShareAsyncTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+RttFixedShareAsyncTestCase::RttFixedShareAsyncTestCase ()
+  : TestCase ("RttFixedShare AsyncUpdates Test")
+{
+}
+
+void
+RttFixedShareAsyncTestCase::DoRun (void)
+{
+  Ptr<RttFixedShare> sync = CreateObject<RttFixedShare> ();
+  Ptr<RttFixedShare> async = CreateObject<RttFixedShare> ();
+  bool ok = async->SetAttributeFailSafe ("AsyncUpdates", BooleanValue (true));
+  NS_TEST_EXPECT_MSG_EQ (ok, true, "Attribute should be settable");
+  ok = async->SetAttributeFailSafe ("MaxPendingSamples", UintegerValue (4));
+  NS_TEST_EXPECT_MSG_EQ (ok, true, "Attribute should be settable");
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      Ptr<RttFixedShare> rtt = (i == 0) ? sync : async;
+      rtt->SetAttribute ("VariationMode", EnumValue (RttFixedShare::EXPERT_VARIATION));
+      rtt->SetAttribute ("ShiftDetection", BooleanValue (true));
+    }
+
+  // The worker applies the samples in order, so the state ends up the same
+  for (uint32_t i = 0; i < 500; i++)
+    {
+      Time sample = MilliSeconds (100 + (i * 37) % 20 + (i >= 250 ? 200 : 0));
+      sync->Measurement (sample);
+      async->Measurement (sample);
+    }
+  NS_TEST_EXPECT_MSG_EQ (async->GetNSamples (), 500u, "Every sample should have been applied");
+  NS_TEST_EXPECT_MSG_EQ (async->GetEstimate (), sync->GetEstimate (), "Estimates should match");
+  NS_TEST_EXPECT_MSG_EQ (async->GetVariation (), sync->GetVariation (), "Variations should match");
+  NS_TEST_EXPECT_MSG_EQ ((async->GetWeights () == sync->GetWeights ()), true, "Weights should match");
+
+  // A copy waits for the pending samples of the original
+  async->Measurement (MilliSeconds (250));
+  sync->Measurement (MilliSeconds (250));
+  Ptr<RttEstimator> copy = async->Copy ();
+  NS_TEST_EXPECT_MSG_EQ (copy->GetEstimate (), sync->GetEstimate (), "Copy should have the latest estimate");
+  copy->Measurement (MilliSeconds (260));
+  sync->Measurement (MilliSeconds (260));
+  NS_TEST_EXPECT_MSG_EQ (copy->GetNSamples (), sync->GetNSamples (), "Copy should stay asynchronous and in step");
+  NS_TEST_EXPECT_MSG_EQ (copy->GetEstimate (), sync->GetEstimate (), "Copy should stay asynchronous and in step");
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief RttFixedShare PriorFile Test
+ */
+class RttFixedSharePriorTestCase : public TestCase
+{
+public:
+  RttFixedSharePriorTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+RttFixedSharePriorTestCase::RttFixedSharePriorTestCase ()
+  : TestCase ("RttFixedShare PriorFile Test")
+{
+}
+
+void
+RttFixedSharePriorTestCase::DoRun (void)
+{
+  // A prior trained on a network where the RTT is around 200 ms
+  std::vector<double> grid = RttFixedShare::GetExpertGrid (100);
+  std::vector<double> weights (grid.size ());
+  double sum = 0;
+  for (uint32_t i = 0; i < grid.size (); i++)
+    {
+      weights[i] = (std::abs (grid[i] - 0.2) < 0.03) ? 1.0 : 1e-3;
+      sum += weights[i];
+    }
+  std::string path = CreateTempDirFilename ("rtt-prior.bin");
+  NS_TEST_ASSERT_MSG_EQ (RttFixedSharePrior::Write (path, weights), true, "Prior should be written");
+
+  Ptr<RttFixedShare> rtt = CreateObject<RttFixedShare> ();
+  rtt->SetAttribute ("PriorFile", StringValue (path));
+  NS_TEST_EXPECT_MSG_EQ_TOL (rtt->GetEstimate ().GetSeconds (), 0.2, 0.03, "Estimate should start from the prior");
+  std::vector<double> loaded = rtt->GetWeights ();
+  NS_TEST_ASSERT_MSG_EQ (loaded.size (), weights.size (), "Prior should match the grid");
+  for (uint32_t i = 0; i < loaded.size (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ_TOL (loaded[i], weights[i] / sum, 1e-12, "Weights should start from the prior");
+    }
+
+  // Short flows on that network converge faster than from uniform weights
+  Ptr<RttFixedShare> uniform = CreateObject<RttFixedShare> ();
+  double priorError = 0;
+  double uniformError = 0;
+  for (uint32_t i = 0; i < 10; i++)
+    {
+      Time sample = MilliSeconds (190 + (i * 7) % 20);
+      priorError += std::abs ((rtt->GetEstimate () - sample).GetSeconds ());
+      uniformError += std::abs ((uniform->GetEstimate () - sample).GetSeconds ());
+      rtt->Measurement (sample);
+      uniform->Measurement (sample);
+    }
+  NS_TEST_EXPECT_MSG_LT (priorError, uniformError / 2, "Prior should lower the error of short flows");
+
+  // Copies keep the prior for their own restarts
+  Ptr<RttFixedShare> copy = DynamicCast<RttFixedShare> (rtt->Copy ());
+  StringValue copyPath;
+  copy->GetAttribute ("PriorFile", copyPath);
+  NS_TEST_EXPECT_MSG_EQ (copyPath.Get (), path, "Copy should keep the prior file");
+
+  // A saved state is only restored if its prior can still be read
+  std::stringstream blob;
+  rtt->Serialize (blob);
+  std::string record = blob.str ();
+  Ptr<RttFixedShare> restored = CreateObject<RttFixedShare> ();
+  restored->Measurement (MilliSeconds (80));
+  std::stringstream valid (record);
+  NS_TEST_EXPECT_MSG_EQ (restored->Deserialize (valid), true, "State with its prior should be restored");
+  NS_TEST_EXPECT_MSG_EQ (restored->GetEstimate (), rtt->GetEstimate (), "Estimate not restored");
+
+  std::string missing = path;
+  missing[missing.size () - 1] = 'x';
+  record.replace (record.find (path), path.size (), missing);
+  Ptr<RttFixedShare> kept = CreateObject<RttFixedShare> ();
+  kept->Measurement (MilliSeconds (80));
+  std::vector<double> keptWeights = kept->GetWeights ();
+  Time keptEstimate = kept->GetEstimate ();
+  std::stringstream invalid (record);
+  NS_TEST_EXPECT_MSG_EQ (kept->Deserialize (invalid), false, "State with a missing prior should be rejected");
+  NS_TEST_EXPECT_MSG_EQ (kept->GetEstimate (), keptEstimate, "A rejected state should not change the estimate");
+  NS_TEST_EXPECT_MSG_EQ (kept->GetNSamples (), 1, "A rejected state should not change the samples");
+  kept->GetAttribute ("PriorFile", copyPath);
+  NS_TEST_EXPECT_MSG_EQ (copyPath.Get (), "", "A rejected state should not change the prior");
+  NS_TEST_EXPECT_MSG_EQ (kept->GetWeights () == keptWeights, true, "A rejected state should not change the weights");
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief RttEstimator Serialize Test
+ */
+class RttEstimatorSerializeTestCase : public TestCase
+{
+public:
+  RttEstimatorSerializeTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * \brief Checks that a restored estimator goes on like the original.
+   * \param tid the type of estimator to check
+   */
+  void CheckRoundTrip (TypeId tid);
+  /**
+   * \brief Checks that truncated and corrupted states are rejected
+   * without changing the estimator.
+   * \param tid the type of estimator to check
+   */
+  void CheckRejected (TypeId tid);
+};
+
+RttEstimatorSerializeTestCase::RttEstimatorSerializeTestCase ()
+  : TestCase ("RttEstimator Serialize Test")
+{
+}
+
+void
+RttEstimatorSerializeTestCase::CheckRoundTrip (TypeId tid)
+{
+  ObjectFactory factory;
+  factory.SetTypeId (tid);
+  Ptr<RttEstimator> rtt = factory.Create<RttEstimator> ();
+  for (uint32_t i = 0; i < 50; i++)
+    {
+      rtt->Measurement (MilliSeconds (100 + (i * 37) % 60 + (i > 30 ? 100 : 0)));
+    }
+
+  std::stringstream blob;
+  rtt->Serialize (blob);
+  Ptr<RttEstimator> restored = RttEstimator::CreateFromSerialized (blob);
+  NS_TEST_ASSERT_MSG_NE (restored, 0, tid.GetName () << " should be restored");
+  NS_TEST_EXPECT_MSG_EQ (restored->GetInstanceTypeId (), tid, "Restored estimator should have the same type");
+  NS_TEST_EXPECT_MSG_EQ (restored->GetEstimate (), rtt->GetEstimate (), tid.GetName () << " estimate not restored");
+  NS_TEST_EXPECT_MSG_EQ (restored->GetVariation (), rtt->GetVariation (), tid.GetName () << " variation not restored");
+  NS_TEST_EXPECT_MSG_EQ (restored->GetNSamples (), rtt->GetNSamples (), tid.GetName () << " samples not restored");
+
+  // The learned state is restored too, not only the outputs
+  for (uint32_t i = 0; i < 20; i++)
+    {
+      Time sample = MilliSeconds (150 + (i * 53) % 90);
+      rtt->Measurement (sample);
+      restored->Measurement (sample);
+    }
+  NS_TEST_EXPECT_MSG_EQ (restored->GetEstimate (), rtt->GetEstimate (), tid.GetName () << " should resume identically");
+  NS_TEST_EXPECT_MSG_EQ (restored->GetVariation (), rtt->GetVariation (), tid.GetName () << " should resume identically");
+}
+
+void
+RttEstimatorSerializeTestCase::CheckRejected (TypeId tid)
+{
+  ObjectFactory factory;
+  factory.SetTypeId (tid);
+  Ptr<RttEstimator> saved = factory.Create<RttEstimator> ();
+  Ptr<RttEstimator> rtt = factory.Create<RttEstimator> ();
+  Ptr<RttEstimator> twin = factory.Create<RttEstimator> ();
+  for (uint32_t i = 0; i < 50; i++)
+    {
+      saved->Measurement (MilliSeconds (200 + (i * 37) % 60));
+    }
+  for (uint32_t i = 0; i < 10; i++)
+    {
+      rtt->Measurement (MilliSeconds (80 + (i * 53) % 30));
+      twin->Measurement (MilliSeconds (80 + (i * 53) % 30));
+    }
+  std::stringstream blob;
+  saved->Serialize (blob);
+  std::string record = blob.str ();
+
+  // Every cut of the record is rejected, wherever it falls
+  for (uint32_t size = 0; size < record.size (); size++)
+    {
+      std::stringstream truncated (record.substr (0, size));
+      NS_TEST_EXPECT_MSG_EQ (rtt->Deserialize (truncated), false,
+                             tid.GetName () << " state cut to " << size << " bytes should be rejected");
+    }
+
+  // The first parameter of the subclass follows the name, the version,
+  // three times and the sample count
+  uint32_t offset = 4 + tid.GetName ().size () + 1 + 3 * 8 + 4;
+  std::string corrupted = record;
+  if (tid == RttEnsemble::GetTypeId ())
+    {
+      int32_t numTrackers = -1;
+      corrupted.replace (offset, sizeof (numTrackers), reinterpret_cast<const char *> (&numTrackers), sizeof (numTrackers));
+    }
+  else if (tid == RttShadowEstimator::GetTypeId ())
+    {
+      // The record of the primary estimator is cut short
+      corrupted.resize (record.size () - 1);
+    }
+  else
+    {
+      double invalid = -1;
+      corrupted.replace (offset, sizeof (invalid), reinterpret_cast<const char *> (&invalid), sizeof (invalid));
+    }
+  std::stringstream invalid (corrupted);
+  NS_TEST_EXPECT_MSG_EQ (rtt->Deserialize (invalid), false, tid.GetName () << " invalid state should be rejected");
+
+  NS_TEST_EXPECT_MSG_EQ (rtt->GetEstimate (), twin->GetEstimate (), tid.GetName () << " estimate changed by a rejected state");
+  NS_TEST_EXPECT_MSG_EQ (rtt->GetVariation (), twin->GetVariation (), tid.GetName () << " variation changed by a rejected state");
+  NS_TEST_EXPECT_MSG_EQ (rtt->GetNSamples (), twin->GetNSamples (), tid.GetName () << " samples changed by a rejected state");
+  double errorSum = 0;
+  double twinErrorSum = 0;
+  uint32_t samples = 0;
+  uint32_t twinSamples = 0;
+  rtt->GetErrorSum (errorSum, samples);
+  twin->GetErrorSum (twinErrorSum, twinSamples);
+  NS_TEST_EXPECT_MSG_EQ (errorSum, twinErrorSum, tid.GetName () << " errors changed by a rejected state");
+  NS_TEST_EXPECT_MSG_EQ (samples, twinSamples, tid.GetName () << " errors changed by a rejected state");
+
+  // The learned state is untouched too
+  for (uint32_t i = 0; i < 20; i++)
+    {
+      Time sample = MilliSeconds (150 + (i * 53) % 90);
+      rtt->Measurement (sample);
+      twin->Measurement (sample);
+    }
+  NS_TEST_EXPECT_MSG_EQ (rtt->GetEstimate (), twin->GetEstimate (), tid.GetName () << " should go on as if nothing was restored");
+  NS_TEST_EXPECT_MSG_EQ (rtt->GetVariation (), twin->GetVariation (), tid.GetName () << " should go on as if nothing was restored");
+}
+
+void
+RttEstimatorSerializeTestCase::DoRun (void)
+{
+  CheckRoundTrip (RttMeanDeviation::GetTypeId ());
+  CheckRoundTrip (RttFixedShare::GetTypeId ());
+  CheckRoundTrip (RttKalman::GetTypeId ());
+  CheckRoundTrip (RttEnsemble::GetTypeId ());
+  CheckRoundTrip (RttShadowEstimator::GetTypeId ());
+
+  CheckRejected (RttMeanDeviation::GetTypeId ());
+  CheckRejected (RttFixedShare::GetTypeId ());
+  CheckRejected (RttKalman::GetTypeId ());
+  CheckRejected (RttEnsemble::GetTypeId ());
+  CheckRejected (RttShadowEstimator::GetTypeId ());
+
+  // The diagnostics are running sums, so the state of a long replay stays
+  // small enough to be restored
+  Ptr<RttMeanDeviation> longRun = CreateObject<RttMeanDeviation> ();
+  uint32_t longSamples = (1 << 20) + 1000;
+  for (uint32_t i = 0; i < longSamples; i++)
+    {
+      longRun->Measurement (MilliSeconds (100 + (i * 37) % 60));
+    }
+  std::stringstream longBlob;
+  longRun->Serialize (longBlob);
+  NS_TEST_EXPECT_MSG_LT (longBlob.str ().size (), 1000, "The state should not grow with the samples");
+  Ptr<RttEstimator> longRestored = RttEstimator::CreateFromSerialized (longBlob);
+  NS_TEST_ASSERT_MSG_NE (longRestored, 0, "The state of a long replay should be restored");
+  double errorSum;
+  double restoredErrorSum;
+  uint32_t samples;
+  uint32_t restoredSamples;
+  longRun->GetErrorSum (errorSum, samples);
+  longRestored->GetErrorSum (restoredErrorSum, restoredSamples);
+  NS_TEST_EXPECT_MSG_EQ (samples, longSamples, "Every error should be counted");
+  NS_TEST_EXPECT_MSG_EQ (restoredSamples, samples, "The error count should be restored");
+  NS_TEST_EXPECT_MSG_EQ (restoredErrorSum, errorSum, "The error sum should be restored");
+
+  Ptr<RttFixedShare> fixedShare = CreateObject<RttFixedShare> ();
+  fixedShare->SetAttribute ("Alpha", DoubleValue (0.0625));
+  fixedShare->Measurement (MilliSeconds (120));
+  std::stringstream blob;
+  fixedShare->Serialize (blob);
+  std::string record = blob.str ();
+
+  // A state is only restored into an estimator of the same type
+  std::stringstream wrongType (record);
+  Ptr<RttKalman> kalman = CreateObject<RttKalman> ();
+  NS_TEST_EXPECT_MSG_EQ (kalman->Deserialize (wrongType), false, "State of another type should be rejected");
+
+  std::stringstream truncated (record.substr (0, record.size () / 2));
+  Ptr<RttFixedShare> other = CreateObject<RttFixedShare> ();
+  NS_TEST_EXPECT_MSG_EQ (other->Deserialize (truncated), false, "Truncated state should be rejected");
+
+  std::stringstream complete (record);
+  NS_TEST_EXPECT_MSG_EQ (other->Deserialize (complete), true, "State should be restored in place");
+  NS_TEST_EXPECT_MSG_EQ (other->GetEstimate (), fixedShare->GetEstimate (), "Estimate not restored in place");
+
+  // Values the attributes would refuse are rejected without touching the
+  // estimator
+  double alpha = 0.0625;
+  double invalidAlpha = 2.0;
+  std::string alphaBytes (reinterpret_cast<const char *> (&alpha), sizeof (alpha));
+  NS_TEST_ASSERT_MSG_NE (record.find (alphaBytes), std::string::npos, "Alpha should be in the state");
+  record.replace (record.find (alphaBytes), sizeof (alpha), reinterpret_cast<const char *> (&invalidAlpha), sizeof (invalidAlpha));
+  Ptr<RttFixedShare> kept = CreateObject<RttFixedShare> ();
+  kept->Measurement (MilliSeconds (80));
+  Time keptEstimate = kept->GetEstimate ();
+  std::stringstream invalid (record);
+  NS_TEST_EXPECT_MSG_EQ (kept->Deserialize (invalid), false, "State with an invalid Alpha should be rejected");
+  DoubleValue keptAlpha;
+  kept->GetAttribute ("Alpha", keptAlpha);
+  NS_TEST_EXPECT_MSG_EQ (keptAlpha.Get (), 0.08, "A rejected state should not change Alpha");
+  NS_TEST_EXPECT_MSG_EQ (kept->GetEstimate (), keptEstimate, "A rejected state should not change the estimate");
+  NS_TEST_EXPECT_MSG_EQ (kept->GetNSamples (), 1, "A rejected state should not change the samples");
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief RttEstimator error snapshot Test
+ */
+class RttEstimatorErrorSnapshotTestCase : public TestCase
+{
+public:
+  RttEstimatorErrorSnapshotTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \brief Gets the snapshot records of RttKalman estimators
+   * \return the records
+   */
+  std::vector<RttEstimator::ErrorRecord> GetKalmanRecords (void);
+};
+
+RttEstimatorErrorSnapshotTestCase::RttEstimatorErrorSnapshotTestCase ()
+  : TestCase ("RttEstimator Error Snapshot Test")
+{
+}
+
+std::vector<RttEstimator::ErrorRecord>
+RttEstimatorErrorSnapshotTestCase::GetKalmanRecords (void)
+{
+  std::vector<RttEstimator::ErrorRecord> all = RttEstimator::GetErrorSnapshot ();
+  std::vector<RttEstimator::ErrorRecord> records;
+  for (size_t i = 0; i < all.size (); i++)
+    {
+      if (all[i].typeName == RttKalman::GetTypeId ().GetName ())
+        {
+          records.push_back (all[i]);
+        }
+    }
+  return records;
+}
+
+void
+RttEstimatorErrorSnapshotTestCase::DoRun (void)
+{
+  // Estimators of the other tests were created before tracking and are ignored
+  RttEstimator::EnableErrorTracking ();
+
+  Ptr<RttKalman> rtt = CreateObject<RttKalman> ();
+  Ptr<RttKalman> idle = CreateObject<RttKalman> ();
+  NS_TEST_EXPECT_MSG_EQ (GetKalmanRecords ().size (), 0, "Estimators without errors should not be listed");
+
+  rtt->Measurement (MilliSeconds (100));
+  rtt->Measurement (MilliSeconds (150));
+  rtt->Measurement (MilliSeconds (120));
+  double errorSum;
+  uint32_t samples;
+  NS_TEST_ASSERT_MSG_EQ (rtt->GetErrorSum (errorSum, samples), true, "RttKalman should keep its errors");
+  NS_TEST_EXPECT_MSG_EQ (samples, 3, "Every measurement should be counted");
+
+  std::vector<RttEstimator::ErrorRecord> records = GetKalmanRecords ();
+  NS_TEST_ASSERT_MSG_EQ (records.size (), 1, "The live estimator should be listed");
+  NS_TEST_EXPECT_MSG_EQ (records[0].live, true, "The estimator is alive");
+  NS_TEST_EXPECT_MSG_EQ (records[0].samples, samples, "Incorrect number of samples");
+  NS_TEST_EXPECT_MSG_EQ_TOL (records[0].errorSum, errorSum, 1e-9, "Incorrect error sum");
+
+  // The errors stay in the snapshots once the estimator is destroyed
+  rtt = 0;
+  idle = 0;
+  records = GetKalmanRecords ();
+  NS_TEST_ASSERT_MSG_EQ (records.size (), 1, "The destroyed estimator should still be listed");
+  NS_TEST_EXPECT_MSG_EQ (records[0].live, false, "The estimator was destroyed");
+  NS_TEST_EXPECT_MSG_EQ (records[0].samples, samples, "Incorrect number of samples");
+  NS_TEST_EXPECT_MSG_EQ_TOL (records[0].errorSum, errorSum, 1e-9, "Incorrect error sum");
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief RttEstimatorStats Test
+ */
+class RttEstimatorStatsTestCase : public TestCase
+{
+public:
+  RttEstimatorStatsTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+RttEstimatorStatsTestCase::RttEstimatorStatsTestCase ()
+  : TestCase ("RttEstimatorStats Test")
+{
+}
+
+void
+RttEstimatorStatsTestCase::DoRun (void)
+{
+  // The counters of a type are created zeroed, once
+  RttEstimatorStats::Counters &counters = RttEstimatorStats::GetCounters ("ns3::RttStatsTest");
+  NS_TEST_EXPECT_MSG_EQ (&RttEstimatorStats::GetCounters ("ns3::RttStatsTest"), &counters, "Counters should be created once");
+  NS_TEST_EXPECT_MSG_EQ (counters.measurements, 0, "Counters should start at 0");
+
+  // 1 cycle falls in the first bucket, 1000 in the one of 2^9
+  RttEstimatorStats::RecordMeasurement (counters, 1);
+  RttEstimatorStats::RecordMeasurement (counters, 1000);
+  counters.copies++;
+  counters.events[RttEstimatorStats::SHARE_BOOST] += 3;
+  NS_TEST_EXPECT_MSG_EQ (counters.measurements, 2, "Incorrect number of measurements");
+  NS_TEST_EXPECT_MSG_EQ (counters.cycles, 1001, "Incorrect number of cycles");
+  NS_TEST_EXPECT_MSG_EQ (counters.histogram[0], 1, "Incorrect histogram");
+  NS_TEST_EXPECT_MSG_EQ (counters.histogram[9], 1, "Incorrect histogram");
+
+  std::ostringstream oss;
+  std::streambuf *clog = std::clog.rdbuf (oss.rdbuf ());
+  RttEstimatorStats::Dump ();
+  std::clog.rdbuf (clog);
+  std::string dump = oss.str ();
+  NS_TEST_EXPECT_MSG_NE (dump.find ("RttEstimatorStats ns3::RttStatsTest constructions 0 copies 1 resets 0 "
+                                    "measurements 2 cycles 1001 cycles/measurement 500 "
+                                    "weight-underflow 0 zero-denominator 0 share-boost 3\n"),
+                         std::string::npos, "Dump should print the counters");
+  NS_TEST_EXPECT_MSG_NE (dump.find ("RttEstimatorStats ns3::RttStatsTest histogram 2^0:1 2^9:1\n"),
+                         std::string::npos, "Dump should print the histogram");
+  NS_TEST_EXPECT_MSG_NE (dump.find ("RttEstimatorStats Measurement time "), std::string::npos,
+                         "Dump should print the Measurement time");
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief RttKalman Test
+ */
+class RttKalmanTestCase : public TestCase
+{
+public:
+  RttKalmanTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+RttKalmanTestCase::RttKalmanTestCase ()
+  : TestCase ("RttKalman Test")
+{
+}
+
+void
+RttKalmanTestCase::DoRun (void)
+{
+  Ptr<RttKalman> rtt = CreateObject<RttKalman> ();
+  bool ok = rtt->SetAttributeFailSafe ("ProcessNoise", DoubleValue (1e-6));
+  NS_TEST_EXPECT_MSG_EQ (ok, true, "Attribute should be settable");
+  ok = rtt->SetAttributeFailSafe ("MeasurementNoise", DoubleValue (1e-4));
+  NS_TEST_EXPECT_MSG_EQ (ok, true, "Attribute should be settable");
+
+  // The first sample is taken as is
+  rtt->Measurement (MilliSeconds (100));
+  NS_TEST_EXPECT_MSG_EQ (rtt->GetEstimate (), MilliSeconds (100), "Incorrect first estimate");
+  NS_TEST_EXPECT_MSG_EQ_TOL (rtt->GetErrorVariance (), 1e-4, 1e-12, "Incorrect first error variance");
+
+  // Second sample: gain = (1e-4 + 1e-6) / (1e-4 + 1e-6 + 1e-4)
+  double gain = 1.01e-4 / 2.01e-4;
+  rtt->Measurement (MilliSeconds (200));
+  NS_TEST_EXPECT_MSG_EQ_TOL (rtt->GetEstimate ().ToDouble (Time::S), 0.1 + gain * 0.1, 1e-9, "Incorrect estimate");
+  NS_TEST_EXPECT_MSG_EQ_TOL (rtt->GetErrorVariance (), (1 - gain) * 1.01e-4, 1e-12, "Incorrect error variance");
+
+  // The variation moves towards the absolute innovation of 100 ms from sqrt (R)
+  NS_TEST_EXPECT_MSG_EQ_TOL (rtt->GetVariation ().ToDouble (Time::S), 0.01 + 0.25 * (0.1 - 0.01), 1e-9,
+                             "Incorrect variation");
+
+  // A constant RTT is tracked, and the variation vanishes with the innovations
+  for (uint32_t i = 0; i < 200; i++)
+    {
+      rtt->Measurement (MilliSeconds (150));
+    }
+  NS_TEST_EXPECT_MSG_EQ_TOL (rtt->GetEstimate ().ToDouble (Time::MS), 150.0, 0.01, "Estimate should converge");
+  NS_TEST_EXPECT_MSG_LT (rtt->GetVariation (), MilliSeconds (1), "Variation should vanish without jitter");
+  NS_TEST_EXPECT_MSG_EQ (rtt->GetNSamples (), 202, "Incorrect number of samples");
+
+  Ptr<RttEstimator> copy = rtt->Copy ();
+  copy->Measurement (MilliSeconds (180));
+  rtt->Measurement (MilliSeconds (180));
+  NS_TEST_EXPECT_MSG_EQ (copy->GetEstimate (), rtt->GetEstimate (), "Copy should have inherited state");
+
+  rtt->Reset ();
+  NS_TEST_EXPECT_MSG_EQ (rtt->GetNSamples (), 0, "Reset should clear the samples");
+  rtt->Measurement (MilliSeconds (40));
+  NS_TEST_EXPECT_MSG_EQ (rtt->GetEstimate (), MilliSeconds (40), "Reset should restart from the next sample");
+
+  // The same base RTT with 1 ms and 50 ms of jitter, the variation being
+  // averaged once the estimates have settled
+  Ptr<RttKalman> low = CreateObject<RttKalman> ();
+  Ptr<RttKalman> high = CreateObject<RttKalman> ();
+  double lowSum = 0;
+  double highSum = 0;
+  for (uint32_t i = 0; i < 600; i++)
+    {
+      low->Measurement (MilliSeconds (100 + (i * 37) % 2));
+      high->Measurement (MilliSeconds (100 + (i * 37) % 50));
+      if (i >= 200)
+        {
+          lowSum += low->GetVariation ().GetSeconds ();
+          highSum += high->GetVariation ().GetSeconds ();
+        }
+    }
+  NS_TEST_EXPECT_MSG_LT (lowSum, 0.1 * highSum, "Variation should follow the jitter");
+  NS_TEST_EXPECT_MSG_LT (low->GetVariation (), MilliSeconds (2), "Variation should be small without jitter");
+  NS_TEST_EXPECT_MSG_GT (high->GetVariation (), MilliSeconds (5), "Variation should grow with the jitter");
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief RttEnsemble Test
+ */
+class RttEnsembleTestCase : public TestCase
+{
+public:
+  RttEnsembleTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+RttEnsembleTestCase::RttEnsembleTestCase ()
+  : TestCase ("RttEnsemble Test")
+{
+}
+
+void
+RttEnsembleTestCase::DoRun (void)
+{
+  Ptr<RttEnsemble> rtt = CreateObject<RttEnsemble> ();
+  bool ok = rtt->SetAttributeFailSafe ("NumTrackers", IntegerValue (12));
+  NS_TEST_EXPECT_MSG_EQ (ok, true, "Attribute should be settable");
+  Ptr<RttMeanDeviation> meanDev = CreateObject<RttMeanDeviation> ();
+
+  NS_TEST_EXPECT_MSG_EQ_TOL (rtt->GetGain (0), 1.0 / 64, 1e-12, "Incorrect slowest gain");
+  NS_TEST_EXPECT_MSG_EQ_TOL (rtt->GetGain (11), 0.75, 1e-12, "Incorrect fastest gain");
+
+  // The first sample is taken as is
+  rtt->Measurement (MilliSeconds (100));
+  NS_TEST_EXPECT_MSG_EQ (rtt->GetEstimate (), MilliSeconds (100), "Incorrect first estimate");
+  meanDev->Measurement (MilliSeconds (100));
+  for (uint32_t i = 0; i < 100; i++)
+    {
+      rtt->Measurement (MilliSeconds (100));
+      meanDev->Measurement (MilliSeconds (100));
+    }
+  NS_TEST_EXPECT_MSG_EQ_TOL (rtt->GetEstimate ().ToDouble (Time::MS), 100.0, 0.01, "Constant RTT should be tracked");
+
+  // After a route change, the fast trackers take over
+  for (uint32_t i = 0; i < 6; i++)
+    {
+      rtt->Measurement (MilliSeconds (300));
+      meanDev->Measurement (MilliSeconds (300));
+    }
+  NS_TEST_EXPECT_MSG_GT (rtt->GetEstimate (), meanDev->GetEstimate (), "Ensemble should adapt faster than MeanDeviation");
+  NS_TEST_EXPECT_MSG_GT (rtt->GetWeight (11), rtt->GetWeight (0), "Fast trackers should gain weight");
+
+  double weightSum = 0;
+  for (uint32_t i = 0; i < 12; i++)
+    {
+      weightSum += rtt->GetWeight (i);
+    }
+  NS_TEST_EXPECT_MSG_EQ_TOL (weightSum, 1.0, 1e-9, "Weights should stay normalized");
+
+  Ptr<RttEstimator> copy = rtt->Copy ();
+  copy->Measurement (MilliSeconds (250));
+  rtt->Measurement (MilliSeconds (250));
+  NS_TEST_EXPECT_MSG_EQ (copy->GetEstimate (), rtt->GetEstimate (), "Copy should have inherited state");
+  NS_TEST_EXPECT_MSG_EQ (copy->GetVariation (), rtt->GetVariation (), "Copy should have inherited state");
+
+  rtt->Reset ();
+  rtt->Measurement (MilliSeconds (40));
+  NS_TEST_EXPECT_MSG_EQ (rtt->GetEstimate (), MilliSeconds (40), "Reset should restart the trackers");
+
+  // Gains set after construction are the ones the trackers use
+  Ptr<RttEnsemble> custom = CreateObject<RttEnsemble> ();
+  custom->SetAttribute ("MinGain", DoubleValue (0.1));
+  custom->SetAttribute ("MaxGain", DoubleValue (0.4));
+  NS_TEST_EXPECT_MSG_EQ_TOL (custom->GetGain (0), 0.1, 1e-12, "Incorrect slowest gain");
+  NS_TEST_EXPECT_MSG_EQ_TOL (custom->GetGain (11), 0.4, 1e-12, "Incorrect fastest gain");
+  custom->SetAttribute ("NumTrackers", IntegerValue (5));
+  NS_TEST_EXPECT_MSG_EQ_TOL (custom->GetGain (2), 0.2, 1e-12, "Incorrect middle gain");
+  NS_TEST_EXPECT_MSG_EQ_TOL (custom->GetGain (4), 0.4, 1e-12, "Incorrect fastest gain");
+  custom->Measurement (MilliSeconds (100));
+  custom->Measurement (MilliSeconds (200));
+  NS_TEST_EXPECT_MSG_EQ_TOL (custom->GetGain (4), 0.4, 1e-12, "Measurements should keep the gains");
+  custom->SetAttribute ("MaxGain", DoubleValue (0.9));
+  NS_TEST_EXPECT_MSG_EQ_TOL (custom->GetGain (4), 0.9, 1e-12, "A new gain should rebuild the trackers");
+
+  // The gains are spaced geometrically, so a zero gain is refused
+  NS_TEST_EXPECT_MSG_EQ (custom->SetAttributeFailSafe ("MinGain", DoubleValue (0)), false, "MinGain 0 should be refused");
+  NS_TEST_EXPECT_MSG_EQ (custom->SetAttributeFailSafe ("MaxGain", DoubleValue (0)), false, "MaxGain 0 should be refused");
+  NS_TEST_EXPECT_MSG_EQ_TOL (custom->GetGain (0), 0.1, 1e-12, "A refused gain should keep the trackers");
+}
+
 /**
  * \ingroup internet-test
  * \ingroup tests
@@ -185,6 +1520,21 @@ public:
     : TestSuite ("rtt-estimator", UNIT)
   {
     AddTestCase (new RttEstimatorTestCase, TestCase::QUICK);
+    AddTestCase (new RttFixedShareBankTestCase, TestCase::QUICK);
+    AddTestCase (new RttFixedSharePoolTestCase, TestCase::QUICK);
+    AddTestCase (new RttShadowEstimatorTestCase, TestCase::QUICK);
+    AddTestCase (new RttKalmanTestCase, TestCase::QUICK);
+    AddTestCase (new RttFixedShareAdaptiveLrTestCase, TestCase::QUICK);
+    AddTestCase (new RttFixedShareExpertVariationTestCase, TestCase::QUICK);
+    AddTestCase (new RttFixedShareQuantileTestCase, TestCase::QUICK);
+    AddTestCase (new RttFixedShareRouteChangeTestCase, TestCase::QUICK);
+    AddTestCase (new RttFixedShareWarmStartTestCase, TestCase::QUICK);
+    AddTestCase (new RttFixedSharePriorTestCase, TestCase::QUICK);
+    AddTestCase (new RttFixedShareAsyncTestCase, TestCase::QUICK);
+    AddTestCase (new RttEstimatorSerializeTestCase, TestCase::QUICK);
+    AddTestCase (new RttEstimatorErrorSnapshotTestCase, TestCase::QUICK);
+    AddTestCase (new RttEstimatorStatsTestCase, TestCase::QUICK);
+    AddTestCase (new RttEnsembleTestCase, TestCase::QUICK);
   }
 
 };
@@ -0,0 +1,202 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/rng-seed-manager.h"
+#include "ns3/double.h"
+#include "ns3/string.h"
+#include "ns3/packet.h"
+#include "ns3/node-container.h"
+#include "ns3/net-device-container.h"
+#include "ns3/mobility-helper.h"
+#include "ns3/constant-velocity-mobility-model.h"
+#include "ns3/propagation-loss-model.h"
+#include "ns3/propagation-delay-model.h"
+#include "ns3/yans-wifi-channel.h"
+#include "ns3/yans-wifi-helper.h"
+#include "ns3/wifi-helper.h"
+#include "ns3/wifi-mac-helper.h"
+
+#include <map>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * \ingroup wifi-test
+ * \ingroup tests
+ *
+ * \brief YansWifiChannel SpatialIndexRange Test
+ *
+ * A node moving across several cells of the index broadcasts to a line of
+ * static nodes; every node must receive the same packets as without the
+ * index.
+ */
+class YansWifiChannelIndexTestCase : public TestCase
+{
+public:
+  YansWifiChannelIndexTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \brief Runs the scenario.
+   * \param indexRange the SpatialIndexRange of the channel, 0 for none
+   * \return the number of packets each static node received
+   */
+  std::vector<uint32_t> RunScenario (double indexRange);
+
+  /**
+   * \brief Broadcasts a packet.
+   * \param device the device to send from
+   */
+  void Send (Ptr<NetDevice> device);
+
+  /**
+   * \brief Counts a received packet.
+   * \param device the receiving device
+   * \param packet the packet
+   * \param protocol the protocol number
+   * \param from the sender address
+   * \return true
+   */
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol, const Address &from);
+
+  std::map<Ptr<NetDevice>, uint32_t> m_received; //!< Packets received by each device
+};
+
+YansWifiChannelIndexTestCase::YansWifiChannelIndexTestCase ()
+  : TestCase ("YansWifiChannel SpatialIndexRange Test")
+{
+}
+
+void
+YansWifiChannelIndexTestCase::Send (Ptr<NetDevice> device)
+{
+  device->Send (Create<Packet> (100), device->GetBroadcast (), 0x88b5);
+}
+
+bool
+YansWifiChannelIndexTestCase::Receive (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol,
+                                       const Address &from)
+{
+  m_received[device]++;
+  return true;
+}
+
+std::vector<uint32_t>
+YansWifiChannelIndexTestCase::RunScenario (double indexRange)
+{
+  const double range = 50.0;
+  const uint32_t receivers = 9;
+
+  RngSeedManager::SetSeed (1);
+  RngSeedManager::SetRun (1);
+  m_received.clear ();
+
+  NodeContainer nodes;
+  nodes.Create (1 + receivers);
+
+  Ptr<YansWifiChannel> channel = CreateObject<YansWifiChannel> ();
+  channel->SetPropagationDelayModel (CreateObject<ConstantSpeedPropagationDelayModel> ());
+  Ptr<RangePropagationLossModel> loss = CreateObject<RangePropagationLossModel> ();
+  loss->SetAttribute ("MaxRange", DoubleValue (range));
+  channel->SetPropagationLossModel (loss);
+  channel->SetAttribute ("SpatialIndexRange", DoubleValue (indexRange));
+
+  YansWifiPhyHelper phy = YansWifiPhyHelper::Default ();
+  phy.SetChannel (channel);
+  WifiMacHelper mac;
+  mac.SetType ("ns3::AdhocWifiMac");
+  WifiHelper wifi;
+  wifi.SetStandard (WIFI_PHY_STANDARD_80211a);
+  wifi.SetRemoteStationManager ("ns3::ConstantRateWifiManager",
+                                "DataMode", StringValue ("OfdmRate6Mbps"),
+                                "ControlMode", StringValue ("OfdmRate6Mbps"));
+  NetDeviceContainer devices = wifi.Install (phy, mac, nodes);
+
+  // The static nodes sit every 25 m along the path of the moving one, which
+  // crosses five columns and two rows of 51 m cells, some of them at negative
+  // coordinates
+  MobilityHelper mobility;
+  Ptr<ListPositionAllocator> positions = CreateObject<ListPositionAllocator> ();
+  positions->Add (Vector (-60.0, -30.0, 0.0));
+  for (uint32_t i = 0; i < receivers; i++)
+    {
+      positions->Add (Vector (-60.0 + 25.0 * i, 0.0, 0.0));
+    }
+  mobility.SetPositionAllocator (positions);
+  mobility.SetMobilityModel ("ns3::ConstantVelocityMobilityModel");
+  mobility.Install (nodes);
+  nodes.Get (0)->GetObject<ConstantVelocityMobilityModel> ()->SetVelocity (Vector (20.0, 6.0, 0.0));
+
+  for (uint32_t i = 1; i < devices.GetN (); i++)
+    {
+      devices.Get (i)->SetReceiveCallback (MakeCallback (&YansWifiChannelIndexTestCase::Receive, this));
+    }
+  for (uint32_t i = 0; i < 200; i++)
+    {
+      Simulator::Schedule (MilliSeconds (50 * i), &YansWifiChannelIndexTestCase::Send, this, devices.Get (0));
+    }
+  Simulator::Stop (Seconds (11));
+  Simulator::Run ();
+
+  std::vector<uint32_t> received;
+  for (uint32_t i = 1; i < devices.GetN (); i++)
+    {
+      received.push_back (m_received[devices.Get (i)]);
+    }
+  Simulator::Destroy ();
+  return received;
+}
+
+void
+YansWifiChannelIndexTestCase::DoRun (void)
+{
+  std::vector<uint32_t> plain = RunScenario (0.0);
+  std::vector<uint32_t> indexed = RunScenario (50.0);
+
+  uint32_t total = 0;
+  for (uint32_t i = 0; i < plain.size (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (indexed[i], plain[i], "Node " << i + 1 << " should receive the same packets with the index");
+      NS_TEST_EXPECT_MSG_LT (plain[i], 200u, "Every node should be out of range part of the time");
+      total += plain[i];
+    }
+  NS_TEST_EXPECT_MSG_GT (total, 0u, "The moving node should reach the others");
+}
+
+/**
+ * \ingroup wifi-test
+ * \ingroup tests
+ *
+ * \brief YansWifiChannel TestSuite
+ */
+class YansWifiChannelTestSuite : public TestSuite
+{
+public:
+  YansWifiChannelTestSuite ()
+    : TestSuite ("yans-wifi-channel", UNIT)
+  {
+    AddTestCase (new YansWifiChannelIndexTestCase, TestCase::QUICK);
+  }
+
+};
+
+static YansWifiChannelTestSuite g_yansWifiChannelTestSuite; //!< Static variable for test initialization
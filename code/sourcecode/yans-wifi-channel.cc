@@ -0,0 +1,402 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2006,2007 INRIA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Mathieu Lacage, <mathieu.lacage@sophia.inria.fr>
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include "ns3/simulator.h"
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/double.h"
+#include "ns3/pointer.h"
+#include "ns3/net-device.h"
+#include "ns3/node.h"
+#include "ns3/propagation-loss-model.h"
+#include "ns3/propagation-delay-model.h"
+#include "ns3/mobility-model.h"
+#include "yans-wifi-channel.h"
+#include "yans-wifi-phy.h"
+#include "wifi-utils.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("YansWifiChannel");
+
+NS_OBJECT_ENSURE_REGISTERED (YansWifiChannel);
+
+/// Cell key of the PHYs that are not in the spatial index
+static const int64_t NO_CELL = std::numeric_limits<int64_t>::min ();
+
+/// Added to SpatialIndexRange to get the cell size, to absorb rounding of the positions, in meters
+static const double CELL_MARGIN = 1.0;
+
+/**
+ * \param x the grid column
+ * \param y the grid row
+ * \return the key of the cell
+ */
+static int64_t
+CellKey (int64_t x, int64_t y)
+{
+  return (int64_t)(((uint64_t)x << 32) | (uint32_t)y);
+}
+
+TypeId
+YansWifiChannel::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::YansWifiChannel")
+    .SetParent<Channel> ()
+    .SetGroupName ("Wifi")
+    .AddConstructor<YansWifiChannel> ()
+    .AddAttribute ("PropagationLossModel", "A pointer to the propagation loss model attached to this channel.",
+                   PointerValue (),
+                   MakePointerAccessor (&YansWifiChannel::m_loss),
+                   MakePointerChecker<PropagationLossModel> ())
+    .AddAttribute ("PropagationDelayModel", "A pointer to the propagation delay model attached to this channel.",
+                   PointerValue (),
+                   MakePointerAccessor (&YansWifiChannel::m_delay),
+                   MakePointerChecker<PropagationDelayModel> ())
+    .AddAttribute ("SpatialIndexRange",
+                   "Distance in meters beyond which transmissions are not delivered, using a grid "
+                   "index of the PHY positions instead of going through every PHY. Must not be "
+                   "smaller than the range of the propagation loss model. 0 disables the index.",
+                   DoubleValue (0.0),
+                   MakeDoubleAccessor (&YansWifiChannel::m_indexRange),
+                   MakeDoubleChecker<double> (0.0))
+  ;
+  return tid;
+}
+
+YansWifiChannel::YansWifiChannel ()
+  : m_indexRange (0.0),
+    m_indexValid (false)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+YansWifiChannel::~YansWifiChannel ()
+{
+  NS_LOG_FUNCTION (this);
+  m_phyList.clear ();
+}
+
+void
+YansWifiChannel::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  for (std::set<Ptr<MobilityModel> >::iterator i = m_tracedMobility.begin (); i != m_tracedMobility.end (); i++)
+    {
+      (*i)->TraceDisconnectWithoutContext ("CourseChange", MakeCallback (&YansWifiChannel::CourseChanged, this));
+    }
+  m_tracedMobility.clear ();
+  m_physByMobility.clear ();
+  m_index.clear ();
+  m_cells.clear ();
+  m_crossings = std::priority_queue<Crossing, std::vector<Crossing>, std::greater<Crossing> > ();
+  m_indexValid = false;
+  Channel::DoDispose ();
+}
+
+void
+YansWifiChannel::SetPropagationLossModel (const Ptr<PropagationLossModel> loss)
+{
+  NS_LOG_FUNCTION (this << loss);
+  m_loss = loss;
+}
+
+void
+YansWifiChannel::SetPropagationDelayModel (const Ptr<PropagationDelayModel> delay)
+{
+  NS_LOG_FUNCTION (this << delay);
+  m_delay = delay;
+}
+
+void
+YansWifiChannel::Send (Ptr<YansWifiPhy> sender, Ptr<const Packet> packet, double txPowerDbm, Time duration) const
+{
+  NS_LOG_FUNCTION (this << sender << packet << txPowerDbm << duration.GetSeconds ());
+  Ptr<MobilityModel> senderMobility = sender->GetMobility ();
+  NS_ASSERT (senderMobility != 0);
+
+  if (m_indexRange > 0)
+    {
+      if (!m_indexValid)
+        {
+          BuildIndex ();
+        }
+      UpdateIndex ();
+
+      // Cells are wider than the range, so every PHY in range is in one of
+      // the 3x3 cells around the sender
+      Vector senderPosition = senderMobility->GetPosition ();
+      int64_t x = CellCoordinate (senderPosition.x);
+      int64_t y = CellCoordinate (senderPosition.y);
+      for (int64_t dx = -1; dx <= 1; dx++)
+        {
+          for (int64_t dy = -1; dy <= 1; dy++)
+            {
+              std::unordered_map<int64_t, std::vector<uint32_t> >::const_iterator cell = m_cells.find (CellKey (x + dx, y + dy));
+              if (cell == m_cells.end ())
+                {
+                  continue;
+                }
+              for (std::vector<uint32_t>::const_iterator i = cell->second.begin (); i != cell->second.end (); i++)
+                {
+                  Ptr<YansWifiPhy> receiver = m_phyList[*i];
+                  if (sender != receiver
+                      && senderMobility->GetDistanceFrom (m_index[*i].mobility) <= m_indexRange)
+                    {
+                      SendTo (sender, senderMobility, receiver, packet, txPowerDbm, duration);
+                    }
+                }
+            }
+        }
+      return;
+    }
+
+  for (PhyList::const_iterator i = m_phyList.begin (); i != m_phyList.end (); i++)
+    {
+      if (sender != (*i))
+        {
+          SendTo (sender, senderMobility, *i, packet, txPowerDbm, duration);
+        }
+    }
+}
+
+void
+YansWifiChannel::SendTo (Ptr<YansWifiPhy> sender, Ptr<MobilityModel> senderMobility, Ptr<YansWifiPhy> receiver,
+                         Ptr<const Packet> packet, double txPowerDbm, Time duration) const
+{
+  //For now don't account for inter channel interference nor channel bonding
+  if (receiver->GetChannelNumber () != sender->GetChannelNumber ())
+    {
+      return;
+    }
+
+  Ptr<MobilityModel> receiverMobility = receiver->GetMobility ()->GetObject<MobilityModel> ();
+  Time delay = m_delay->GetDelay (senderMobility, receiverMobility);
+  double rxPowerDbm = m_loss->CalcRxPower (txPowerDbm, senderMobility, receiverMobility);
+  NS_LOG_DEBUG ("propagation: txPower=" << txPowerDbm << "dbm, rxPower=" << rxPowerDbm << "dbm, " <<
+                "distance=" << senderMobility->GetDistanceFrom (receiverMobility) << "m, delay=" << delay);
+  Ptr<Packet> copy = packet->Copy ();
+  Ptr<NetDevice> dstNetDevice = receiver->GetDevice ();
+  uint32_t dstNode;
+  if (dstNetDevice == 0)
+    {
+      dstNode = 0xffffffff;
+    }
+  else
+    {
+      dstNode = dstNetDevice->GetNode ()->GetId ();
+    }
+
+  Simulator::ScheduleWithContext (dstNode,
+                                  delay, &YansWifiChannel::Receive,
+                                  receiver, copy, rxPowerDbm, duration);
+}
+
+void
+YansWifiChannel::Receive (Ptr<YansWifiPhy> phy, Ptr<Packet> packet, double rxPowerDbm, Time duration)
+{
+  NS_LOG_FUNCTION (phy << packet << rxPowerDbm << duration.GetSeconds ());
+  // Do no further processing if signal is too weak
+  // Current implementation assumes constant rx power over the packet duration
+  if ((rxPowerDbm + phy->GetRxGain ()) < phy->GetRxSensitivity ())
+    {
+      NS_LOG_INFO ("Received signal too weak to process: " << rxPowerDbm << " dBm");
+      return;
+    }
+  phy->StartReceivePreamble (packet, DbmToW (rxPowerDbm + phy->GetRxGain ()), duration);
+}
+
+std::size_t
+YansWifiChannel::GetNDevices (void) const
+{
+  return m_phyList.size ();
+}
+
+Ptr<NetDevice>
+YansWifiChannel::GetDevice (std::size_t i) const
+{
+  return m_phyList[i]->GetDevice ()->GetObject<NetDevice> ();
+}
+
+void
+YansWifiChannel::Add (Ptr<YansWifiPhy> phy)
+{
+  NS_LOG_FUNCTION (this << phy);
+  m_phyList.push_back (phy);
+  // The mobility model is usually installed after the PHY, so the index
+  // is only built at the first transmission
+  m_indexValid = false;
+}
+
+int64_t
+YansWifiChannel::AssignStreams (int64_t stream)
+{
+  NS_LOG_FUNCTION (this << stream);
+  int64_t currentStream = stream;
+  currentStream += m_loss->AssignStreams (stream);
+  return (currentStream - stream);
+}
+
+double
+YansWifiChannel::GetCellSize (void) const
+{
+  return m_indexRange + CELL_MARGIN;
+}
+
+int64_t
+YansWifiChannel::CellCoordinate (double x) const
+{
+  return (int64_t)std::floor (x / GetCellSize ());
+}
+
+void
+YansWifiChannel::BuildIndex (void) const
+{
+  NS_LOG_FUNCTION (this);
+  m_index.assign (m_phyList.size (), IndexEntry ());
+  m_cells.clear ();
+  m_crossings = std::priority_queue<Crossing, std::vector<Crossing>, std::greater<Crossing> > ();
+  m_physByMobility.clear ();
+
+  for (uint32_t i = 0; i < m_phyList.size (); i++)
+    {
+      Ptr<MobilityModel> mobility = m_phyList[i]->GetMobility ();
+      NS_ABORT_MSG_IF (mobility == 0, "SpatialIndexRange needs a mobility model on every PHY");
+      m_index[i].mobility = mobility;
+      m_index[i].cell = NO_CELL;
+      m_index[i].generation = 0;
+      m_physByMobility[PeekPointer (mobility)].push_back (i);
+      if (m_tracedMobility.insert (mobility).second)
+        {
+          mobility->TraceConnectWithoutContext ("CourseChange", MakeCallback (&YansWifiChannel::CourseChanged, this));
+        }
+      PlacePhy (i);
+    }
+  m_indexValid = true;
+  NS_LOG_DEBUG ("Indexed " << m_phyList.size () << " PHYs in " << m_cells.size () << " cells");
+}
+
+void
+YansWifiChannel::UpdateIndex (void) const
+{
+  Time now = Simulator::Now ();
+  while (!m_crossings.empty () && m_crossings.top ().when <= now)
+    {
+      Crossing crossing = m_crossings.top ();
+      m_crossings.pop ();
+      // Crossings computed before the last course change are stale
+      if (crossing.generation == m_index[crossing.phy].generation)
+        {
+          PlacePhy (crossing.phy);
+        }
+    }
+}
+
+void
+YansWifiChannel::PlacePhy (uint32_t phy) const
+{
+  IndexEntry &entry = m_index[phy];
+  Vector position = entry.mobility->GetPosition ();
+  Vector velocity = entry.mobility->GetVelocity ();
+  int64_t x = CellCoordinate (position.x);
+  int64_t y = CellCoordinate (position.y);
+  int64_t cell = CellKey (x, y);
+
+  if (cell != entry.cell)
+    {
+      if (entry.cell != NO_CELL)
+        {
+          std::vector<uint32_t> &old = m_cells[entry.cell];
+          for (uint32_t i = 0; i < old.size (); i++)
+            {
+              if (old[i] == phy)
+                {
+                  old[i] = old.back ();
+                  old.pop_back ();
+                  break;
+                }
+            }
+          if (old.empty ())
+            {
+              m_cells.erase (entry.cell);
+            }
+        }
+      m_cells[cell].push_back (phy);
+      entry.cell = cell;
+    }
+  entry.generation++;
+
+  // Time until the PHY leaves its cell at its current velocity
+  double size = GetCellSize ();
+  double exit = std::numeric_limits<double>::infinity ();
+  if (velocity.x > 0)
+    {
+      exit = std::min (exit, ((x + 1) * size - position.x) / velocity.x);
+    }
+  else if (velocity.x < 0)
+    {
+      exit = std::min (exit, (x * size - position.x) / velocity.x);
+    }
+  if (velocity.y > 0)
+    {
+      exit = std::min (exit, ((y + 1) * size - position.y) / velocity.y);
+    }
+  else if (velocity.y < 0)
+    {
+      exit = std::min (exit, (y * size - position.y) / velocity.y);
+    }
+  if (exit != std::numeric_limits<double>::infinity ())
+    {
+      // A PHY whose crossing came due is often still a fraction of a
+      // nanosecond short of the border, so it stays in its cell with an
+      // exit under one time step. Schedule that one for the next time step,
+      // as a crossing at Now would be popped again and again; the cell margin
+      // covers the PHY being placed that late.
+      Crossing crossing;
+      crossing.when = std::max (Simulator::Now () + Seconds (std::max (0.0, exit)),
+                                Simulator::Now () + TimeStep (1));
+      crossing.phy = phy;
+      crossing.generation = entry.generation;
+      m_crossings.push (crossing);
+    }
+}
+
+void
+YansWifiChannel::CourseChanged (Ptr<const MobilityModel> mobility) const
+{
+  if (!m_indexValid)
+    {
+      return;
+    }
+  std::map<const MobilityModel *, std::vector<uint32_t> >::const_iterator it = m_physByMobility.find (PeekPointer (mobility));
+  if (it == m_physByMobility.end ())
+    {
+      return;
+    }
+  for (uint32_t i = 0; i < it->second.size (); i++)
+    {
+      PlacePhy (it->second[i]);
+    }
+}
+
+} //namespace ns3
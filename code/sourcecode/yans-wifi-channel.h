@@ -0,0 +1,230 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2006,2007 INRIA
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Mathieu Lacage, <mathieu.lacage@sophia.inria.fr>
+ */
+
+#ifndef YANS_WIFI_CHANNEL_H
+#define YANS_WIFI_CHANNEL_H
+
+#include <map>
+#include <queue>
+#include <set>
+#include <unordered_map>
+#include <vector>
+#include "ns3/channel.h"
+#include "ns3/nstime.h"
+
+namespace ns3 {
+
+class NetDevice;
+class MobilityModel;
+class PropagationLossModel;
+class PropagationDelayModel;
+class YansWifiPhy;
+class Packet;
+
+/**
+ * \brief a channel to interconnect ns3::YansWifiPhy objects.
+ * \ingroup wifi
+ *
+ * This class is expected to be used in tandem with the ns3::YansWifiPhy
+ * class and supports an ns3::PropagationLossModel and an
+ * ns3::PropagationDelayModel.  By default, no propagation models are set;
+ * it is the caller's responsibility to set them before using the channel.
+ *
+ * When the SpatialIndexRange attribute is set, the PHYs are kept in a
+ * uniform grid of cells as wide as that range, and a transmission is only
+ * delivered to the PHYs of the 3x3 cells around the sender that are
+ * within the range, instead of to every PHY of the channel.  This is only
+ * exact if no signal can be received beyond that range, e.g. with a
+ * RangePropagationLossModel whose MaxRange is not larger.
+ *
+ * The grid is updated from the CourseChange traces of the mobility
+ * models, and at the time each PHY crosses the border of its cell, which
+ * is known from its velocity.  Between course changes a PHY is thus only
+ * moved when it actually changes cell.
+ */
+class YansWifiChannel : public Channel
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  YansWifiChannel ();
+  virtual ~YansWifiChannel ();
+
+  //inherited from Channel.
+  std::size_t GetNDevices (void) const;
+  Ptr<NetDevice> GetDevice (std::size_t i) const;
+
+  /**
+   * Adds the given YansWifiPhy to the PHY list
+   *
+   * \param phy the YansWifiPhy to be added to the PHY list
+   */
+  void Add (Ptr<YansWifiPhy> phy);
+
+  /**
+   * \param loss the new propagation loss model.
+   */
+  void SetPropagationLossModel (const Ptr<PropagationLossModel> loss);
+  /**
+   * \param delay the new propagation delay model.
+   */
+  void SetPropagationDelayModel (const Ptr<PropagationDelayModel> delay);
+
+  /**
+   * \param sender the phy object from which the packet is originating.
+   * \param packet the packet to send
+   * \param txPowerDbm the tx power associated to the packet, in dBm
+   * \param duration the transmission duration associated with the packet
+   *
+   * This method should not be invoked by normal users. It is
+   * currently invoked only from YansWifiPhy::StartTx.  The channel
+   * attempts to deliver the packet to all other YansWifiPhy objects
+   * on the channel (except for the sender), or with SpatialIndexRange
+   * to those within that range.
+   */
+  void Send (Ptr<YansWifiPhy> sender, Ptr<const Packet> packet, double txPowerDbm, Time duration) const;
+
+  /**
+   * Assign a fixed random variable stream number to the random variables
+   * used by this model.  Return the number of streams (possibly zero) that
+   * have been assigned.
+   *
+   * \param stream first stream index to use
+   *
+   * \return the number of stream indices assigned by this model
+   */
+  int64_t AssignStreams (int64_t stream);
+
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  /**
+   * A vector of pointers to YansWifiPhy.
+   */
+  typedef std::vector<Ptr<YansWifiPhy> > PhyList;
+
+  /**
+   * This method is scheduled by Send for each associated YansWifiPhy.
+   * The method then calls the corresponding YansWifiPhy that the first
+   * bit of the packet has arrived.
+   *
+   * \param receiver the device to which the packet is destined
+   * \param packet the packet being sent
+   * \param txPowerDbm the tx power associated to the packet being sent (dBm)
+   * \param duration the transmission duration associated with the packet being sent
+   */
+  static void Receive (Ptr<YansWifiPhy> receiver, Ptr<Packet> packet, double txPowerDbm, Time duration);
+
+  /**
+   * \brief Delivers a transmission to one PHY, as Send does for all of them.
+   * \param sender the phy object from which the packet is originating
+   * \param senderMobility the mobility model of the sender
+   * \param receiver the phy object to deliver to
+   * \param packet the packet to send
+   * \param txPowerDbm the tx power associated to the packet, in dBm
+   * \param duration the transmission duration associated with the packet
+   */
+  void SendTo (Ptr<YansWifiPhy> sender, Ptr<MobilityModel> senderMobility, Ptr<YansWifiPhy> receiver,
+               Ptr<const Packet> packet, double txPowerDbm, Time duration) const;
+
+  /**
+   * \brief Position of a PHY in the spatial index
+   */
+  struct IndexEntry
+  {
+    Ptr<MobilityModel> mobility; //!< Mobility model of the PHY
+    int64_t cell;                //!< Key of the cell the PHY is in
+    uint32_t generation;         //!< Incremented when the entry is moved, to expire old border crossings
+  };
+
+  /**
+   * \brief Time at which a PHY crosses the border of its cell
+   */
+  struct Crossing
+  {
+    Time when;           //!< Time of the crossing
+    uint32_t phy;        //!< Index of the PHY in m_phyList
+    uint32_t generation; //!< Generation of the entry the crossing was computed for
+    /**
+     * \param o the other crossing
+     * \return true if this crossing is later, for a min-heap
+     */
+    bool operator> (const Crossing &o) const
+    {
+      return when > o.when;
+    }
+  };
+
+  /**
+   * \brief Builds the spatial index from the current positions of the PHYs.
+   */
+  void BuildIndex (void) const;
+
+  /**
+   * \brief Moves the PHYs whose cell border crossing is due.
+   */
+  void UpdateIndex (void) const;
+
+  /**
+   * \brief Puts a PHY in the cell of its current position and schedules
+   * its next border crossing.
+   * \param phy index of the PHY in m_phyList
+   */
+  void PlacePhy (uint32_t phy) const;
+
+  /**
+   * \brief Called by the CourseChange trace of a mobility model.
+   * \param mobility the mobility model whose course changed
+   */
+  void CourseChanged (Ptr<const MobilityModel> mobility) const;
+
+  /**
+   * \param x the coordinate
+   * \return the index of the grid column or row holding x
+   */
+  int64_t CellCoordinate (double x) const;
+
+  /**
+   * \return the width of the grid cells, in meters
+   */
+  double GetCellSize (void) const;
+
+  PhyList m_phyList;                   //!< List of YansWifiPhys connected to this YansWifiChannel
+  Ptr<PropagationLossModel> m_loss;    //!< Propagation loss model
+  Ptr<PropagationDelayModel> m_delay;  //!< Propagation delay model
+
+  double m_indexRange;                 //!< Range beyond which receivers are culled, 0 if no index
+  mutable bool m_indexValid;           //!< Whether the index holds every PHY
+  mutable std::vector<IndexEntry> m_index; //!< Index entry of each PHY, in the order of m_phyList
+  mutable std::unordered_map<int64_t, std::vector<uint32_t> > m_cells; //!< PHYs of each non-empty cell
+  mutable std::priority_queue<Crossing, std::vector<Crossing>, std::greater<Crossing> > m_crossings; //!< Next border crossings
+  mutable std::map<const MobilityModel *, std::vector<uint32_t> > m_physByMobility; //!< PHYs moved by each mobility model
+  mutable std::set<Ptr<MobilityModel> > m_tracedMobility; //!< Mobility models whose CourseChange is connected
+};
+
+} //namespace ns3
+
+#endif /* YANS_WIFI_CHANNEL_H */
@@ -0,0 +1,620 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Offline extraction of TCP RTT samples from pcap captures.
+ *
+ * Reads one or more pcap files (as written by the ns-3 pcap helpers) and
+ * prints the RTT samples of every TCP flow in the format read by
+ * rtt-replay:
+ *
+ *   <flow id> <rtt in seconds>
+ *
+ * Each flow is a data direction of a TCP connection. When a flow is first
+ * seen, a comment line "# flow <id> <src>:<port> > <dst>:<port> <file>"
+ * is printed, so the samples can be traced back to the connection.
+ *
+ * Data segments are matched to the cumulative ACKs that cover them. When
+ * the ACK echoes a TCP timestamp, the sample is taken from the segment
+ * that carried that timestamp, which also gives valid samples for
+ * retransmitted data. Without timestamps, Karn's rule applies: ACKs that
+ * cover retransmitted data give no sample. 802.11 frames with the Retry
+ * bit set are MAC retransmissions of a frame already seen and are skipped.
+ *
+ * A capture only sees the RTT from the point of view of the node it was
+ * taken on, so use the captures of the sending nodes for end to end RTTs.
+ * Each file is matched on its own; flow ids are unique across files.
+ *
+ * Files are memory mapped and read in one pass, so captures larger than
+ * memory can be processed.  Supported link types are Ethernet, PPP, raw
+ * IPv4 and 802.11 (plain or with radiotap), with IPv4 only.
+ *
+ * Build and run:
+ *   g++ -O2 -std=c++11 -o pcap-rtt pcap-rtt.cc
+ *   ./pcap-rtt scenario1-0-0.pcap scenario1-1-0.pcap > s1.rtt
+ *
+ * Options:
+ *   --no-timestamps  ignore TCP timestamps and only use Karn's rule
+**/
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <stdint.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// pcap link types
+static const uint32_t LINKTYPE_ETHERNET = 1;
+static const uint32_t LINKTYPE_PPP = 9;
+static const uint32_t LINKTYPE_RAW = 101;
+static const uint32_t LINKTYPE_IEEE802_11 = 105;
+static const uint32_t LINKTYPE_IEEE802_11_RADIOTAP = 127;
+static const uint32_t LINKTYPE_IPV4 = 228;
+
+// TCP flags
+static const uint8_t TCP_FIN = 0x01;
+static const uint8_t TCP_SYN = 0x02;
+static const uint8_t TCP_RST = 0x04;
+static const uint8_t TCP_ACK = 0x10;
+
+// Sequence number comparison, modulo 2^32
+static inline bool
+SeqLess (uint32_t a, uint32_t b)
+{
+  return (int32_t) (a - b) < 0;
+}
+
+static inline uint16_t
+Read16 (const uint8_t *p)
+{
+  return (p[0] << 8) | p[1];
+}
+
+static inline uint32_t
+Read32 (const uint8_t *p)
+{
+  return ((uint32_t) p[0] << 24) | ((uint32_t) p[1] << 16) | ((uint32_t) p[2] << 8) | p[3];
+}
+
+static inline uint32_t
+Swap32 (uint32_t v)
+{
+  return ((v & 0xff) << 24) | ((v & 0xff00) << 8) | ((v >> 8) & 0xff00) | (v >> 24);
+}
+
+// A data segment that has not been fully acknowledged yet
+struct Segment
+{
+  uint32_t seqStart; // Sequence number of the first byte of the segment
+  uint32_t seqEnd;   // Sequence number following the segment
+  double time;       // Capture time of the segment
+  uint32_t tsval;    // TCP timestamp value, if hasTs
+  bool hasTs;        // Whether the segment carried a timestamp
+  bool retransmit;   // Whether the data was sent more than once (Karn)
+};
+
+// State of one data direction of a connection
+struct Flow
+{
+  uint32_t id;
+  bool started;                 // Whether sndUna and sndMax are valid
+  uint32_t sndUna;              // Oldest unacknowledged sequence number
+  uint32_t sndMax;              // Highest sequence number sent
+  std::deque<Segment> inFlight; // Segments in the order they were sent
+};
+
+// Addresses and ports of a data direction
+struct FlowKey
+{
+  uint32_t src;
+  uint32_t dst;
+  uint16_t sport;
+  uint16_t dport;
+
+  bool operator== (const FlowKey &o) const
+  {
+    return src == o.src && dst == o.dst && sport == o.sport && dport == o.dport;
+  }
+};
+
+struct FlowKeyHash
+{
+  size_t operator() (const FlowKey &k) const
+  {
+    uint64_t h = ((uint64_t) k.src << 32 | k.dst) * 0x9e3779b97f4a7c15ULL;
+    h ^= ((uint64_t) k.sport << 16 | k.dport) + (h >> 29);
+    return h * 0xbf58476d1ce4e5b9ULL;
+  }
+};
+
+// A parsed TCP segment
+struct TcpSegment
+{
+  FlowKey key;
+  uint32_t seq;
+  uint32_t ack;
+  uint8_t flags;
+  uint32_t length;  // Sequence space used: payload, plus one for SYN and FIN
+  bool hasTs;
+  uint32_t tsval;
+  uint32_t tsecr;
+};
+
+class RttExtractor
+{
+public:
+  RttExtractor (bool useTimestamps)
+    : m_useTimestamps (useTimestamps),
+      m_nextId (0),
+      m_nSamples (0)
+  {
+  }
+
+  // Processes one capture file. Returns false if it cannot be read.
+  bool ProcessFile (const std::string &fileName);
+
+  uint64_t GetNSamples () const
+  {
+    return m_nSamples;
+  }
+
+  uint32_t GetNFlows () const
+  {
+    return m_nextId;
+  }
+
+private:
+  bool ParseFrame (uint32_t linkType, const uint8_t *p, uint32_t len, TcpSegment &seg);
+  bool ParseIpv4 (const uint8_t *p, uint32_t len, TcpSegment &seg);
+  void OnSegment (const TcpSegment &seg, double time);
+  void OnData (const TcpSegment &seg, double time);
+  void OnAck (const TcpSegment &seg, double time);
+
+  typedef std::unordered_map<FlowKey, Flow, FlowKeyHash> FlowTable;
+
+  bool m_useTimestamps;
+  uint32_t m_nextId;
+  uint64_t m_nSamples;
+  std::string m_fileName;
+  FlowTable m_flows;
+};
+
+bool
+RttExtractor::ProcessFile (const std::string &fileName)
+{
+  int fd = open (fileName.c_str (), O_RDONLY);
+  if (fd < 0)
+  {
+    perror (fileName.c_str ());
+    return false;
+  }
+  struct stat st;
+  if (fstat (fd, &st) < 0 || st.st_size < 24)
+  {
+    std::cerr << fileName << ": not a pcap file" << std::endl;
+    close (fd);
+    return false;
+  }
+  size_t size = st.st_size;
+  void *map = mmap (NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close (fd);
+  if (map == MAP_FAILED)
+  {
+    perror (fileName.c_str ());
+    return false;
+  }
+  madvise (map, size, MADV_SEQUENTIAL);
+  const uint8_t *data = (const uint8_t *) map;
+
+  uint32_t magic;
+  memcpy (&magic, data, 4);
+  bool swapped = false;
+  double tsScale = 1e-6;
+  if (magic == 0xa1b2c3d4 || magic == 0xa1b23c4d)
+  {
+    tsScale = magic == 0xa1b2c3d4 ? 1e-6 : 1e-9;
+  }
+  else if (magic == 0xd4c3b2a1 || magic == 0x4d3cb2a1)
+  {
+    swapped = true;
+    tsScale = magic == 0xd4c3b2a1 ? 1e-6 : 1e-9;
+  }
+  else
+  {
+    std::cerr << fileName << ": not a pcap file (pcapng is not supported)" << std::endl;
+    munmap (map, size);
+    return false;
+  }
+
+  uint32_t linkType;
+  memcpy (&linkType, data + 20, 4);
+  if (swapped)
+  {
+    linkType = Swap32 (linkType);
+  }
+  linkType &= 0x0fffffff;
+
+  // Flows are not matched across files, but their ids stay unique
+  m_flows.clear ();
+  m_fileName = fileName;
+
+  size_t offset = 24;
+  while (offset + 16 <= size)
+  {
+    uint32_t hdr[4];
+    memcpy (hdr, data + offset, 16);
+    if (swapped)
+    {
+      for (int i = 0; i < 4; i++)
+      {
+        hdr[i] = Swap32 (hdr[i]);
+      }
+    }
+    uint32_t capLen = hdr[2];
+    offset += 16;
+    if (capLen > size - offset)
+    {
+      std::cerr << fileName << ": truncated capture" << std::endl;
+      break;
+    }
+    double time = hdr[0] + hdr[1] * tsScale;
+
+    TcpSegment seg;
+    if (ParseFrame (linkType, data + offset, capLen, seg))
+    {
+      OnSegment (seg, time);
+    }
+    offset += capLen;
+  }
+
+  munmap (map, size);
+  return true;
+}
+
+bool
+RttExtractor::ParseFrame (uint32_t linkType, const uint8_t *p, uint32_t len, TcpSegment &seg)
+{
+  switch (linkType)
+  {
+  case LINKTYPE_ETHERNET:
+    if (len < 14 || Read16 (p + 12) != 0x0800)
+    {
+      return false;
+    }
+    return ParseIpv4 (p + 14, len - 14, seg);
+
+  case LINKTYPE_PPP:
+    // ns-3 writes the 2 byte protocol field only
+    if (len < 2 || Read16 (p) != 0x0021)
+    {
+      return false;
+    }
+    return ParseIpv4 (p + 2, len - 2, seg);
+
+  case LINKTYPE_RAW:
+  case LINKTYPE_IPV4:
+    return ParseIpv4 (p, len, seg);
+
+  case LINKTYPE_IEEE802_11_RADIOTAP:
+    {
+      if (len < 4)
+      {
+        return false;
+      }
+      // Radiotap header length is little endian
+      uint32_t rtLen = p[2] | (p[3] << 8);
+      if (rtLen > len)
+      {
+        return false;
+      }
+      return ParseFrame (LINKTYPE_IEEE802_11, p + rtLen, len - rtLen, seg);
+    }
+
+  case LINKTYPE_IEEE802_11:
+    {
+      if (len < 24)
+      {
+        return false;
+      }
+      uint8_t type = (p[0] >> 2) & 0x3;
+      uint8_t subtype = p[0] >> 4;
+      uint8_t flags = p[1];
+      // Data frames only, skipping null function frames and MAC retries
+      if (type != 2 || (subtype & 0x4) || (flags & 0x08))
+      {
+        return false;
+      }
+      uint32_t hdrLen = 24;
+      if ((flags & 0x03) == 0x03)
+      {
+        hdrLen += 6; // Four address frame
+      }
+      if (subtype & 0x8)
+      {
+        hdrLen += 2; // QoS control
+      }
+      // LLC/SNAP header for IPv4
+      static const uint8_t snap[8] = { 0xaa, 0xaa, 0x03, 0x00, 0x00, 0x00, 0x08, 0x00 };
+      if (len < hdrLen + 8 || memcmp (p + hdrLen, snap, 8) != 0)
+      {
+        return false;
+      }
+      return ParseIpv4 (p + hdrLen + 8, len - hdrLen - 8, seg);
+    }
+
+  default:
+    return false;
+  }
+}
+
+bool
+RttExtractor::ParseIpv4 (const uint8_t *p, uint32_t len, TcpSegment &seg)
+{
+  if (len < 20 || (p[0] >> 4) != 4 || p[9] != 6)
+  {
+    return false;
+  }
+  uint32_t ihl = (p[0] & 0xf) * 4;
+  uint32_t totalLen = Read16 (p + 2);
+  // Skip non-first fragments
+  if ((Read16 (p + 6) & 0x1fff) != 0 || ihl < 20 || totalLen < ihl + 20 || len < ihl + 20)
+  {
+    return false;
+  }
+  seg.key.src = Read32 (p + 12);
+  seg.key.dst = Read32 (p + 16);
+
+  const uint8_t *tcp = p + ihl;
+  uint32_t tcpLen = totalLen - ihl;
+  uint32_t dataOffset = (tcp[12] >> 4) * 4;
+  if (dataOffset < 20 || dataOffset > tcpLen)
+  {
+    return false;
+  }
+  seg.key.sport = Read16 (tcp);
+  seg.key.dport = Read16 (tcp + 2);
+  seg.seq = Read32 (tcp + 4);
+  seg.ack = Read32 (tcp + 8);
+  seg.flags = tcp[13];
+  seg.length = tcpLen - dataOffset;
+  if (seg.flags & TCP_SYN)
+  {
+    seg.length++;
+  }
+  if (seg.flags & TCP_FIN)
+  {
+    seg.length++;
+  }
+
+  // Look for the timestamp option, within the captured bytes
+  seg.hasTs = false;
+  uint32_t optEnd = std::min (dataOffset, len - ihl);
+  uint32_t i = 20;
+  while (i < optEnd)
+  {
+    uint8_t kind = tcp[i];
+    if (kind == 0)
+    {
+      break;
+    }
+    if (kind == 1)
+    {
+      i++;
+      continue;
+    }
+    if (i + 1 >= optEnd || tcp[i + 1] < 2)
+    {
+      break;
+    }
+    uint8_t optLen = tcp[i + 1];
+    if (kind == 8 && optLen == 10 && i + 10 <= optEnd)
+    {
+      seg.hasTs = true;
+      seg.tsval = Read32 (tcp + i + 2);
+      seg.tsecr = Read32 (tcp + i + 6);
+    }
+    i += optLen;
+  }
+  return true;
+}
+
+void
+RttExtractor::OnSegment (const TcpSegment &seg, double time)
+{
+  if (seg.flags & TCP_RST)
+  {
+    // The connection is gone, forget both directions
+    FlowKey reverse = { seg.key.dst, seg.key.src, seg.key.dport, seg.key.sport };
+    m_flows.erase (seg.key);
+    m_flows.erase (reverse);
+    return;
+  }
+  if (seg.flags & TCP_ACK)
+  {
+    OnAck (seg, time);
+  }
+  if (seg.length > 0)
+  {
+    OnData (seg, time);
+  }
+}
+
+void
+RttExtractor::OnData (const TcpSegment &seg, double time)
+{
+  FlowTable::iterator it = m_flows.find (seg.key);
+  if (it == m_flows.end ())
+  {
+    Flow flow;
+    flow.id = m_nextId++;
+    flow.started = false;
+    it = m_flows.insert (std::make_pair (seg.key, flow)).first;
+
+    const FlowKey &k = seg.key;
+    std::cout << "# flow " << flow.id << " "
+              << (k.src >> 24) << "." << ((k.src >> 16) & 0xff) << "." << ((k.src >> 8) & 0xff) << "." << (k.src & 0xff)
+              << ":" << k.sport << " > "
+              << (k.dst >> 24) << "." << ((k.dst >> 16) & 0xff) << "." << ((k.dst >> 8) & 0xff) << "." << (k.dst & 0xff)
+              << ":" << k.dport << " " << m_fileName << "\n";
+  }
+  Flow &flow = it->second;
+
+  uint32_t seqEnd = seg.seq + seg.length;
+  if (!flow.started)
+  {
+    flow.started = true;
+    flow.sndUna = seg.seq;
+    flow.sndMax = seg.seq;
+  }
+  else if (!SeqLess (flow.sndUna, seqEnd))
+  {
+    // Already acknowledged
+    return;
+  }
+
+  Segment s;
+  s.seqStart = seg.seq;
+  s.seqEnd = seqEnd;
+  s.time = time;
+  s.hasTs = seg.hasTs;
+  s.tsval = seg.tsval;
+  s.retransmit = false;
+
+  if (SeqLess (seg.seq, flow.sndMax))
+  {
+    // Retransmission: the ACK of any copy of this data is ambiguous, but
+    // segments sent after it that do not overlap it are not
+    s.retransmit = true;
+    for (std::deque<Segment>::iterator sit = flow.inFlight.begin (); sit != flow.inFlight.end (); sit++)
+    {
+      if (SeqLess (seg.seq, sit->seqEnd) && SeqLess (sit->seqStart, seqEnd))
+      {
+        sit->retransmit = true;
+      }
+    }
+  }
+  if (SeqLess (flow.sndMax, seqEnd))
+  {
+    flow.sndMax = seqEnd;
+  }
+  flow.inFlight.push_back (s);
+}
+
+void
+RttExtractor::OnAck (const TcpSegment &seg, double time)
+{
+  FlowKey reverse = { seg.key.dst, seg.key.src, seg.key.dport, seg.key.sport };
+  FlowTable::iterator it = m_flows.find (reverse);
+  if (it == m_flows.end ())
+  {
+    return;
+  }
+  Flow &flow = it->second;
+  // Only ACKs of new data give samples
+  if (!flow.started || !SeqLess (flow.sndUna, seg.ack) || SeqLess (flow.sndMax, seg.ack))
+  {
+    return;
+  }
+  flow.sndUna = seg.ack;
+
+  bool useTs = m_useTimestamps && seg.hasTs;
+  bool ambiguous = false;
+  bool exact = false;
+  double exactTime = 0;
+  bool tsMatch = false;
+  double tsTime = 0;
+
+  std::deque<Segment>::iterator sit = flow.inFlight.begin ();
+  while (sit != flow.inFlight.end ())
+  {
+    if (SeqLess (seg.ack, sit->seqEnd))
+    {
+      sit++;
+      continue;
+    }
+    if (useTs && sit->hasTs && sit->tsval == seg.tsecr && (!tsMatch || sit->time > tsTime))
+    {
+      // The peer echoes the timestamp of the segment that triggered the ACK
+      tsMatch = true;
+      tsTime = sit->time;
+    }
+    ambiguous = ambiguous || sit->retransmit;
+    if (sit->seqEnd == seg.ack)
+    {
+      exact = true;
+      exactTime = sit->time;
+    }
+    sit = flow.inFlight.erase (sit);
+  }
+
+  double sendTime;
+  if (tsMatch)
+  {
+    sendTime = tsTime;
+  }
+  else if (exact && !ambiguous)
+  {
+    sendTime = exactTime;
+  }
+  else
+  {
+    return;
+  }
+
+  char buf[64];
+  snprintf (buf, sizeof (buf), "%u %.9f\n", flow.id, time - sendTime);
+  std::cout << buf;
+  m_nSamples++;
+}
+
+int
+main (int argc, char *argv[])
+{
+  bool useTimestamps = true;
+  std::vector<std::string> files;
+  for (int i = 1; i < argc; i++)
+  {
+    std::string arg = argv[i];
+    if (arg == "--no-timestamps")
+    {
+      useTimestamps = false;
+    }
+    else if (arg.size () > 1 && arg[0] == '-')
+    {
+      std::cerr << "Usage: " << argv[0] << " [--no-timestamps] file.pcap..." << std::endl;
+      return 1;
+    }
+    else
+    {
+      files.push_back (arg);
+    }
+  }
+  if (files.empty ())
+  {
+    std::cerr << "Usage: " << argv[0] << " [--no-timestamps] file.pcap..." << std::endl;
+    return 1;
+  }
+
+  std::ios::sync_with_stdio (false);
+
+  RttExtractor extractor (useTimestamps);
+  int failed = 0;
+  for (size_t i = 0; i < files.size (); i++)
+  {
+    if (!extractor.ProcessFile (files[i]))
+    {
+      failed++;
+    }
+  }
+  std::cout.flush ();
+
+  std::cerr << "Extracted " << extractor.GetNSamples () << " samples of "
+            << extractor.GetNFlows () << " flows from " << files.size () - failed << " files" << std::endl;
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,791 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Parallel aggregation of the output files of scenario runs.
+ *
+ * Walks the given directories (or takes the given files) and computes for
+ * every run the numbers of the Python parsers:
+ *
+ *   mean error       MeanError.py: mean of the "Mean error of" lines of
+ *                    the NS_LOG output (<prefix>log.txt or <prefix>.log),
+ *                    weighted by their weight, lines of weight 1 skipped
+ *   goodput,         FlowmonParser.py: TCP flows of the .flowmon file with
+ *   delivery and     more than one packet, averaged with the transmitted
+ *   retransmit ratio packets as weights
+ *   mean cwnd        CwndParser.py: mean of all values of the .cwnd file
+ *
+ * A run is identified by its directory and prefix (s1, s4-r3, ...). When
+ * it has no log or no .flowmon file, e.g. because it was aborted, the last
+ * complete block of its .snapshot file is used instead.
+ *
+ * Runs are grouped into scenarios by their directory and their prefix
+ * without the replication suffix (s4-r3 belongs to s4). For each scenario,
+ * the mean of every number over its runs is printed with the 95%
+ * confidence interval from Student's t distribution, taking the runs as
+ * independent. Traffic replications share the node movement, so their
+ * interval only covers the variation due to the flows.
+ *
+ * Files are memory mapped and parsed in one pass by --jobs threads, the
+ * largest first, so that a directory of many runs is read at the speed of
+ * the disk.
+ *
+ * Build and run:
+ *   g++ -O2 -std=c++11 -pthread -o rtt-aggregate rtt-aggregate.cc
+ *   ./rtt-aggregate results/
+ *
+ * Options:
+ *   --jobs=N  number of parsing threads, 0 (default) for one per CPU
+ *   --csv     print the runs and scenarios as CSV instead of tables
+**/
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+enum FileKind
+{
+  KIND_LOG,
+  KIND_FLOWMON,
+  KIND_CWND,
+  KIND_SNAPSHOT
+};
+
+// Sums of one file, or of one run once its files are merged
+struct Sums
+{
+  Sums ()
+    : errorNum (0), errorDen (0),
+      goodputSum (0), deliverySum (0), retransmitSum (0), txPacketSum (0),
+      cwndSum (0), cwndCount (0),
+      hasError (false), hasFlows (false)
+  {
+  }
+
+  double errorNum;
+  double errorDen;
+  double goodputSum;
+  double deliverySum;
+  double retransmitSum;
+  double txPacketSum;
+  double cwndSum;
+  uint64_t cwndCount;
+  bool hasError;
+  bool hasFlows;
+};
+
+struct InputFile
+{
+  std::string path;
+  std::string run;
+  FileKind kind;
+  off_t size;
+  Sums sums;
+  bool ok;
+};
+
+// Read-only memory mapping of a whole file
+class MappedFile
+{
+public:
+  MappedFile (const std::string &fileName)
+    : m_data (NULL),
+      m_size (0)
+  {
+    int fd = open (fileName.c_str (), O_RDONLY);
+    if (fd < 0)
+    {
+      perror (fileName.c_str ());
+      return;
+    }
+    struct stat st;
+    if (fstat (fd, &st) == 0 && st.st_size > 0)
+    {
+      void *map = mmap (NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (map != MAP_FAILED)
+      {
+        madvise (map, st.st_size, MADV_SEQUENTIAL);
+        m_data = (const char *) map;
+        m_size = st.st_size;
+      }
+      else
+      {
+        perror (fileName.c_str ());
+      }
+    }
+    close (fd);
+  }
+
+  ~MappedFile ()
+  {
+    if (m_data != NULL)
+    {
+      munmap ((void *) m_data, m_size);
+    }
+  }
+
+  const char *Begin () const
+  {
+    return m_data;
+  }
+
+  const char *End () const
+  {
+    return m_data + m_size;
+  }
+
+  bool IsEmpty () const
+  {
+    return m_data == NULL;
+  }
+
+private:
+  const char *m_data;
+  size_t m_size;
+};
+
+// Adds one flow as FlowmonParser.py does. Times are in seconds.
+static void
+AddFlow (Sums &sums, double txPackets, double rxPackets,
+         double firstTx, double lastTx, double firstRx, double lastRx)
+{
+  if (firstRx == lastRx || firstTx == lastTx)
+  {
+    return;
+  }
+  double rxRate = rxPackets / (lastRx - firstRx);
+  sums.txPacketSum += txPackets;
+  sums.retransmitSum += txPackets - rxPackets;
+  sums.deliverySum += rxPackets;
+  sums.goodputSum += rxRate * txPackets;
+  sums.hasFlows = true;
+}
+
+// Adds one estimator as MeanError.py does
+static void
+AddError (Sums &sums, double err, double weight)
+{
+  if (weight > 1 && std::isfinite (err))
+  {
+    sums.errorNum += err * weight;
+    sums.errorDen += weight;
+    sums.hasError = true;
+  }
+}
+
+static const char *
+Find (const char *begin, const char *end, const char *needle)
+{
+  const char *p = (const char *) memmem (begin, end - begin, needle, strlen (needle));
+  return p != NULL ? p : end;
+}
+
+// Value of the attribute name of the XML tag [tag, tagEnd), 0 if missing.
+// Times such as "+1.5e+09ns" are read as their number of nanoseconds.
+static double
+Attribute (const char *tag, const char *tagEnd, const char *name)
+{
+  char key[64];
+  snprintf (key, sizeof (key), " %s=\"", name);
+  const char *p = Find (tag, tagEnd, key);
+  if (p == tagEnd)
+  {
+    return 0;
+  }
+  return strtod (p + strlen (key), NULL);
+}
+
+static void
+ParseLog (const MappedFile &file, Sums &sums)
+{
+  static const char marker[] = "Mean error of ";
+  static const char weightMarker[] = " with a weight of ";
+  const char *p = file.Begin ();
+  const char *end = file.End ();
+  while ((p = Find (p, end, marker)) != end)
+  {
+    p += sizeof (marker) - 1;
+    const char *eol = (const char *) memchr (p, '\n', end - p);
+    if (eol == NULL)
+    {
+      eol = end;
+    }
+    const char *w = Find (p, eol, weightMarker);
+    if (w != eol && p < eol && (isdigit (*p) || *p == '.'))
+    {
+      AddError (sums, strtod (p, NULL), strtod (w + sizeof (weightMarker) - 1, NULL));
+    }
+    p = eol;
+  }
+}
+
+static void
+ParseFlowmon (const MappedFile &file, Sums &sums)
+{
+  struct Flow
+  {
+    Flow () : txPackets (0), rxPackets (0), firstTx (0), lastTx (0), firstRx (0), lastRx (0),
+              hasStats (false), tcp (false), packets (0) {}
+    double txPackets, rxPackets, firstTx, lastTx, firstRx, lastRx;
+    bool hasStats;
+    bool tcp;
+    double packets;
+  };
+  std::map<uint32_t, Flow> flows;
+
+  enum { OTHER, STATS, CLASSIFIER } section = OTHER;
+  Flow *classified = NULL;
+  const char *p = file.Begin ();
+  const char *end = file.End ();
+  while ((p = (const char *) memchr (p, '<', end - p)) != NULL)
+  {
+    const char *tagEnd = (const char *) memchr (p, '>', end - p);
+    if (tagEnd == NULL)
+    {
+      break;
+    }
+    const char *name = p + 1;
+    const char *nameEnd = name;
+    while (nameEnd < tagEnd && *nameEnd != ' ' && *nameEnd != '/')
+    {
+      nameEnd++;
+    }
+    std::string tag (name, nameEnd);
+    if (tag == "FlowStats" && nameEnd == tagEnd)
+    {
+      section = STATS;
+    }
+    else if (tag == "Ipv4FlowClassifier")
+    {
+      section = CLASSIFIER;
+    }
+    else if (tag == "Ipv6FlowClassifier" || tag == "FlowProbes")
+    {
+      section = OTHER;
+    }
+    else if (tag == "Flow" && section == STATS)
+    {
+      Flow &flow = flows[(uint32_t) Attribute (p, tagEnd, "flowId")];
+      flow.txPackets = Attribute (p, tagEnd, "txPackets");
+      flow.rxPackets = Attribute (p, tagEnd, "rxPackets");
+      flow.firstTx = Attribute (p, tagEnd, "timeFirstTxPacket") / 1e9;
+      flow.lastTx = Attribute (p, tagEnd, "timeLastTxPacket") / 1e9;
+      flow.firstRx = Attribute (p, tagEnd, "timeFirstRxPacket") / 1e9;
+      flow.lastRx = Attribute (p, tagEnd, "timeLastRxPacket") / 1e9;
+      flow.hasStats = true;
+    }
+    else if (tag == "Flow" && section == CLASSIFIER)
+    {
+      classified = &flows[(uint32_t) Attribute (p, tagEnd, "flowId")];
+      classified->tcp = Attribute (p, tagEnd, "protocol") == 6;
+    }
+    else if (tag == "Dscp" && classified != NULL)
+    {
+      // FlowmonParser.py only looks at the first Dscp entry of a flow
+      classified->packets = Attribute (p, tagEnd, "packets");
+      classified = NULL;
+    }
+    p = tagEnd + 1;
+  }
+
+  for (std::map<uint32_t, Flow>::const_iterator it = flows.begin (); it != flows.end (); it++)
+  {
+    const Flow &f = it->second;
+    if (f.hasStats && f.tcp && f.packets > 1)
+    {
+      AddFlow (sums, f.txPackets, f.rxPackets, f.firstTx, f.lastTx, f.firstRx, f.lastRx);
+    }
+  }
+}
+
+static void
+ParseCwnd (const MappedFile &file, Sums &sums)
+{
+  // One unsigned integer per line
+  uint64_t value = 0;
+  bool digits = false;
+  for (const char *p = file.Begin (); p < file.End (); p++)
+  {
+    if (*p >= '0' && *p <= '9')
+    {
+      value = value * 10 + (*p - '0');
+      digits = true;
+    }
+    else if (*p == '\n')
+    {
+      if (digits)
+      {
+        sums.cwndSum += value;
+        sums.cwndCount++;
+      }
+      value = 0;
+      digits = false;
+    }
+  }
+  if (digits)
+  {
+    sums.cwndSum += value;
+    sums.cwndCount++;
+  }
+}
+
+static void
+ParseSnapshot (const MappedFile &file, Sums &sums)
+{
+  // Last block that reached its "end" line
+  const char *blockBegin = NULL;
+  const char *lastBegin = NULL;
+  const char *lastEnd = NULL;
+  const char *end = file.End ();
+  for (const char *line = file.Begin (); line < end; )
+  {
+    const char *eol = (const char *) memchr (line, '\n', end - line);
+    if (eol == NULL)
+    {
+      break; // Cut by the crash
+    }
+    if (eol - line > 9 && memcmp (line, "snapshot ", 9) == 0)
+    {
+      blockBegin = eol + 1;
+    }
+    else if (eol - line == 3 && memcmp (line, "end", 3) == 0 && blockBegin != NULL)
+    {
+      lastBegin = blockBegin;
+      lastEnd = line;
+    }
+    line = eol + 1;
+  }
+  if (lastBegin == NULL)
+  {
+    return;
+  }
+
+  std::vector<std::string> fields;
+  for (const char *line = lastBegin; line < lastEnd; )
+  {
+    const char *eol = (const char *) memchr (line, '\n', lastEnd - line);
+    fields.clear ();
+    for (const char *p = line; p < eol; )
+    {
+      const char *space = std::find (p, eol, ' ');
+      fields.push_back (std::string (p, space));
+      p = space < eol ? space + 1 : eol;
+    }
+    line = eol + 1;
+
+    // flow <id> <protocol> <src> <src port> <dst> <dst port> <tx packets> <rx packets>
+    //      <tx bytes> <rx bytes> <lost packets> <first tx> <last tx> <first rx> <last rx>
+    if (fields.size () == 16 && fields[0] == "flow" && fields[2] == "6")
+    {
+      double txPackets = atof (fields[7].c_str ());
+      if (txPackets > 1)
+      {
+        AddFlow (sums, txPackets, atof (fields[8].c_str ()),
+                 atof (fields[12].c_str ()) / 1e9, atof (fields[13].c_str ()) / 1e9,
+                 atof (fields[14].c_str ()) / 1e9, atof (fields[15].c_str ()) / 1e9);
+      }
+    }
+    // estimator <type> <live|done> <mean error> <weight>, only the destroyed
+    // estimators log the lines MeanError.py reads
+    else if (fields.size () == 5 && fields[0] == "estimator" && fields[2] == "done")
+    {
+      AddError (sums, atof (fields[3].c_str ()), atof (fields[4].c_str ()));
+    }
+  }
+}
+
+static void
+ParseFile (InputFile &input)
+{
+  if (input.size == 0)
+  {
+    input.ok = true; // e.g. the .cwnd file of a run without flows
+    return;
+  }
+  MappedFile file (input.path);
+  input.ok = !file.IsEmpty ();
+  if (!input.ok)
+  {
+    return;
+  }
+  switch (input.kind)
+  {
+  case KIND_LOG:
+    ParseLog (file, input.sums);
+    break;
+  case KIND_FLOWMON:
+    ParseFlowmon (file, input.sums);
+    break;
+  case KIND_CWND:
+    ParseCwnd (file, input.sums);
+    break;
+  case KIND_SNAPSHOT:
+    ParseSnapshot (file, input.sums);
+    break;
+  }
+}
+
+static bool
+EndsWith (const std::string &s, const std::string &suffix)
+{
+  return s.size () > suffix.size () && s.compare (s.size () - suffix.size (), suffix.size (), suffix) == 0;
+}
+
+// Adds the file if it is an output file of a run
+static void
+AddFile (const std::string &path, off_t size, std::vector<InputFile> &files)
+{
+  static const struct
+  {
+    const char *suffix;
+    FileKind kind;
+  } suffixes[] = {
+    { "log.txt", KIND_LOG },
+    { ".log", KIND_LOG },
+    { ".flowmon", KIND_FLOWMON },
+    { ".cwnd", KIND_CWND },
+    { ".snapshot", KIND_SNAPSHOT },
+  };
+  for (size_t i = 0; i < sizeof (suffixes) / sizeof (suffixes[0]); i++)
+  {
+    if (EndsWith (path, suffixes[i].suffix))
+    {
+      InputFile file;
+      file.path = path;
+      file.run = path.substr (0, path.size () - strlen (suffixes[i].suffix));
+      file.kind = suffixes[i].kind;
+      file.size = size;
+      file.ok = false;
+      files.push_back (file);
+      return;
+    }
+  }
+}
+
+static void
+Walk (const std::string &path, std::vector<InputFile> &files)
+{
+  struct stat st;
+  if (lstat (path.c_str (), &st) < 0)
+  {
+    perror (path.c_str ());
+    return;
+  }
+  if (S_ISREG (st.st_mode))
+  {
+    AddFile (path, st.st_size, files);
+    return;
+  }
+  if (!S_ISDIR (st.st_mode))
+  {
+    return;
+  }
+  DIR *dir = opendir (path.c_str ());
+  if (dir == NULL)
+  {
+    perror (path.c_str ());
+    return;
+  }
+  std::vector<std::string> entries;
+  struct dirent *entry;
+  while ((entry = readdir (dir)) != NULL)
+  {
+    if (strcmp (entry->d_name, ".") != 0 && strcmp (entry->d_name, "..") != 0)
+    {
+      entries.push_back (entry->d_name);
+    }
+  }
+  closedir (dir);
+  std::sort (entries.begin (), entries.end ());
+  std::string base = path[path.size () - 1] == '/' ? path : path + "/";
+  for (size_t i = 0; i < entries.size (); i++)
+  {
+    Walk (base + entries[i], files);
+  }
+}
+
+// The scenario of a run is its prefix without the replication suffix
+static std::string
+ScenarioOf (const std::string &run)
+{
+  size_t slash = run.rfind ('/');
+  size_t r = run.rfind ("-r");
+  if (r != std::string::npos && (slash == std::string::npos || r > slash)
+      && r + 2 < run.size () && run.find_first_not_of ("0123456789", r + 2) == std::string::npos)
+  {
+    return run.substr (0, r);
+  }
+  return run;
+}
+
+// Two-sided 95% quantile of Student's t distribution
+static double
+StudentT95 (size_t df)
+{
+  static const double table[] = {
+    12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+    2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+    2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+  };
+  if (df == 0)
+  {
+    return NAN;
+  }
+  if (df <= 30)
+  {
+    return table[df - 1];
+  }
+  return df <= 60 ? 2.000 : (df <= 120 ? 1.980 : 1.960);
+}
+
+// Mean over the runs of a scenario with its 95% confidence interval
+struct Estimate
+{
+  Estimate () : n (0), sum (0), sumSq (0) {}
+
+  void Add (double x)
+  {
+    n++;
+    sum += x;
+    sumSq += x * x;
+  }
+
+  double Mean () const
+  {
+    return sum / n;
+  }
+
+  double HalfWidth () const
+  {
+    if (n < 2)
+    {
+      return NAN;
+    }
+    double var = (sumSq - sum * sum / n) / (n - 1);
+    return StudentT95 (n - 1) * std::sqrt (std::max (var, 0.0) / n);
+  }
+
+  size_t n;
+  double sum;
+  double sumSq;
+};
+
+static const int N_METRICS = 5;
+static const char *const g_metricNames[N_METRICS] = {
+  "Mean error (ms)", "Goodput (p/s)", "Delivery ratio", "Retransmit ratio", "Mean cwnd (B)"
+};
+
+// Fills values with the metrics of a run, NAN where it has no data
+static void
+Metrics (const Sums &s, double values[N_METRICS])
+{
+  values[0] = s.hasError ? s.errorNum / s.errorDen : NAN;
+  values[1] = s.hasFlows ? s.goodputSum / s.txPacketSum : NAN;
+  values[2] = s.hasFlows ? s.deliverySum / s.txPacketSum : NAN;
+  values[3] = s.hasFlows ? s.retransmitSum / s.txPacketSum : NAN;
+  values[4] = s.cwndCount > 0 ? s.cwndSum / s.cwndCount : NAN;
+}
+
+int
+main (int argc, char *argv[])
+{
+  unsigned int jobs = 0;
+  bool csv = false;
+  std::vector<std::string> paths;
+  for (int i = 1; i < argc; i++)
+  {
+    std::string arg = argv[i];
+    if (arg.compare (0, 7, "--jobs=") == 0)
+    {
+      jobs = atoi (arg.c_str () + 7);
+    }
+    else if (arg == "--csv")
+    {
+      csv = true;
+    }
+    else if (arg.size () > 1 && arg[0] == '-')
+    {
+      std::cerr << "Usage: " << argv[0] << " [--jobs=N] [--csv] directory|file..." << std::endl;
+      return 1;
+    }
+    else
+    {
+      paths.push_back (arg);
+    }
+  }
+  if (paths.empty ())
+  {
+    std::cerr << "Usage: " << argv[0] << " [--jobs=N] [--csv] directory|file..." << std::endl;
+    return 1;
+  }
+
+  std::vector<InputFile> files;
+  for (size_t i = 0; i < paths.size (); i++)
+  {
+    Walk (paths[i], files);
+  }
+
+  // Largest files first, so that the threads finish at about the same time
+  std::vector<InputFile *> order;
+  for (size_t i = 0; i < files.size (); i++)
+  {
+    order.push_back (&files[i]);
+  }
+  std::sort (order.begin (), order.end (),
+             [] (const InputFile *a, const InputFile *b) { return a->size > b->size; });
+
+  if (jobs == 0)
+  {
+    jobs = std::max (1u, std::thread::hardware_concurrency ());
+  }
+  jobs = std::min<size_t> (jobs, std::max<size_t> (order.size (), 1));
+  std::atomic<size_t> next (0);
+  std::vector<std::thread> threads;
+  for (unsigned int t = 0; t < jobs; t++)
+  {
+    threads.push_back (std::thread ([&order, &next] () {
+      size_t i;
+      while ((i = next++) < order.size ())
+      {
+        ParseFile (*order[i]);
+      }
+    }));
+  }
+  for (size_t t = 0; t < threads.size (); t++)
+  {
+    threads[t].join ();
+  }
+
+  // Merge the files of each run, the snapshot only filling in what the log
+  // and the .flowmon file do not give
+  std::map<std::string, Sums> runs;
+  std::map<std::string, Sums> snapshots;
+  for (size_t i = 0; i < files.size (); i++)
+  {
+    const InputFile &f = files[i];
+    if (!f.ok)
+    {
+      continue;
+    }
+    Sums &run = f.kind == KIND_SNAPSHOT ? snapshots[f.run] : runs[f.run];
+    if (f.sums.hasError)
+    {
+      run.errorNum += f.sums.errorNum;
+      run.errorDen += f.sums.errorDen;
+      run.hasError = true;
+    }
+    if (f.sums.hasFlows)
+    {
+      run.goodputSum += f.sums.goodputSum;
+      run.deliverySum += f.sums.deliverySum;
+      run.retransmitSum += f.sums.retransmitSum;
+      run.txPacketSum += f.sums.txPacketSum;
+      run.hasFlows = true;
+    }
+    run.cwndSum += f.sums.cwndSum;
+    run.cwndCount += f.sums.cwndCount;
+  }
+  for (std::map<std::string, Sums>::const_iterator it = snapshots.begin (); it != snapshots.end (); it++)
+  {
+    Sums &run = runs[it->first];
+    if (!run.hasError && it->second.hasError)
+    {
+      run.errorNum = it->second.errorNum;
+      run.errorDen = it->second.errorDen;
+      run.hasError = true;
+    }
+    if (!run.hasFlows && it->second.hasFlows)
+    {
+      run.goodputSum = it->second.goodputSum;
+      run.deliverySum = it->second.deliverySum;
+      run.retransmitSum = it->second.retransmitSum;
+      run.txPacketSum = it->second.txPacketSum;
+      run.hasFlows = true;
+    }
+  }
+
+  std::map<std::string, std::vector<Estimate> > scenarios;
+  if (csv)
+  {
+    std::cout << "run,mean_error_ms,error_weight,goodput_pps,delivery_ratio,retransmit_ratio,tx_packets,mean_cwnd_bytes,cwnd_samples\n";
+  }
+  else
+  {
+    printf ("%-32s %10s %8s %10s %9s %10s %9s %10s\n", "Run", "Error (ms)", "Weight",
+            "Goodput", "Delivery", "Retransmit", "Packets", "Cwnd (B)");
+  }
+  for (std::map<std::string, Sums>::const_iterator it = runs.begin (); it != runs.end (); it++)
+  {
+    double values[N_METRICS];
+    Metrics (it->second, values);
+    std::vector<Estimate> &estimates = scenarios[ScenarioOf (it->first)];
+    estimates.resize (N_METRICS);
+    for (int m = 0; m < N_METRICS; m++)
+    {
+      if (!std::isnan (values[m]))
+      {
+        estimates[m].Add (values[m]);
+      }
+    }
+    if (csv)
+    {
+      printf ("%s,%g,%g,%g,%g,%g,%g,%g,%llu\n", it->first.c_str (), values[0], it->second.errorDen,
+              values[1], values[2], values[3], it->second.txPacketSum, values[4],
+              (unsigned long long) it->second.cwndCount);
+    }
+    else
+    {
+      printf ("%-32s %10.3f %8.0f %10.3f %9.4f %10.4f %9.0f %10.1f\n", it->first.c_str (), values[0],
+              it->second.errorDen, values[1], values[2], values[3], it->second.txPacketSum, values[4]);
+    }
+  }
+
+  if (csv)
+  {
+    std::cout << "\nscenario,metric,runs,mean,ci95\n";
+  }
+  for (std::map<std::string, std::vector<Estimate> >::const_iterator it = scenarios.begin (); it != scenarios.end (); it++)
+  {
+    if (!csv)
+    {
+      printf ("\nScenario %s, mean over the runs with its 95%% confidence interval:\n", it->first.c_str ());
+    }
+    for (int m = 0; m < N_METRICS; m++)
+    {
+      const Estimate &e = it->second[m];
+      if (e.n == 0)
+      {
+        continue;
+      }
+      if (csv)
+      {
+        printf ("%s,%s,%zu,%g,%g\n", it->first.c_str (), g_metricNames[m], e.n, e.Mean (), e.HalfWidth ());
+      }
+      else
+      {
+        printf ("  %-18s %12.4f +- %-10.4f (%zu runs)\n", g_metricNames[m], e.Mean (), e.HalfWidth (), e.n);
+      }
+    }
+  }
+
+  size_t failed = 0;
+  for (size_t i = 0; i < files.size (); i++)
+  {
+    failed += files[i].ok ? 0 : 1;
+  }
+  std::cerr << "Aggregated " << files.size () - failed << " files of " << runs.size () << " runs in "
+            << scenarios.size () << " scenarios with " << jobs << " threads" << std::endl;
+  return failed ? 1 : 0;
+}
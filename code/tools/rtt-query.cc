@@ -0,0 +1,503 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Queries on the columnar results store of the scenarios.
+ *
+ * The scenarios append one row per run to a store directory (see
+ * ns3scripts/rtt-results.h for its layout). This program selects the rows
+ * matching --where, groups them by the --group columns and prints, for
+ * every group, the number of runs and the mean of every requested metric
+ * over those runs with its 95% confidence interval (Student's t). Metrics
+ * of a run that are NAN (no data) are left out.
+ *
+ * Only the index and the columns that appear in the query are read, each
+ * memory mapped as a flat array; string columns are compared through
+ * their dictionary codes. A query over thousands of runs therefore reads a
+ * few pages per column.
+ *
+ * Build and run:
+ *   g++ -O2 -std=c++11 -o rtt-query rtt-query.cc
+ *   ./rtt-query rtt-results --where=flows=68 --group=estimator goodput mean_error
+ *
+ * Options:
+ *   --where=COLUMN=VALUE  only the rows where COLUMN equals VALUE (repeatable)
+ *   --group=COLUMN,...    one line per distinct combination of these columns
+ *   --csv                 print CSV instead of a table
+ *   --list                print the columns and the number of rows
+ *
+ * Without metrics, mean_error, goodput, delivery_ratio, retransmit_ratio and
+ * mean_cwnd are printed.
+**/
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Read-only memory mapping of a whole file
+class MappedFile
+{
+public:
+  MappedFile ()
+    : m_data (NULL),
+      m_size (0)
+  {
+  }
+
+  ~MappedFile ()
+  {
+    if (m_data != NULL)
+    {
+      munmap ((void *) m_data, m_size);
+    }
+  }
+
+  bool Open (const std::string &fileName)
+  {
+    int fd = open (fileName.c_str (), O_RDONLY);
+    if (fd < 0)
+    {
+      perror (fileName.c_str ());
+      return false;
+    }
+    struct stat st;
+    bool ok = fstat (fd, &st) == 0;
+    if (ok && st.st_size > 0)
+    {
+      void *map = mmap (NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      ok = map != MAP_FAILED;
+      if (ok)
+      {
+        m_data = (const char *) map;
+        m_size = st.st_size;
+      }
+    }
+    if (!ok)
+    {
+      perror (fileName.c_str ());
+    }
+    close (fd);
+    return ok;
+  }
+
+  const char *Data () const
+  {
+    return m_data;
+  }
+
+  size_t Size () const
+  {
+    return m_size;
+  }
+
+private:
+  MappedFile (const MappedFile &);
+  MappedFile &operator= (const MappedFile &);
+
+  const char *m_data;
+  size_t m_size;
+};
+
+class Store
+{
+public:
+  // Reads the index of the store in directory dir
+  bool Open (const std::string &dir)
+  {
+    m_dir = dir;
+    std::ifstream index ((dir + "/index").c_str ());
+    std::string magic, word, name, type;
+    int version = 0;
+    if (!(index >> magic >> version >> word >> m_rows) || magic != "RTTRESULTS" || version != 1)
+    {
+      std::cerr << dir << ": not a results store" << std::endl;
+      return false;
+    }
+    while (index >> word >> name >> type)
+    {
+      m_types[name] = type[0];
+      m_names.push_back (name);
+    }
+    return true;
+  }
+
+  uint64_t GetRows () const
+  {
+    return m_rows;
+  }
+
+  const std::vector<std::string> &GetNames () const
+  {
+    return m_names;
+  }
+
+  // Type of the column (d, i or s), 0 if there is no such column
+  char GetType (const std::string &name) const
+  {
+    std::map<std::string, char>::const_iterator it = m_types.find (name);
+    return it == m_types.end () ? 0 : it->second;
+  }
+
+  // Maps the column, once
+  const char *GetColumn (const std::string &name)
+  {
+    MappedFile &file = m_columns[name];
+    if (file.Data () == NULL)
+    {
+      size_t width = GetType (name) == 's' ? 4 : 8;
+      if (!file.Open (m_dir + "/" + name + ".col") || file.Size () < m_rows * width)
+      {
+        std::cerr << name << ": column shorter than the index" << std::endl;
+        exit (1);
+      }
+    }
+    return file.Data ();
+  }
+
+  // Value of the column at row as a number, NAN for string columns
+  double GetNumber (const std::string &name, uint64_t row)
+  {
+    const char *data = GetColumn (name);
+    if (GetType (name) == 'd')
+    {
+      double v;
+      memcpy (&v, data + row * 8, 8);
+      return v;
+    }
+    if (GetType (name) == 'i')
+    {
+      int64_t v;
+      memcpy (&v, data + row * 8, 8);
+      return v;
+    }
+    return NAN;
+  }
+
+  // Dictionary code of the string column at row
+  uint32_t GetCode (const std::string &name, uint64_t row)
+  {
+    uint32_t code;
+    memcpy (&code, GetColumn (name) + row * 4, 4);
+    return code;
+  }
+
+  // Values of a string column, indexed by code
+  const std::vector<std::string> &GetDictionary (const std::string &name)
+  {
+    std::map<std::string, std::vector<std::string> >::iterator it = m_dictionaries.find (name);
+    if (it == m_dictionaries.end ())
+    {
+      std::vector<std::string> &values = m_dictionaries[name];
+      std::ifstream in ((m_dir + "/" + name + ".dict").c_str ());
+      std::string line;
+      while (std::getline (in, line))
+      {
+        values.push_back (line);
+      }
+      return values;
+    }
+    return it->second;
+  }
+
+  // Value of any column at row as text
+  std::string GetText (const std::string &name, uint64_t row)
+  {
+    if (GetType (name) == 's')
+    {
+      const std::vector<std::string> &values = GetDictionary (name);
+      uint32_t code = GetCode (name, row);
+      return code < values.size () ? values[code] : "?";
+    }
+    std::ostringstream oss;
+    oss << GetNumber (name, row);
+    return oss.str ();
+  }
+
+private:
+  std::string m_dir;
+  uint64_t m_rows;
+  std::vector<std::string> m_names;
+  std::map<std::string, char> m_types;
+  std::map<std::string, MappedFile> m_columns;
+  std::map<std::string, std::vector<std::string> > m_dictionaries;
+};
+
+// Two-sided 95% quantile of Student's t distribution
+static double
+StudentT95 (size_t df)
+{
+  static const double table[] = {
+    12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+    2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+    2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+  };
+  if (df == 0)
+  {
+    return NAN;
+  }
+  if (df <= 30)
+  {
+    return table[df - 1];
+  }
+  return df <= 60 ? 2.000 : (df <= 120 ? 1.980 : 1.960);
+}
+
+// Mean over the runs of a group with its 95% confidence interval
+struct Estimate
+{
+  Estimate () : n (0), sum (0), sumSq (0) {}
+
+  void Add (double x)
+  {
+    n++;
+    sum += x;
+    sumSq += x * x;
+  }
+
+  double Mean () const
+  {
+    return n > 0 ? sum / n : NAN;
+  }
+
+  double HalfWidth () const
+  {
+    if (n < 2)
+    {
+      return NAN;
+    }
+    double var = (sumSq - sum * sum / n) / (n - 1);
+    return StudentT95 (n - 1) * std::sqrt (std::max (var, 0.0) / n);
+  }
+
+  size_t n;
+  double sum;
+  double sumSq;
+};
+
+struct Group
+{
+  Group () : runs (0) {}
+
+  size_t runs;
+  std::vector<Estimate> metrics;
+};
+
+static void
+Usage (const char *name)
+{
+  std::cerr << "Usage: " << name << " store [--where=COLUMN=VALUE]... [--group=COLUMN,...] [--csv] [--list] [metric...]"
+            << std::endl;
+  exit (1);
+}
+
+int
+main (int argc, char *argv[])
+{
+  if (argc < 2 || argv[1][0] == '-')
+  {
+    Usage (argv[0]);
+  }
+  std::vector<std::pair<std::string, std::string> > where;
+  std::vector<std::string> group;
+  std::vector<std::string> metrics;
+  bool csv = false;
+  bool list = false;
+  for (int i = 2; i < argc; i++)
+  {
+    std::string arg = argv[i];
+    if (arg.compare (0, 8, "--where=") == 0 && arg.find ('=', 8) != std::string::npos)
+    {
+      size_t eq = arg.find ('=', 8);
+      where.push_back (std::make_pair (arg.substr (8, eq - 8), arg.substr (eq + 1)));
+    }
+    else if (arg.compare (0, 8, "--group=") == 0)
+    {
+      std::istringstream iss (arg.substr (8));
+      std::string column;
+      while (std::getline (iss, column, ','))
+      {
+        group.push_back (column);
+      }
+    }
+    else if (arg == "--csv")
+    {
+      csv = true;
+    }
+    else if (arg == "--list")
+    {
+      list = true;
+    }
+    else if (arg[0] == '-')
+    {
+      Usage (argv[0]);
+    }
+    else
+    {
+      metrics.push_back (arg);
+    }
+  }
+  if (metrics.empty ())
+  {
+    const char *defaults[] = { "mean_error", "goodput", "delivery_ratio", "retransmit_ratio", "mean_cwnd" };
+    metrics.assign (defaults, defaults + 5);
+  }
+
+  Store store;
+  if (!store.Open (argv[1]))
+  {
+    return 1;
+  }
+
+  if (list)
+  {
+    std::cout << store.GetRows () << " rows" << std::endl;
+    for (size_t i = 0; i < store.GetNames ().size (); i++)
+    {
+      const std::string &name = store.GetNames ()[i];
+      std::cout << name << " " << store.GetType (name);
+      if (store.GetType (name) == 's')
+      {
+        std::cout << " (" << store.GetDictionary (name).size () << " distinct values)";
+      }
+      std::cout << std::endl;
+    }
+    return 0;
+  }
+
+  for (size_t i = 0; i < where.size (); i++)
+  {
+    if (store.GetType (where[i].first) == 0)
+    {
+      std::cerr << where[i].first << ": no such column" << std::endl;
+      return 1;
+    }
+  }
+  for (size_t i = 0; i < group.size (); i++)
+  {
+    if (store.GetType (group[i]) == 0)
+    {
+      std::cerr << group[i] << ": no such column" << std::endl;
+      return 1;
+    }
+  }
+  for (size_t i = 0; i < metrics.size (); i++)
+  {
+    char type = store.GetType (metrics[i]);
+    if (type != 'd' && type != 'i')
+    {
+      std::cerr << metrics[i] << ": no such numeric column" << std::endl;
+      return 1;
+    }
+  }
+
+  // Rows matching every --where, one column at a time
+  std::vector<uint64_t> rows;
+  for (uint64_t r = 0; r < store.GetRows (); r++)
+  {
+    rows.push_back (r);
+  }
+  for (size_t i = 0; i < where.size (); i++)
+  {
+    const std::string &column = where[i].first;
+    std::vector<uint64_t> kept;
+    if (store.GetType (column) == 's')
+    {
+      const std::vector<std::string> &values = store.GetDictionary (column);
+      std::vector<std::string>::const_iterator it = std::find (values.begin (), values.end (), where[i].second);
+      uint32_t code = it - values.begin ();
+      for (size_t j = 0; it != values.end () && j < rows.size (); j++)
+      {
+        if (store.GetCode (column, rows[j]) == code)
+        {
+          kept.push_back (rows[j]);
+        }
+      }
+    }
+    else
+    {
+      double value = atof (where[i].second.c_str ());
+      for (size_t j = 0; j < rows.size (); j++)
+      {
+        if (store.GetNumber (column, rows[j]) == value)
+        {
+          kept.push_back (rows[j]);
+        }
+      }
+    }
+    rows.swap (kept);
+  }
+
+  std::map<std::vector<std::string>, Group> groups;
+  for (size_t j = 0; j < rows.size (); j++)
+  {
+    std::vector<std::string> key;
+    for (size_t i = 0; i < group.size (); i++)
+    {
+      key.push_back (store.GetText (group[i], rows[j]));
+    }
+    Group &g = groups[key];
+    g.metrics.resize (metrics.size ());
+    g.runs++;
+    for (size_t i = 0; i < metrics.size (); i++)
+    {
+      double v = store.GetNumber (metrics[i], rows[j]);
+      if (!std::isnan (v))
+      {
+        g.metrics[i].Add (v);
+      }
+    }
+  }
+
+  // Header
+  for (size_t i = 0; i < group.size (); i++)
+  {
+    printf (csv ? "%s," : "%-24s ", group[i].c_str ());
+  }
+  printf (csv ? "runs" : "%6s", "Runs");
+  for (size_t i = 0; i < metrics.size (); i++)
+  {
+    if (csv)
+    {
+      printf (",%s,%s_ci95", metrics[i].c_str (), metrics[i].c_str ());
+    }
+    else
+    {
+      printf (" %26s", metrics[i].c_str ());
+    }
+  }
+  printf ("\n");
+
+  for (std::map<std::vector<std::string>, Group>::const_iterator it = groups.begin (); it != groups.end (); it++)
+  {
+    for (size_t i = 0; i < it->first.size (); i++)
+    {
+      printf (csv ? "%s," : "%-24s ", it->first[i].c_str ());
+    }
+    printf (csv ? "%zu" : "%6zu", it->second.runs);
+    for (size_t i = 0; i < metrics.size (); i++)
+    {
+      const Estimate &e = it->second.metrics[i];
+      if (csv)
+      {
+        printf (",%g,%g", e.Mean (), e.HalfWidth ());
+      }
+      else
+      {
+        printf (" %12.4f +- %-10.4f", e.Mean (), e.HalfWidth ());
+      }
+    }
+    printf ("\n");
+  }
+  return 0;
+}